@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <benchmark/benchmark.h>
+
+#include "CssParser.h"
+
+using namespace cssparser;
+
+static const std::filesystem::path themePath = std::filesystem::path(BENCHMARK_DATA_DIR) / "theme.css";
+
+static std::string readFile(const std::filesystem::path &path)
+{
+    std::ifstream file(path);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+// The @property rules of the theme, so synthetic sheets use the same
+// definitions.
+static std::string definitions()
+{
+    const auto theme = readFile(themePath);
+    return theme.substr(0, theme.find(":root"));
+}
+
+// About count rules, generated the same way as the Rust benchmarks do.
+static std::string syntheticSheet(std::size_t count)
+{
+    std::ostringstream stream;
+    stream << definitions();
+
+    for (std::size_t index = 0; index < count / 6; ++index) {
+        stream << ".widget-" << index << ",\n";
+        stream << "#item-" << index << " > label,\n";
+        stream << "button.variant-" << index << "[role=\"tab\"] {\n";
+        stream << "    width: " << index % 200 << "px;\n";
+        stream << "    padding: 2px 4px 2px 4px;\n";
+        stream << "    color: rgba(" << index % 256 << ", 0, 0, 1);\n";
+        stream << "    border: solid 1px rgba(0, 0, 0, 0.5);\n";
+        stream << "\n";
+        stream << "    &:hovered {\n";
+        stream << "        background-color: modify-color(#202020 add #101010);\n";
+        stream << "    }\n";
+        stream << "}\n";
+    }
+
+    return stream.str();
+}
+
+class CountingVisitor : public RuleVisitor
+{
+public:
+    void visitRule(const RuleView &rule) override
+    {
+        count += rule.propertyCount();
+    }
+
+    std::size_t count = 0;
+};
+
+static void parseTheme(benchmark::State &state)
+{
+    for (auto _ : state) {
+        StyleSheet sheet(themePath, PropertyRegistry());
+        sheet.parse();
+        benchmark::DoNotOptimize(sheet.ruleCount());
+    }
+}
+BENCHMARK(parseTheme);
+
+// parseString() only converts errors, rules are converted to C++ when they
+// are first accessed. Compare parsing with and without accessing them to see
+// the cost of converting.
+static void parseSynthetic(benchmark::State &state)
+{
+    const auto source = syntheticSheet(state.range(0));
+    for (auto _ : state) {
+        StyleSheet sheet(std::filesystem::path{}, PropertyRegistry());
+        sheet.parseString(source);
+        benchmark::DoNotOptimize(sheet.ruleCount());
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(parseSynthetic)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void parseSyntheticRules(benchmark::State &state)
+{
+    const auto source = syntheticSheet(state.range(0));
+    for (auto _ : state) {
+        StyleSheet sheet(std::filesystem::path{}, PropertyRegistry());
+        sheet.parseString(source);
+        benchmark::DoNotOptimize(sheet.rules().data());
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(parseSyntheticRules)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void parseSyntheticVisitor(benchmark::State &state)
+{
+    const auto source = syntheticSheet(state.range(0));
+    for (auto _ : state) {
+        CountingVisitor visitor;
+        StyleSheet sheet(std::filesystem::path{}, PropertyRegistry());
+        sheet.parseString(source, visitor);
+        benchmark::DoNotOptimize(visitor.count);
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(parseSyntheticVisitor)->Arg(100)->Arg(1000)->Arg(10000);
+
+// The cost of converting rules that were already parsed, separate from
+// parsing them. A new StyleSheet is needed for every iteration as converted
+// rules are kept.
+static void convertRules(benchmark::State &state)
+{
+    const auto source = syntheticSheet(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        StyleSheet sheet(std::filesystem::path{}, PropertyRegistry());
+        sheet.parseString(source);
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(sheet.rules().data());
+        benchmark::DoNotOptimize(sheet.cascadeOrder().data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(convertRules)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void ruleViews(benchmark::State &state)
+{
+    const auto source = syntheticSheet(state.range(0));
+    StyleSheet sheet(std::filesystem::path{}, PropertyRegistry());
+    sheet.parseString(source);
+
+    for (auto _ : state) {
+        auto views = sheet.ruleViews();
+        benchmark::DoNotOptimize(views.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(ruleViews)->Arg(100)->Arg(1000)->Arg(10000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#include "Atom.h"
+
+#include "cxx-rust-cssparser-impl/src/ffi.rs.h"
+
+using namespace cssparser;
+
+Atom::Atom(std::string_view name)
+    : Atom(fromId(rust::intern_atom(::rust::Str(name.data(), name.size()))))
+{
+}
+
+std::optional<Atom> Atom::lookup(std::string_view name)
+{
+    uint32_t id = 0;
+    if (!rust::lookup_atom(::rust::Str(name.data(), name.size()), id)) {
+        return std::nullopt;
+    }
+
+    return fromId(id);
+}
+
+Atom Atom::fromId(uint32_t id)
+{
+    const auto name = rust::atom_str(id);
+
+    Atom result;
+    result.m_id = id;
+    result.m_name = std::string_view(name.data(), name.size());
+    return result;
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+
+#include "cssparser_export.h"
+
+namespace cssparser
+{
+
+/*!
+ * \class cssparser::Atom
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief An interned string.
+ *
+ * Names like property names, classes and ids are stored only once, in a
+ * table shared by the entire process. An Atom refers to an entry in that
+ * table, so comparing and hashing Atoms only compares and hashes an integer.
+ *
+ * Entries are never removed from the table, the string returned by name()
+ * remains valid for the lifetime of the process.
+ */
+class CSSPARSER_EXPORT Atom
+{
+public:
+    /*!
+     * Constructs an Atom for the empty string.
+     */
+    Atom() = default;
+    /*!
+     * Constructs an Atom for \a name, adding it to the table if needed.
+     */
+    explicit Atom(std::string_view name);
+
+    /*!
+     * Returns the index of this Atom in the table.
+     */
+    inline uint32_t id() const
+    {
+        return m_id;
+    }
+    /*!
+     * Returns the string this Atom refers to.
+     */
+    inline std::string_view name() const
+    {
+        return m_name;
+    }
+    /*!
+     * Returns whether this Atom refers to the empty string.
+     */
+    inline bool isEmpty() const
+    {
+        return m_id == 0;
+    }
+
+    inline bool operator==(const Atom &other) const
+    {
+        return m_id == other.m_id;
+    }
+
+    /*!
+     * Returns the Atom for \a name if it exists, without adding it to the
+     * table.
+     *
+     * As no Atom can be equal to a string that was never interned, this can
+     * be used to avoid growing the table when looking something up.
+     */
+    static std::optional<Atom> lookup(std::string_view name);
+
+    // Internal. Returns the Atom with index \a id.
+    static Atom fromId(uint32_t id);
+
+private:
+    uint32_t m_id = 0;
+    std::string_view m_name;
+};
+
+}
+
+template<>
+struct std::hash<cssparser::Atom> {
+    std::size_t operator()(const cssparser::Atom &atom) const noexcept
+    {
+        return std::hash<uint32_t>{}(atom.id());
+    }
+};
@@ -222,6 +222,102 @@ Color::Color()
 {
 }
 
+std::optional<RgbaData> Color::resolve() const
+{
+    switch (m_type) {
+    case Type::Rgba:
+        return std::get<RgbaData>(m_data);
+    case Type::Modified:
+        return m_resolved;
+    default:
+        return std::nullopt;
+    }
+}
+
+inline rust::Rgba toRust(const RgbaData &data)
+{
+    return rust::Rgba{data.r(), data.g(), data.b(), data.a()};
+}
+
+inline rust::ColorOperationType toRust(ModifiedColorData::Operation operation)
+{
+    switch (operation) {
+    case ModifiedColorData::Operation::Add:
+        return rust::ColorOperationType::Add;
+    case ModifiedColorData::Operation::Subtract:
+        return rust::ColorOperationType::Subtract;
+    case ModifiedColorData::Operation::Multiply:
+        return rust::ColorOperationType::Multiply;
+    case ModifiedColorData::Operation::Mix:
+        return rust::ColorOperationType::Mix;
+    default:
+        return rust::ColorOperationType::Set;
+    }
+}
+
+inline int16_t toRust(std::optional<uint8_t> value)
+{
+    return value.has_value() ? int16_t(value.value()) : int16_t(-1);
+}
+
+std::optional<RgbaData> Color::resolve(const std::function<std::optional<RgbaData>(const CustomColorData &)> &customColor) const
+{
+    if (m_type == Type::Custom) {
+        return customColor(std::get<CustomColorData>(m_data));
+    }
+
+    if (m_type != Type::Modified || m_resolved.has_value()) {
+        return resolve();
+    }
+
+    const auto &data = std::get<ModifiedColorData>(m_data);
+    const auto color = data.color()->resolve(customColor);
+    if (!color) {
+        return std::nullopt;
+    }
+
+    if (data.operation() == ModifiedColorData::Operation::Unknown) {
+        return std::nullopt;
+    }
+
+    const auto operation = toRust(data.operation());
+    auto other = RgbaData{};
+    auto amount = 0.0f;
+    auto set = rust::SetColorOperationValues{-1, -1, -1, -1};
+
+    switch (data.operation()) {
+    case ModifiedColorData::Operation::Add:
+    case ModifiedColorData::Operation::Subtract:
+    case ModifiedColorData::Operation::Multiply: {
+        const auto result = data.get<std::shared_ptr<Color>>()->resolve(customColor);
+        if (!result) {
+            return std::nullopt;
+        }
+        other = result.value();
+        break;
+    }
+    case ModifiedColorData::Operation::Mix: {
+        const auto mix = data.get<MixOperationData>();
+        const auto result = mix.other()->resolve(customColor);
+        if (!result) {
+            return std::nullopt;
+        }
+        other = result.value();
+        amount = mix.amount();
+        break;
+    }
+    case ModifiedColorData::Operation::Set: {
+        const auto values = data.get<SetOperationData>();
+        set = rust::SetColorOperationValues{toRust(values.r()), toRust(values.g()), toRust(values.b()), toRust(values.a())};
+        break;
+    }
+    case ModifiedColorData::Operation::Unknown:
+        break;
+    }
+
+    return RgbaData::fromRust(rust::apply_color_operation(toRust(color.value()), operation, toRust(other), amount, set));
+}
+
 std::string Color::toString() const
 {
     switch (m_type) {
@@ -255,6 +351,8 @@ inline Color::Type convertType(rust::ColorType type)
     return Color::Type::Empty;
 }
 
+ColorProvider::~ColorProvider() = default;
+
 Color Color::fromRust(const ::rust::cxxbridge1::Box<rust::Color> &color)
 {
     auto result = Color{};
@@ -270,10 +368,15 @@ Color Color::fromRust(const ::rust::cxxbridge1::Box<rust::Color> &color)
     case rust::ColorType::Custom:
         result.m_data = CustomColorData::fromRust(color->to_custom());
         break;
-    case rust::ColorType::Modified:
+    case rust::ColorType::Modified: {
         result.m_data = ModifiedColorData::fromRust(color->to_modified());
+        auto rgba = rust::Rgba{};
+        if (color->resolve_rgba(rgba)) {
+            result.m_resolved = RgbaData::fromRust(rgba);
+        }
         break;
     }
+    }
 
     return result;
 }
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -281,6 +282,30 @@ public:
     {
         return std::get<T>(m_data);
     }
+    /*!
+     * Returns this color as a single RGBA value.
+     *
+     * For a Modified color, this is the result of its operations. They are
+     * evaluated once, when the color is converted from a StyleSheet. Add and
+     * Subtract change red, green and blue, saturating at the limits of a
+     * channel, and keep the alpha of the modified color. Multiply and Mix
+     * apply to all four channels, the amount of Mix is clamped to 0 to 1.
+     *
+     * Returns std::nullopt if the color is Empty, Custom or depends on a
+     * Custom color, as those can only be resolved by whatever provides the
+     * custom color.
+     */
+    std::optional<RgbaData> resolve() const;
+    /*!
+     * Returns this color as a single RGBA value, using \a customColor to
+     * look up the value of custom colors.
+     *
+     * This behaves like resolve(), except that custom colors, and modified
+     * colors that depend on them, are resolved as well. Returns std::nullopt
+     * if \a customColor returns std::nullopt for any custom color that is
+     * needed.
+     */
+    std::optional<RgbaData> resolve(const std::function<std::optional<RgbaData>(const CustomColorData &)> &customColor) const;
     /*!
      * Returns a string representation of this Color.
      */
@@ -292,6 +317,28 @@ public:
 private:
     Type m_type = Type::Empty;
     std::variant<std::nullopt_t, RgbaData, CustomColorData, ModifiedColorData> m_data = std::nullopt;
+    // The evaluated result of a Modified color, if it has one.
+    std::optional<RgbaData> m_resolved;
+};
+
+/*!
+ * \class cssparser::Color::ColorProvider
+ *
+ * \brief An interface for providing the value of custom colors.
+ *
+ * Custom colors refer to colors that are only known to the application, for
+ * example those of a color palette. A StyleSheet uses a ColorProvider to
+ * resolve them, see StyleSheet::setColorProvider().
+ */
+class CSSPARSER_EXPORT ColorProvider
+{
+public:
+    virtual ~ColorProvider();
+
+    /*!
+     * Returns the value of \a color, or std::nullopt if it is not known.
+     */
+    virtual std::optional<RgbaData> customColor(const CustomColorData &color) = 0;
 };
 
 }
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#include "ComputedStyle.h"
+
+#include <algorithm>
+
+#include "CssParser.h"
+
+using namespace cssparser;
+
+ComputedStyle::ComputedStyle()
+{
+}
+
+ComputedStyle::ComputedStyle(std::span<const Rule *const> rules)
+{
+    std::size_t count = 0;
+    for (auto rule : rules) {
+        count += rule->properties().size();
+    }
+
+    m_properties.reserve(count);
+    for (auto rule : rules) {
+        for (const auto &property : rule->properties()) {
+            m_properties.push_back(&property);
+        }
+    }
+
+    // A stable sort keeps properties with the same name in the order they
+    // were applied, so the last one of each name is the one that wins.
+    std::stable_sort(m_properties.begin(), m_properties.end(), [](const Property *first, const Property *second) {
+        return first->nameAtom().id() < second->nameAtom().id();
+    });
+    auto last = std::unique(m_properties.rbegin(), m_properties.rend(), [](const Property *first, const Property *second) {
+        return first->nameAtom() == second->nameAtom();
+    });
+    m_properties.erase(m_properties.begin(), last.base());
+}
+
+const Property *ComputedStyle::property(Atom name) const
+{
+    auto itr = std::lower_bound(m_properties.cbegin(), m_properties.cend(), name.id(), [](const Property *property, uint32_t id) {
+        return property->nameAtom().id() < id;
+    });
+
+    if (itr == m_properties.cend() || (*itr)->nameAtom() != name) {
+        return nullptr;
+    }
+
+    return *itr;
+}
+
+const Property *ComputedStyle::property(std::string_view name) const
+{
+    const auto atom = Atom::lookup(name);
+    if (!atom) {
+        return nullptr;
+    }
+
+    return property(*atom);
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "Atom.h"
+
+#include "cssparser_export.h"
+
+namespace cssparser
+{
+
+class Property;
+class Rule;
+
+/*!
+ * \class cssparser::ComputedStyle
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief The result of applying a list of rules in order.
+ *
+ * ComputedStyle merges the properties of a number of rules into a single
+ * list that contains each property once, keyed by the Atom of its name. When
+ * multiple rules contain the same property, the property of the rule that
+ * comes last wins. Passing the result of StyleMatcher::matchingRules() gives
+ * the properties that apply to an element.
+ *
+ * ComputedStyle does not copy the properties it contains, it is only valid as
+ * long as the rules it was created from are.
+ */
+class CSSPARSER_EXPORT ComputedStyle
+{
+public:
+    /*!
+     * Constructs an empty ComputedStyle.
+     */
+    ComputedStyle();
+    /*!
+     * Constructs a ComputedStyle by applying \a rules in order.
+     */
+    explicit ComputedStyle(std::span<const Rule *const> rules);
+
+    /*!
+     * Returns the number of distinct properties in this ComputedStyle.
+     */
+    inline std::size_t size() const
+    {
+        return m_properties.size();
+    }
+    /*!
+     * Returns whether this ComputedStyle contains no properties.
+     */
+    inline bool isEmpty() const
+    {
+        return m_properties.empty();
+    }
+    /*!
+     * Returns all properties of this ComputedStyle, sorted by the id of the
+     * Atom of their name.
+     */
+    inline std::span<const Property *const> properties() const
+    {
+        return std::span<const Property *const>(m_properties.cbegin(), m_properties.cend());
+    }
+    /*!
+     * Returns the property named \a name, or nullptr if none of the applied
+     * rules contain it.
+     */
+    const Property *property(Atom name) const;
+    /*!
+     * \overload
+     */
+    const Property *property(std::string_view name) const;
+
+private:
+    std::vector<const Property *> m_properties;
+};
+
+}
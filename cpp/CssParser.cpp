@@ -3,9 +3,20 @@
 
 #include "CssParser.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <variant>
 
+#include "RuleVisitorAdapter.h"
+#include "StyleSheetSnapshot.h"
 #include "cxx-rust-cssparser-impl/src/ffi.rs.h"
 
 using namespace std::string_literals;
@@ -18,125 +29,879 @@ Property::Property(const std::string &name, const std::vector<Value> &values)
 {
 }
 
+Property::Property(Atom name, const std::vector<Value> &values)
+    : m_name(name)
+    , m_values(values)
+{
+}
+
 Property Property::fromRust(const rust::Property &rustData)
 {
     std::vector<Value> values;
-    for (const auto &rustValue : rustData.values()) {
-        values.push_back(Value::fromRust(rustValue));
+
+    const auto count = rustData.value_count();
+    values.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        values.push_back(Value::fromRust(rustData.value_at(i)));
     }
 
-    return Property{std::string(rustData.name()), values};
+    return Property{Atom::fromId(rustData.name_atom()), values};
+}
+
+PropertyView::PropertyView(const rust::Property &rustData)
+    : m_property(&rustData)
+{
+}
+
+std::string_view PropertyView::name() const
+{
+    const auto name = m_property->name_str();
+    return std::string_view(name.data(), name.size());
+}
+
+Atom PropertyView::nameAtom() const
+{
+    return Atom::fromId(m_property->name_atom());
+}
+
+std::size_t PropertyView::valueCount() const
+{
+    return m_property->value_count();
+}
+
+ValueView PropertyView::value(std::size_t index) const
+{
+    if (index >= valueCount()) {
+        throw std::out_of_range("Property value index out of range");
+    }
+
+    return ValueView(m_property->value_at(index));
+}
+
+std::vector<ValueView> PropertyView::values() const
+{
+    std::vector<ValueView> result;
+
+    const auto count = valueCount();
+    result.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        result.emplace_back(m_property->value_at(i));
+    }
+
+    return result;
+}
+
+Property PropertyView::toProperty() const
+{
+    return Property::fromRust(*m_property);
 }
 
 Rule::Rule()
+    : m_block(makeBlock({}, 0))
 {
 }
 
 Rule::Rule(const Selector &selector, const std::vector<Property> &properties)
     : m_selector(selector)
-    , m_properties(properties)
+    , m_block(makeBlock(std::vector<Property>(properties), 0))
+{
+}
+
+Rule::Rule(const Selector &selector, const std::vector<Property> &properties, Specificity specificity, std::size_t sourceOrder)
+    : m_selector(selector)
+    , m_block(makeBlock(std::vector<Property>(properties), 0))
+    , m_specificity(specificity)
+    , m_sourceOrder(sourceOrder)
+{
+}
+
+const Property *Rule::property(Atom name) const
+{
+    const auto &index = m_block->index;
+    auto itr = std::lower_bound(index.cbegin(), index.cend(), name.id(), [](const auto &entry, uint32_t id) {
+        return entry.first < id;
+    });
+
+    if (itr == index.cend() || itr->first != name.id()) {
+        return nullptr;
+    }
+
+    return &m_block->properties[itr->second];
+}
+
+const Property *Rule::property(std::string_view name) const
 {
+    // A name that was never interned cannot be the name of a property.
+    const auto atom = Atom::lookup(name);
+    if (!atom) {
+        return nullptr;
+    }
+
+    return property(*atom);
 }
 
-Rule Rule::fromRust(const rust::StyleRule &rule)
+std::shared_ptr<const Rule::Block> Rule::makeBlock(std::vector<Property> &&properties, std::uint64_t id)
+{
+    auto block = std::make_shared<Block>();
+    block->properties = std::move(properties);
+    block->id = id;
+
+    auto &index = block->index;
+    index.reserve(block->properties.size());
+    for (std::size_t i = 0; i < block->properties.size(); ++i) {
+        index.emplace_back(block->properties[i].nameAtom().id(), uint32_t(i));
+    }
+
+    // Sort by atom id and then by position, so only the last declaration of a
+    // property needs to be kept.
+    std::sort(index.begin(), index.end());
+    auto last = std::unique(index.rbegin(), index.rend(), [](const auto &first, const auto &second) {
+        return first.first == second.first;
+    });
+    index.erase(index.begin(), last.base());
+
+    return block;
+}
+
+inline Specificity convertSpecificity(const rust::Specificity &specificity)
+{
+    return Specificity{
+        .ids = specificity.ids,
+        .classes = specificity.classes,
+        .types = specificity.types,
+    };
+}
+
+Rule Rule::fromRust(const rust::StyleRule &rule, const Rule *sameBlock)
 {
     auto result = Rule{};
     result.m_selector = Selector::fromRust(rule.selector());
+    result.m_specificity = convertSpecificity(rule.specificity());
+    result.m_sourceOrder = rule.source_order();
+
+    if (sameBlock) {
+        result.m_block = sameBlock->m_block;
+        return result;
+    }
 
-    for (const auto &property : rule.properties()) {
-        result.m_properties.push_back(Property::fromRust(property));
+    const auto count = rule.property_count();
+    std::vector<Property> properties;
+    properties.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        properties.push_back(Property::fromRust(rule.property_at(i)));
     }
+    result.m_block = makeBlock(std::move(properties), rule.block_id());
 
     return result;
 }
 
+RuleView::RuleView(const rust::StyleRule &rustData)
+    : m_rule(&rustData)
+{
+}
+
+SelectorView RuleView::selector() const
+{
+    return SelectorView(m_rule->selector());
+}
+
+std::size_t RuleView::propertyCount() const
+{
+    return m_rule->property_count();
+}
+
+PropertyView RuleView::property(std::size_t index) const
+{
+    if (index >= propertyCount()) {
+        throw std::out_of_range("Rule property index out of range");
+    }
+
+    return PropertyView(m_rule->property_at(index));
+}
+
+std::vector<PropertyView> RuleView::properties() const
+{
+    std::vector<PropertyView> result;
+
+    const auto count = propertyCount();
+    result.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        result.emplace_back(m_rule->property_at(i));
+    }
+
+    return result;
+}
+
+Specificity RuleView::specificity() const
+{
+    return convertSpecificity(m_rule->specificity());
+}
+
+std::size_t RuleView::sourceOrder() const
+{
+    return m_rule->source_order();
+}
+
+std::uint64_t RuleView::blockId() const
+{
+    return m_rule->block_id();
+}
+
+Rule RuleView::toRule() const
+{
+    return Rule::fromRust(*m_rule);
+}
+
+RuleVisitor::~RuleVisitor() = default;
+
+static RuleVisitorAdapter visitorAdapter(RuleVisitor &visitor)
+{
+    return RuleVisitorAdapter(
+        [](void *context, const rust::StyleRule &rule) {
+            static_cast<RuleVisitor *>(context)->visitRule(RuleView(rule));
+        },
+        &visitor);
+}
+
+// Call function for every rule of stylesheet from the position start on.
+template<typename Function>
+static void forEachRule(const rust::StyleSheet &stylesheet, std::size_t start, Function function)
+{
+    const RuleVisitorAdapter adapter(
+        [](void *context, const rust::StyleRule &rule) {
+            (*static_cast<Function *>(context))(rule);
+        },
+        &function);
+    stylesheet.visit_rules_from(start, adapter);
+}
+
+struct CancellationToken::Private
+{
+    ::rust::Box<rust::Cancellation> cancellation = rust::create_cancellation();
+};
+
+CancellationToken::CancellationToken()
+    : d(std::make_shared<Private>())
+{
+}
+
+void CancellationToken::cancel()
+{
+    d->cancellation->cancel();
+}
+
+bool CancellationToken::isCancelled() const
+{
+    return d->cancellation->is_cancelled();
+}
+
+const rust::Cancellation &CancellationToken::rustCancellation() const
+{
+    return *d->cancellation;
+}
+
 struct StyleSheet::Private
 {
-    void update();
+    Private(const std::filesystem::path &path, const PropertyRegistry &registry)
+        : path(path)
+        , registry(registry)
+        , stylesheet(rust::create_stylesheet_with_registry(path.string(), registry.rustRegistry()))
+    {
+    }
+
+    void parse();
+    void addError(const std::filesystem::path &file, const std::exception &exception);
+    void update(std::size_t checkpoint);
+    void reloaded(const ::rust::Vec<rust::ReloadedRules> &reloaded, std::vector<ReloadedRules> &result);
+    void invalidate();
+    void convertRules();
+    void convertErrors();
+    std::optional<Color::RgbaData> customColor(const Color::CustomColorData &color);
 
     std::filesystem::path path;
+    PropertyRegistry registry;
 
-    rust::StyleSheet *stylesheet;
+    ::rust::Box<rust::StyleSheet> stylesheet;
     std::vector<Rule> rules;
+    // Computed by cascadeOrder(), cleared by update() when rules change.
+    std::vector<std::size_t> cascadeOrder;
     std::vector<Error> errors;
+    // Errors that were not converted yet by convertErrors(), either reported
+    // by C++ or the range of checkpoints of the Rust StyleSheet containing
+    // them, in the order they were added.
+    std::vector<std::variant<Error, std::pair<std::size_t, std::size_t>>> pendingErrors;
+    // The number of errors, including those that were not converted yet.
+    std::size_t errorCount = 0;
     std::vector<std::filesystem::path> paths;
+    ParseOptions options;
+
+    bool collectStatistics = false;
+    std::chrono::nanoseconds conversionTime{0};
+    std::size_t convertedRules = 0;
+
+    Color::ColorProvider *colorProvider = nullptr;
+    // The results of colorProvider, by source and arguments.
+    std::map<std::pair<std::string, std::vector<std::string>>, std::optional<Color::RgbaData>> customColors;
+
+    // The number of rules and errors that existed when a certain generation
+    // was reached, indexed by generation.
+    std::vector<std::size_t> generationRules = {0};
+    std::vector<std::size_t> generationErrors = {0};
+
+    // Incremented by update(), to know when a new snapshot is needed.
+    std::size_t revision = 0;
+    std::size_t snapshotRevision = 0;
+    // Held by every function of StyleSheet that accesses the members above,
+    // including the thread started by parseAsync() while it adds what it
+    // parsed. It is recursive since some of these functions call each other.
+    std::recursive_mutex mutex;
+    // This is the only member that may be accessed without holding mutex.
+    std::atomic<std::shared_ptr<const StyleSheetSnapshot>> published = std::make_shared<const StyleSheetSnapshot>();
 };
 
 StyleSheet::StyleSheet(const std::filesystem::path &path)
-    : d(std::make_unique<Private>())
+    : StyleSheet(path, PropertyRegistry::global())
 {
-    d->path = path;
+}
 
-    auto sheet = rust::create_stylesheet(path.string());
-    d->stylesheet = sheet.into_raw();
+StyleSheet::StyleSheet(const std::filesystem::path &path, const PropertyRegistry &registry)
+    : d(std::make_shared<Private>(path, registry))
+{
 }
 
 StyleSheet::~StyleSheet() = default;
 
 std::span<const Rule> StyleSheet::rules() const
 {
+    const std::lock_guard lock(d->mutex);
+    d->convertRules();
     return std::span<const Rule>(d->rules.cbegin(), d->rules.cend());
 }
 
+std::size_t StyleSheet::ruleCount() const
+{
+    const std::lock_guard lock(d->mutex);
+    return d->stylesheet->rule_count();
+}
+
+RuleView StyleSheet::ruleView(std::size_t index) const
+{
+    const std::lock_guard lock(d->mutex);
+    if (index >= ruleCount()) {
+        throw std::out_of_range("Rule index out of range");
+    }
+
+    return RuleView(d->stylesheet->rule_at(index));
+}
+
+std::vector<RuleView> StyleSheet::ruleViews() const
+{
+    const std::lock_guard lock(d->mutex);
+    std::vector<RuleView> result;
+
+    result.reserve(ruleCount());
+    forEachRule(*d->stylesheet, 0, [&result](const rust::StyleRule &rule) {
+        result.emplace_back(rule);
+    });
+
+    return result;
+}
+
+std::span<const std::size_t> StyleSheet::cascadeOrder() const
+{
+    const std::lock_guard lock(d->mutex);
+    if (d->cascadeOrder.empty()) {
+        const auto order = d->stylesheet->cascade_order();
+        d->cascadeOrder.assign(order.begin(), order.end());
+    }
+
+    return std::span<const std::size_t>(d->cascadeOrder.cbegin(), d->cascadeOrder.cend());
+}
+
 std::span<const Error> StyleSheet::errors() const
 {
+    const std::lock_guard lock(d->mutex);
+    d->convertErrors();
     return std::span<const Error>(d->errors.cbegin(), d->errors.cend());
 }
 
 std::span<const std::filesystem::path> StyleSheet::paths() const
 {
+    const std::lock_guard lock(d->mutex);
     return std::span<const std::filesystem::path>(d->paths.cbegin(), d->paths.cend());
 }
 
+void StyleSheet::withRustStyleSheet(const std::function<void(const rust::StyleSheet &)> &function) const
+{
+    const std::lock_guard lock(d->mutex);
+    function(*d->stylesheet);
+}
+
+PropertyRegistry StyleSheet::registry() const
+{
+    return d->registry;
+}
+
+std::size_t StyleSheet::generation() const
+{
+    const std::lock_guard lock(d->mutex);
+    return d->generationRules.size() - 1;
+}
+
+std::span<const Rule> StyleSheet::rulesSince(std::size_t generation) const
+{
+    const std::lock_guard lock(d->mutex);
+    if (generation >= d->generationRules.size()) {
+        return std::span<const Rule>{};
+    }
+
+    d->convertRules();
+    return std::span<const Rule>(d->rules.cbegin() + d->generationRules.at(generation), d->rules.cend());
+}
+
+std::span<const Error> StyleSheet::errorsSince(std::size_t generation) const
+{
+    const std::lock_guard lock(d->mutex);
+    if (generation >= d->generationErrors.size()) {
+        return std::span<const Error>{};
+    }
+
+    d->convertErrors();
+    return std::span<const Error>(d->errors.cbegin() + d->generationErrors.at(generation), d->errors.cend());
+}
+
 void StyleSheet::parse()
 {
+    const std::lock_guard lock(d->mutex);
+    d->parse();
+}
+
+void StyleSheet::parse(RuleVisitor &visitor)
+{
+    const std::lock_guard lock(d->mutex);
+    const auto checkpoint = d->stylesheet->current_checkpoint();
+    const auto adapter = visitorAdapter(visitor);
+
     try {
-        d->stylesheet->parse();
+        d->stylesheet->parse_visit(adapter);
     } catch (const std::exception &e) {
-        d->errors.push_back(Error{
-            .file = d->path,
-            .line = 0,
-            .column = 0,
-            .message = e.what(),
-        });
+        d->addError(d->path, e);
+    }
 
-        return;
+    d->update(checkpoint);
+}
+
+std::future<void> StyleSheet::parseAsync(const CancellationToken &cancellation)
+{
+    // The thread shares ownership of Private, so it stays valid even if this
+    // StyleSheet is destroyed before parsing finished.
+    return std::async(std::launch::async, [d = d, cancellation]() {
+        // Parse into a separate Rust StyleSheet, so the lock is only held
+        // while adding the result.
+        auto stylesheet = [&d]() {
+            const std::lock_guard lock(d->mutex);
+            return d->stylesheet->create_empty_copy();
+        }();
+        stylesheet->set_cancellation(cancellation.rustCancellation());
+
+        std::optional<std::runtime_error> error;
+        try {
+            stylesheet->parse();
+        } catch (const std::exception &e) {
+            error.emplace(e.what());
+        }
+
+        const std::lock_guard lock(d->mutex);
+        const auto checkpoint = d->stylesheet->current_checkpoint();
+        d->stylesheet->append_sheet(std::move(stylesheet));
+        if (error) {
+            d->addError(d->path, *error);
+        }
+        d->update(checkpoint);
+    });
+}
+
+void StyleSheet::parseCached(const std::filesystem::path &cacheDir)
+{
+    const std::lock_guard lock(d->mutex);
+    const auto checkpoint = d->stylesheet->current_checkpoint();
+
+    try {
+        d->stylesheet->parse_with_cache(cacheDir.string());
+    } catch (const std::exception &e) {
+        d->addError(d->path, e);
     }
 
-    d->update();
+    d->update(checkpoint);
+}
+
+std::unique_ptr<StyleSheet> StyleSheet::loadCached(const std::filesystem::path &path, const std::filesystem::path &cacheDir)
+{
+    auto result = std::make_unique<StyleSheet>(path);
+    result->parseCached(cacheDir);
+    return result;
 }
 
 void StyleSheet::parseString(const std::string &source)
 {
-    d->stylesheet->parse_string(source);
-    d->update();
+    const std::lock_guard lock(d->mutex);
+    const auto checkpoint = d->stylesheet->current_checkpoint();
+
+    try {
+        d->stylesheet->parse_string(source);
+    } catch (const std::exception &e) {
+        d->addError(d->path, e);
+    }
+
+    d->update(checkpoint);
 }
 
-void cssparser::StyleSheet::import(const std::filesystem::path &path)
+void StyleSheet::parseString(const std::string &source, RuleVisitor &visitor)
 {
-    d->stylesheet->import_file(path.string());
+    const std::lock_guard lock(d->mutex);
+    const auto checkpoint = d->stylesheet->current_checkpoint();
+    const auto adapter = visitorAdapter(visitor);
+
+    try {
+        d->stylesheet->parse_string_visit(source, adapter);
+    } catch (const std::exception &e) {
+        d->addError(d->path, e);
+    }
+
+    d->update(checkpoint);
 }
 
-void StyleSheet::Private::update()
+void cssparser::StyleSheet::import(const std::filesystem::path &path)
 {
-    rules.clear();
-    for (const auto &entry : stylesheet->rules()) {
-        auto rule = Rule::fromRust(entry);
-        rules.push_back(rule);
+    const std::lock_guard lock(d->mutex);
+    const auto checkpoint = d->stylesheet->current_checkpoint();
+
+    try {
+        d->stylesheet->import_file(path.string());
+    } catch (const std::exception &e) {
+        d->addError(path, e);
     }
 
-    errors.clear();
-    for (const auto &entry : stylesheet->errors()) {
-        errors.push_back(Error{
-            .file = std::string(entry.file),
-            .line = entry.line,
-            .column = entry.column,
-            .message = std::string(entry.message),
+    d->update(checkpoint);
+}
+
+void StyleSheet::setParallelImports(bool enabled)
+{
+    const std::lock_guard lock(d->mutex);
+    d->stylesheet->set_parallel_imports(enabled);
+}
+
+void StyleSheet::setParseThreads(std::size_t threads)
+{
+    const std::lock_guard lock(d->mutex);
+    d->stylesheet->set_parse_threads(threads);
+}
+
+void StyleSheet::setParseOptions(const ParseOptions &options)
+{
+    const std::lock_guard lock(d->mutex);
+    constexpr auto unlimited = std::numeric_limits<std::size_t>::max();
+
+    d->options = options;
+    d->stylesheet->set_options(rust::ParseOptions{
+        .max_errors = options.maxErrors.value_or(unlimited),
+        .max_rules = options.maxRules.value_or(unlimited),
+        .max_nesting_depth = options.maxNestingDepth.value_or(unlimited),
+        .max_input_size = options.maxInputSize.value_or(unlimited),
+        .stop_at_first_error = options.stopAtFirstError,
+        .canonicalize_units = options.canonicalizeUnits,
+    });
+}
+
+ParseOptions StyleSheet::parseOptions() const
+{
+    const std::lock_guard lock(d->mutex);
+    return d->options;
+}
+
+void StyleSheet::setCollectStatistics(bool enabled)
+{
+    const std::lock_guard lock(d->mutex);
+    d->collectStatistics = enabled;
+    d->stylesheet->set_collect_statistics(enabled);
+}
+
+ParseStatistics StyleSheet::statistics() const
+{
+    const std::lock_guard lock(d->mutex);
+    ParseStatistics result{
+        .conversionTime = d->conversionTime,
+        .convertedRules = d->convertedRules,
+    };
+
+    for (const auto &entry : d->stylesheet->file_statistics()) {
+        result.files.push_back(FileStatistics{
+            .path = std::filesystem::path(std::string(entry.path)),
+            .bytes = entry.bytes,
+            .readTime = std::chrono::nanoseconds(entry.read),
+            .parseTime = std::chrono::nanoseconds(entry.parse),
+            .selectorTime = std::chrono::nanoseconds(entry.selectors),
+            .valueTime = std::chrono::nanoseconds(entry.values),
+            .flattenTime = std::chrono::nanoseconds(entry.flatten),
+            .rules = entry.rules,
+            .declarations = entry.declarations,
+            .selectorParts = entry.selector_parts,
+            .registryLookups = entry.registry_lookups,
+            .registryHits = entry.registry_hits,
         });
     }
 
+    return result;
+}
+
+std::vector<std::filesystem::path> StyleSheet::modifiedPaths() const
+{
+    const std::lock_guard lock(d->mutex);
+    std::vector<std::filesystem::path> result;
+    for (const auto &entry : d->stylesheet->modified_paths()) {
+        result.push_back(std::filesystem::path(std::string(entry)));
+    }
+    return result;
+}
+
+std::vector<ReloadedRules> StyleSheet::reload(const std::filesystem::path &path)
+{
+    const std::lock_guard lock(d->mutex);
+    std::vector<ReloadedRules> result;
+
+    try {
+        d->reloaded(d->stylesheet->reload_file(path.string()), result);
+    } catch (const std::exception &e) {
+        d->addError(path, e);
+        d->update(d->stylesheet->current_checkpoint());
+    }
+
+    return result;
+}
+
+std::vector<ReloadedRules> StyleSheet::reloadModified()
+{
+    const std::lock_guard lock(d->mutex);
+    std::vector<ReloadedRules> result;
+
+    try {
+        d->reloaded(d->stylesheet->reload_modified_files(), result);
+    } catch (const std::exception &e) {
+        // Files before the one that failed may have been reloaded already.
+        d->invalidate();
+        d->addError(d->path, e);
+        d->update(d->stylesheet->current_checkpoint());
+    }
+
+    return result;
+}
+
+std::shared_ptr<const StyleSheetSnapshot> StyleSheet::snapshot() const
+{
+    const std::lock_guard lock(d->mutex);
+    if (d->snapshotRevision == d->revision) {
+        return d->published.load();
+    }
+
+    d->convertRules();
+    d->convertErrors();
+    const auto order = cascadeOrder();
+    auto snapshot = std::make_shared<const StyleSheetSnapshot>(std::vector<Rule>(d->rules),
+                                                               std::vector<std::size_t>(order.begin(), order.end()),
+                                                               std::vector<Error>(d->errors),
+                                                               std::vector<std::filesystem::path>(d->paths),
+                                                               generation());
+
+    d->published.store(snapshot);
+    d->snapshotRevision = d->revision;
+    return snapshot;
+}
+
+std::shared_ptr<const StyleSheetSnapshot> StyleSheet::publishedSnapshot() const
+{
+    return d->published.load();
+}
+
+void StyleSheet::setColorProvider(Color::ColorProvider *provider)
+{
+    const std::lock_guard lock(d->mutex);
+    d->colorProvider = provider;
+    d->customColors.clear();
+}
+
+void StyleSheet::resolveCustomColors()
+{
+    const std::lock_guard lock(d->mutex);
+    if (!d->colorProvider) {
+        return;
+    }
+
+    for (const auto &entry : d->stylesheet->custom_colors()) {
+        d->customColor(Color::CustomColorData::fromRust(entry));
+    }
+}
+
+void StyleSheet::invalidateColorSource(std::string_view source)
+{
+    const std::lock_guard lock(d->mutex);
+    for (auto &[key, value] : d->customColors) {
+        if (key.first == source) {
+            value = d->colorProvider ? d->colorProvider->customColor(Color::CustomColorData(key.first, key.second)) : std::nullopt;
+        }
+    }
+}
+
+std::optional<Color::RgbaData> StyleSheet::resolveColor(const Color::Color &color) const
+{
+    const std::lock_guard lock(d->mutex);
+    return color.resolve([this](const Color::CustomColorData &custom) {
+        return d->customColor(custom);
+    });
+}
+
+std::optional<Color::RgbaData> StyleSheet::Private::customColor(const Color::CustomColorData &color)
+{
+    auto key = std::make_pair(color.source(), color.arguments());
+    if (auto itr = customColors.find(key); itr != customColors.end()) {
+        return itr->second;
+    }
+
+    if (!colorProvider) {
+        return std::nullopt;
+    }
+
+    const auto result = colorProvider->customColor(color);
+    customColors.emplace(std::move(key), result);
+    return result;
+}
+
+void StyleSheet::Private::parse()
+{
+    const auto checkpoint = stylesheet->current_checkpoint();
+
+    try {
+        stylesheet->parse();
+    } catch (const std::exception &e) {
+        addError(path, e);
+    }
+
+    update(checkpoint);
+}
+
+void StyleSheet::Private::addError(const std::filesystem::path &file, const std::exception &exception)
+{
+    pendingErrors.push_back(Error{
+        .file = file,
+        .line = 0,
+        .column = 0,
+        .message = exception.what(),
+    });
+    errorCount++;
+}
+
+void StyleSheet::Private::update(std::size_t checkpoint)
+{
+    revision++;
+
+    // Rules and errors are converted lazily by convertRules() and
+    // convertErrors(), so parsing input with many errors does not pay for
+    // converting them unless they are needed. Only what was added since
+    // checkpoint needs to be recorded, everything before that was handled by
+    // a previous update().
+    const auto addedErrors = stylesheet->error_count_since_checkpoint(checkpoint);
+    if (addedErrors > 0) {
+        pendingErrors.push_back(std::pair{checkpoint, stylesheet->current_checkpoint()});
+        errorCount += addedErrors;
+    }
+
+    const auto ruleCount = stylesheet->rule_count();
+    if (ruleCount != generationRules.back()) {
+        cascadeOrder.clear();
+    }
+
+    if (ruleCount != generationRules.back() || errorCount != generationErrors.back()) {
+        generationRules.push_back(ruleCount);
+        generationErrors.push_back(errorCount);
+    }
+
     paths.clear();
     for (const auto &entry : stylesheet->paths()) {
         paths.push_back(std::filesystem::path(std::string(entry)));
     }
 }
+
+void StyleSheet::Private::reloaded(const ::rust::Vec<rust::ReloadedRules> &reloaded, std::vector<ReloadedRules> &result)
+{
+    if (reloaded.empty()) {
+        return;
+    }
+
+    for (const auto &entry : reloaded) {
+        result.push_back(ReloadedRules{entry.start, entry.removed, entry.added});
+    }
+
+    invalidate();
+}
+
+void StyleSheet::Private::invalidate()
+{
+    // Anything may have moved after reloading, so convert all rules and
+    // errors again and let every earlier generation include all of
+    // them.
+    rules.clear();
+    errors.clear();
+    pendingErrors.clear();
+    errorCount = 0;
+    cascadeOrder.clear();
+    std::ranges::fill(generationRules, 0);
+    std::ranges::fill(generationErrors, 0);
+    update(0);
+}
+
+void StyleSheet::Private::convertErrors()
+{
+    errors.reserve(errorCount);
+    for (const auto &entry : pendingErrors) {
+        if (const auto error = std::get_if<Error>(&entry)) {
+            errors.push_back(*error);
+            continue;
+        }
+
+        const auto [start, end] = std::get<std::pair<std::size_t, std::size_t>>(entry);
+        for (const auto &rustError : stylesheet->errors_between_checkpoints(start, end)) {
+            errors.push_back(Error{
+                .file = std::string(rustError.file),
+                .line = rustError.line,
+                .column = rustError.column,
+                .message = std::string(rustError.message),
+            });
+        }
+    }
+    pendingErrors.clear();
+}
+
+void StyleSheet::Private::convertRules()
+{
+    const auto count = stylesheet->rule_count();
+    if (rules.size() >= count) {
+        return;
+    }
+
+    const auto start = collectStatistics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    const auto converted = count - rules.size();
+
+    // The first converted rule of every block, so the properties of rules
+    // that share a block in Rust are converted once and shared as well.
+    std::unordered_map<std::uint64_t, std::size_t> blocks;
+
+    rules.reserve(count);
+    forEachRule(*stylesheet, rules.size(), [this, &blocks](const rust::StyleRule &rule) {
+        const auto [itr, inserted] = blocks.try_emplace(rule.block_id(), rules.size());
+        rules.push_back(Rule::fromRust(rule, inserted ? nullptr : &rules[itr->second]));
+    });
+
+    if (collectStatistics) {
+        conversionTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        convertedRules += converted;
+    }
+}
@@ -3,8 +3,16 @@
 
 #pragma once
 
+#include <chrono>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string_view>
 
+#include "Atom.h"
+#include "PropertyRegistry.h"
 #include "Selector.h"
 
 #include "cssparser_export.h"
@@ -13,10 +21,14 @@ namespace cssparser
 {
 namespace rust
 {
+struct Cancellation;
 struct Property;
 struct StyleRule;
+struct StyleSheet;
 }
 
+class StyleSheetSnapshot;
+
 /*!
  * \class cssparser::Property
  * \inmodule cxx-rust-cssparser
@@ -32,10 +44,26 @@ public:
      * Constructs a new Property with  \a name as name and \a values as values.
      */
     Property(const std::string &name, const std::vector<Value> &values);
+    /*!
+     * Constructor.
+     *
+     * Constructs a new Property with \a name as name and \a values as values.
+     */
+    Property(Atom name, const std::vector<Value> &values);
     /*!
      * Returns the name of this Property.
      */
     inline std::string name() const
+    {
+        return std::string(m_name.name());
+    }
+    /*!
+     * Returns the name of this Property as an Atom.
+     *
+     * Comparing Atoms is cheaper than comparing strings, use this when looking
+     * up properties by name.
+     */
+    inline Atom nameAtom() const
     {
         return m_name;
     }
@@ -66,7 +94,7 @@ public:
     static Property fromRust(const rust::Property &rustData);
 
 private:
-    std::string m_name;
+    Atom m_name;
     std::vector<Value> m_values;
 };
 
@@ -89,6 +117,14 @@ public:
      * Constructs a Rule with \a selector as selector and \a properties as properties.
      */
     Rule(const Selector &selector, const std::vector<Property> &properties);
+    /*!
+     * Constructor.
+     *
+     * Constructs a Rule with \a selector as selector and \a properties as
+     * properties, using \a specificity and \a sourceOrder as its position in
+     * the cascade.
+     */
+    Rule(const Selector &selector, const std::vector<Property> &properties, Specificity specificity, std::size_t sourceOrder);
     /*!
      * Returns the selector of this Rule.
      */
@@ -101,15 +137,204 @@ public:
      */
     inline std::span<const Property> properties() const
     {
-        return std::span<const Property>(m_properties.cbegin(), m_properties.cend());
+        return std::span<const Property>(m_block->properties.cbegin(), m_block->properties.cend());
+    }
+    /*!
+     * Returns an id for the properties of this Rule.
+     *
+     * Rules that share their properties have the same id and no other
+     * properties ever have that id, so it can be used to cache anything that
+     * is computed from the properties alone. Rules with the same properties
+     * share them if they were parsed by the same call to parse(), but not
+     * necessarily otherwise. Ids are assigned while parsing, so they differ
+     * between runs and should not be stored.
+     *
+     * This is 0 for rules that were not created by parsing.
+     */
+    inline std::uint64_t blockId() const
+    {
+        return m_block->id;
+    }
+    /*!
+     * Returns the property named \a name, or nullptr if this Rule does not
+     * contain such a property.
+     *
+     * If the property was declared multiple times, the last declaration is
+     * returned, as that is the one that applies.
+     */
+    const Property *property(Atom name) const;
+    /*!
+     * \overload
+     */
+    const Property *property(std::string_view name) const;
+    /*!
+     * Returns the specificity of the selector of this Rule.
+     *
+     * This is computed once while parsing.
+     */
+    inline Specificity specificity() const
+    {
+        return m_specificity;
+    }
+    /*!
+     * Returns the position of this Rule in the StyleSheet it was parsed for.
+     *
+     * Rules with the same specificity are applied in order of their source
+     * order. This is the same as the index of this Rule in StyleSheet::rules().
+     */
+    inline std::size_t sourceOrder() const
+    {
+        return m_sourceOrder;
     }
 
-    // Internal. Convert from a rust StyleRule to a C++ Rule.
-    static Rule fromRust(const rust::StyleRule &rustData);
+    // Internal. Convert from a rust StyleRule to a C++ Rule. If \a sameBlock
+    // is not null, it is a rule with the same block id whose properties are
+    // shared instead of converting them again.
+    static Rule fromRust(const rust::StyleRule &rustData, const Rule *sameBlock = nullptr);
 
 private:
+    struct Block {
+        std::vector<Property> properties;
+        // Pairs of atom id and index into properties, sorted by atom id.
+        std::vector<std::pair<uint32_t, uint32_t>> index;
+        std::uint64_t id = 0;
+    };
+
+    static std::shared_ptr<const Block> makeBlock(std::vector<Property> &&properties, std::uint64_t id);
+
     Selector m_selector;
-    std::vector<Property> m_properties;
+    // Shared by all rules with the same properties.
+    std::shared_ptr<const Block> m_block;
+    Specificity m_specificity;
+    std::size_t m_sourceOrder = 0;
+};
+
+/*!
+ * \class cssparser::PropertyView
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief A non-owning view on a Property that is part of a StyleSheet.
+ *
+ * The view is only valid as long as the StyleSheet it was retrieved from is
+ * alive and has not been modified.
+ */
+class CSSPARSER_EXPORT PropertyView
+{
+public:
+    // Internal. Constructs a view on a rust Property.
+    explicit PropertyView(const rust::Property &rustData);
+    /*!
+     * Returns the name of the viewed Property.
+     */
+    std::string_view name() const;
+    /*!
+     * Returns the name of the viewed Property as an Atom.
+     */
+    Atom nameAtom() const;
+    /*!
+     * Returns the number of values of the viewed Property.
+     */
+    std::size_t valueCount() const;
+    /*!
+     * Returns a view on the value at \a index.
+     *
+     * Throws std::out_of_range if \a index is not smaller than valueCount().
+     */
+    ValueView value(std::size_t index = 0) const;
+    /*!
+     * Returns views on all values of the viewed Property.
+     */
+    std::vector<ValueView> values() const;
+    /*!
+     * Returns a copy of the viewed Property.
+     */
+    Property toProperty() const;
+
+private:
+    const rust::Property *m_property;
+};
+
+/*!
+ * \class cssparser::RuleView
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief A non-owning view on a Rule that is part of a StyleSheet.
+ *
+ * The view is only valid as long as the StyleSheet it was retrieved from is
+ * alive and has not been modified.
+ *
+ * \sa StyleSheet::ruleViews()
+ */
+class CSSPARSER_EXPORT RuleView
+{
+public:
+    // Internal. Constructs a view on a rust StyleRule.
+    explicit RuleView(const rust::StyleRule &rustData);
+    /*!
+     * Returns a view on the selector of the viewed Rule.
+     */
+    SelectorView selector() const;
+    /*!
+     * Returns the number of properties of the viewed Rule.
+     */
+    std::size_t propertyCount() const;
+    /*!
+     * Returns a view on the property at \a index.
+     *
+     * Throws std::out_of_range if \a index is not smaller than propertyCount().
+     */
+    PropertyView property(std::size_t index) const;
+    /*!
+     * Returns views on all properties of the viewed Rule.
+     */
+    std::vector<PropertyView> properties() const;
+    /*!
+     * Returns the specificity of the viewed Rule.
+     *
+     * \sa Rule::specificity()
+     */
+    Specificity specificity() const;
+    /*!
+     * Returns the source order of the viewed Rule.
+     *
+     * \sa Rule::sourceOrder()
+     */
+    std::size_t sourceOrder() const;
+    /*!
+     * Returns the id of the properties of the viewed Rule.
+     *
+     * \sa Rule::blockId()
+     */
+    std::uint64_t blockId() const;
+    /*!
+     * Returns a copy of the viewed Rule.
+     */
+    Rule toRule() const;
+
+private:
+    const rust::StyleRule *m_rule;
+};
+
+/*!
+ * \class cssparser::RuleVisitor
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief An interface for receiving rules while they are parsed.
+ *
+ * \sa StyleSheet::parse(RuleVisitor &)
+ */
+class CSSPARSER_EXPORT RuleVisitor
+{
+public:
+    virtual ~RuleVisitor();
+
+    /*!
+     * Called for every rule, in the order they are parsed.
+     *
+     * \a rule is only valid during this call, use RuleView::toRule() to keep
+     * a copy of it.
+     */
+    virtual void visitRule(const RuleView &rule) = 0;
 };
 
 /*!
@@ -124,6 +349,150 @@ struct CSSPARSER_EXPORT Error {
     std::string message;
 };
 
+/*!
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief A struct describing the rules that were replaced by reloading a file.
+ *
+ * \a start is the index of the first replaced rule in StyleSheet::rules(),
+ * \a removed rules were replaced by \a added new rules.
+ *
+ * \sa StyleSheet::reload()
+ */
+struct CSSPARSER_EXPORT ReloadedRules {
+    std::size_t start = 0;
+    std::size_t removed = 0;
+    std::size_t added = 0;
+};
+
+/*!
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief Limits for parsing a StyleSheet.
+ *
+ * These avoid spending a lot of time and memory on untrusted or unexpectedly
+ * large input. Limits that are not set are unlimited.
+ *
+ * The limits apply to everything a single call to parse(), parseString() or
+ * import() parses, including imported files. When a limit is exceeded,
+ * parsing stops and an error describing the exceeded limit is added to
+ * StyleSheet::errors(). Everything parsed up to that point is kept.
+ *
+ * \a maxErrors is the number of errors that are recorded before parsing
+ * stops, \a maxRules the number of rules after which parsing stops.
+ * \a maxNestingDepth is the maximum depth of nested rules, where a top-level
+ * rule has depth 1. Rules that are nested deeper are discarded with an
+ * error. \a maxInputSize is the number of bytes that are parsed, parsing
+ * stops before a file that would exceed it. If \a stopAtFirstError is true,
+ * parsing stops at the first error.
+ *
+ * If \a canonicalizeUnits is true, dimensions are converted while parsing:
+ * absolute lengths to pixels, angles to radians and times to milliseconds.
+ * Relative units like em and percentages are kept as they are. This also
+ * accepts absolute lengths and angles that are otherwise unsupported, like
+ * \c{cm} and \c{turn}.
+ *
+ * \sa StyleSheet::setParseOptions()
+ */
+struct CSSPARSER_EXPORT ParseOptions {
+    std::optional<std::size_t> maxErrors;
+    std::optional<std::size_t> maxRules;
+    std::optional<std::size_t> maxNestingDepth;
+    std::optional<std::size_t> maxInputSize;
+    bool stopAtFirstError = false;
+    bool canonicalizeUnits = false;
+};
+
+/*!
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief Statistics about parsing a single file.
+ *
+ * \a bytes is the size of the file. \a readTime is the time spent reading
+ * the file and \a parseTime the time spent parsing it, including
+ * \a selectorTime for parsing selectors, \a valueTime for parsing and
+ * validating property values and \a flattenTime for flattening nested rules.
+ * What remains of \a parseTime was mostly spent tokenizing. Time spent on
+ * files that are imported is not included.
+ *
+ * \a rules, \a declarations and \a selectorParts count what was parsed.
+ * \a registryLookups is the number of times a property definition was looked
+ * up, \a registryHits how many of those found a definition.
+ */
+struct CSSPARSER_EXPORT FileStatistics {
+    std::filesystem::path path;
+    std::size_t bytes = 0;
+
+    std::chrono::nanoseconds readTime{0};
+    std::chrono::nanoseconds parseTime{0};
+    std::chrono::nanoseconds selectorTime{0};
+    std::chrono::nanoseconds valueTime{0};
+    std::chrono::nanoseconds flattenTime{0};
+
+    std::size_t rules = 0;
+    std::size_t declarations = 0;
+    std::size_t selectorParts = 0;
+    std::size_t registryLookups = 0;
+    std::size_t registryHits = 0;
+};
+
+/*!
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief Statistics about parsing a StyleSheet.
+ *
+ * \a files contains one entry for every file that was parsed, in the same
+ * order as StyleSheet::paths(). \a conversionTime is the time spent
+ * converting \a convertedRules rules to C++.
+ *
+ * \sa StyleSheet::setCollectStatistics()
+ */
+struct CSSPARSER_EXPORT ParseStatistics {
+    std::vector<FileStatistics> files;
+    std::chrono::nanoseconds conversionTime{0};
+    std::size_t convertedRules = 0;
+};
+
+/*!
+ * \class cssparser::CancellationToken
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief Allows cancelling a parse from another thread.
+ *
+ * CancellationToken is a handle, copies refer to the same state so
+ * cancelling one of them cancels all of them.
+ *
+ * \sa StyleSheet::parseAsync()
+ */
+class CSSPARSER_EXPORT CancellationToken
+{
+public:
+    /*!
+     * Constructs a new token that was not cancelled.
+     */
+    CancellationToken();
+
+    /*!
+     * Cancel any parse that uses this token.
+     *
+     * Parsing stops before the next rule or file and an error is added to
+     * the StyleSheet that was being parsed. This can be called from any
+     * thread.
+     */
+    void cancel();
+    /*!
+     * Returns true if cancel() was called.
+     */
+    bool isCancelled() const;
+
+    // Internal. Returns the rust Cancellation this refers to.
+    const rust::Cancellation &rustCancellation() const;
+
+private:
+    struct Private;
+    std::shared_ptr<Private> d;
+};
+
 /*!
  * \inmodule cxx-rust-cssparser
  *
@@ -135,24 +504,107 @@ class CSSPARSER_EXPORT StyleSheet
 public:
     /*!
      * Default constructor.
+     *
+     * The StyleSheet will use the global PropertyRegistry.
      */
     StyleSheet(const std::filesystem::path &path);
+    /*!
+     * Constructs a StyleSheet for \a path that uses \a registry to look up
+     * and store property definitions.
+     *
+     * Files imported by this StyleSheet use the same registry.
+     */
+    StyleSheet(const std::filesystem::path &path, const PropertyRegistry &registry);
     ~StyleSheet();
 
+    StyleSheet(const StyleSheet &) = delete;
+    StyleSheet &operator=(const StyleSheet &) = delete;
+
     /*!
      * A view of the list of rules contained in this StyleSheet.
+     *
+     * \note Rules are converted on first access. If the rules are only read
+     * once, ruleViews() avoids making a copy of them.
+     *
+     * \note The span is only valid until this StyleSheet is modified, see
+     * parseAsync().
      */
     std::span<const Rule> rules() const;
+    /*!
+     * Returns the number of rules contained in this StyleSheet.
+     */
+    std::size_t ruleCount() const;
+    /*!
+     * Returns a view on the rule at \a index.
+     *
+     * Throws std::out_of_range if \a index is not smaller than ruleCount().
+     *
+     * \sa ruleViews()
+     */
+    RuleView ruleView(std::size_t index) const;
+    /*!
+     * Returns views on all rules contained in this StyleSheet.
+     *
+     * In contrast to rules(), this does not copy any data. The views remain
+     * valid until this StyleSheet is destroyed or modified, see parseAsync().
+     */
+    std::vector<RuleView> ruleViews() const;
+    /*!
+     * Returns the indices of all rules sorted by their position in the cascade.
+     *
+     * The indices refer to rules() and are sorted by specificity and then by
+     * source order. Applying the rules that match something in this order
+     * results in the correct cascade, without needing to sort them.
+     *
+     * \note The order is computed on first access after rules were added.
+     * The span is only valid until this StyleSheet is modified.
+     */
+    std::span<const std::size_t> cascadeOrder() const;
     /*!
      * A view of the list of errors generated when parsing this StyleSheet.
+     *
+     * \note Errors are converted on first access, so parsing input with many
+     * errors is cheap as long as they are not needed. The span is only valid
+     * until this StyleSheet is modified.
      */
     std::span<const Error> errors() const;
     /*!
      * A view of the list of files that were parsed by this StyleSheet.
      *
      * This includes files that were imported using \c{@import} in CSS.
+     *
+     * \note The span is only valid until this StyleSheet is modified.
      */
     std::span<const std::filesystem::path> paths() const;
+    /*!
+     * Returns the PropertyRegistry used by this StyleSheet.
+     */
+    PropertyRegistry registry() const;
+    /*!
+     * Returns the current generation of this StyleSheet.
+     *
+     * The generation starts at 0 and is incremented every time parse(),
+     * parseString() or import() add new rules or errors to this StyleSheet.
+     * It can be passed to rulesSince() and errorsSince() to only retrieve
+     * what was added since then.
+     */
+    std::size_t generation() const;
+    /*!
+     * A view of the list of rules that were added after \a generation.
+     *
+     * \note The span is only valid until this StyleSheet is modified.
+     *
+     * \sa generation()
+     */
+    std::span<const Rule> rulesSince(std::size_t generation) const;
+    /*!
+     * A view of the list of errors that were added after \a generation.
+     *
+     * \note The span is only valid until this StyleSheet is modified.
+     *
+     * \sa generation()
+     */
+    std::span<const Error> errorsSince(std::size_t generation) const;
     /*!
      * Parse a CSS file and add all rules to this StyleSheet.
      *
@@ -164,6 +616,61 @@ public:
      * errors.
      */
     void parse();
+    /*!
+     * Parse a CSS file and pass every rule to \a visitor as soon as it was
+     * parsed.
+     *
+     * This behaves like parse(), including for files that are imported, but
+     * the rules are not stored so they will not be available from rules()
+     * afterwards. This allows processing large files without keeping all of
+     * their rules in memory.
+     *
+     * If \a visitor throws an exception, it is not called for any further
+     * rules and the exception is reported as error once parsing finished.
+     */
+    void parse(RuleVisitor &visitor);
+    /*!
+     * Parse a CSS file on a separate thread.
+     *
+     * This behaves like parse(), but reading and parsing the file and
+     * anything it imports happens on a separate thread. The returned future
+     * becomes ready once that finished. Errors are reported through errors()
+     * as usual, so the future never contains an exception.
+     *
+     * If \a cancellation is cancelled, parsing stops as soon as possible.
+     * Everything parsed up to that point is kept and an error is added.
+     *
+     * The file is parsed without blocking other functions of this
+     * StyleSheet, which keep returning what was parsed before. Once parsing
+     * finished, everything it parsed is added at once, as if parse() was
+     * called at that point. This modifies the StyleSheet, so spans, views and
+     * references returned before are invalidated. They must not be used
+     * while a parse started by this is pending, unless the future is waited
+     * for first. Other threads should use publishedSnapshot() instead.
+     *
+     * This StyleSheet may be destroyed before the returned future is ready,
+     * parsing then finishes in the background and the result is discarded.
+     */
+    std::future<void> parseAsync(const CancellationToken &cancellation = CancellationToken());
+    /*!
+     * Parse the file of this StyleSheet, using a cache in \a cacheDir.
+     *
+     * If \a cacheDir contains a cached parse result for this StyleSheet and
+     * none of the files that make up this StyleSheet changed since they were
+     * read for it, the cached result is used instead of parsing. Otherwise
+     * this behaves like parse() and stores the result in \a cacheDir
+     * afterwards.
+     *
+     * The cached result is also only used if the PropertyRegistry contains
+     * the same definitions as when it was parsed, ignoring the definitions
+     * this StyleSheet adds itself.
+     *
+     * \note The cache is only used if nothing was parsed into this StyleSheet
+     * before.
+     *
+     * \sa loadCached()
+     */
+    void parseCached(const std::filesystem::path &cacheDir);
     /*!
      * Parse a string containing CSS and add all rules to this StyleSheet.
      *
@@ -177,12 +684,184 @@ public:
      * errors.
      */
     void parseString(const std::string &data);
-
+    /*!
+     * Parse a string containing CSS and pass every rule to \a visitor as
+     * soon as it was parsed.
+     *
+     * \sa parse(RuleVisitor &)
+     */
+    void parseString(const std::string &data, RuleVisitor &visitor);
+    /*!
+     * Import a CSS file and add all its rules in this StyleSheet.
+     *
+     * This behaves as if \c{@import} was used with \a path. Relative paths
+     * are resolved relative to the path of this StyleSheet.
+     *
+     * \note Multiple calls will append to the internal list of rules and
+     * errors.
+     */
     void import(const std::filesystem::path &path);
+    /*!
+     * Set whether imported files should be read in parallel.
+     *
+     * When \a enabled is true, the files referenced by top-level \c{@import}
+     * rules are read concurrently before parsing. They are still parsed in
+     * the order they are imported, so the result is the same as without this
+     * option. This is disabled by default.
+     */
+    void setParallelImports(bool enabled);
+    /*!
+     * Set the number of threads used to parse large files to \a threads.
+     *
+     * Files are split into chunks of top-level rules at line breaks after
+     * the last \c{@import} or \c{@property} rule, which are parsed
+     * concurrently. The results are combined in source order, so they are
+     * the same as when parsing on a single thread. A value of 0 uses one
+     * thread per core. The default is 1, which parses on the calling thread
+     * only.
+     *
+     * Files are always parsed on a single thread if the parse options limit
+     * the number of errors or rules, or stop at the first error.
+     */
+    void setParseThreads(std::size_t threads);
+    /*!
+     * Set the limits used when parsing to \a options.
+     *
+     * Imported and reloaded files use the same limits. By default, nothing
+     * is limited.
+     */
+    void setParseOptions(const ParseOptions &options);
+    /*!
+     * Returns the limits used when parsing.
+     *
+     * \sa setParseOptions()
+     */
+    ParseOptions parseOptions() const;
+    /*!
+     * Set whether statistics about parsing are collected.
+     *
+     * This is disabled by default. Imported and reloaded files use the same
+     * setting.
+     *
+     * \sa statistics()
+     */
+    void setCollectStatistics(bool enabled);
+    /*!
+     * Returns the statistics collected while parsing this StyleSheet.
+     *
+     * Only what was parsed while collecting statistics was enabled is
+     * included.
+     */
+    ParseStatistics statistics() const;
+    /*!
+     * Returns the paths of the files that make up this StyleSheet and were
+     * modified since they were parsed.
+     *
+     * This only compares the modification time and size of each file, so it
+     * is cheap enough to be called periodically to watch for changes.
+     *
+     * \sa reloadModified()
+     */
+    std::vector<std::filesystem::path> modifiedPaths() const;
+    /*!
+     * Parse the file at \a path again and replace the rules it contributed.
+     *
+     * \a path can be any of paths(). The rules of all other files are kept,
+     * so only the returned ranges of rules change. If \a path is the path of
+     * this StyleSheet, everything is parsed again and rules added with
+     * parseString() are lost.
+     *
+     * Returns one entry for every time \a path is imported, or an empty list
+     * if \a path is not part of this StyleSheet or could not be parsed. In
+     * the latter case the error is added to errors().
+     *
+     * \note Reloading starts a new generation that contains all rules and
+     * errors, as any of them may have moved.
+     */
+    std::vector<ReloadedRules> reload(const std::filesystem::path &path);
+    /*!
+     * Reload all files returned by modifiedPaths().
+     *
+     * \sa reload()
+     */
+    std::vector<ReloadedRules> reloadModified();
+    /*!
+     * Returns an immutable snapshot of the current contents of this StyleSheet.
+     *
+     * If anything changed since the previous snapshot, a new one is created
+     * and published, so publishedSnapshot() returns it from then on.
+     * Otherwise the previous snapshot is returned.
+     *
+     * \note Like all other functions of StyleSheet, this needs to be called
+     * from the thread that modifies this StyleSheet. Other threads should use
+     * publishedSnapshot().
+     */
+    std::shared_ptr<const StyleSheetSnapshot> snapshot() const;
+    /*!
+     * Returns the snapshot that was last created by snapshot().
+     *
+     * This can be called from any thread, even while this StyleSheet is being
+     * modified. Returns an empty snapshot if snapshot() was never called.
+     */
+    std::shared_ptr<const StyleSheetSnapshot> publishedSnapshot() const;
+    /*!
+     * Set the ColorProvider used to resolve custom colors to \a provider.
+     *
+     * The provider is not owned by this StyleSheet and needs to stay valid
+     * until it is replaced or this StyleSheet is destroyed. Setting a provider
+     * discards all custom colors that were resolved using the previous one.
+     *
+     * \sa resolveCustomColors(), resolveColor()
+     */
+    void setColorProvider(Color::ColorProvider *provider);
+    /*!
+     * Resolve all custom colors used by this StyleSheet.
+     *
+     * The ColorProvider is called once for every distinct combination of
+     * source and arguments that is used by any rule and was not resolved
+     * before. The results are cached until they are invalidated with
+     * invalidateColorSource() or the provider is changed.
+     *
+     * \note Custom colors that are not resolved by this are resolved when
+     * resolveColor() first needs them.
+     */
+    void resolveCustomColors();
+    /*!
+     * Resolve the custom colors with \a source again.
+     *
+     * This calls the ColorProvider only for the cached custom colors that use
+     * \a source, for example when the palette that provides them changed.
+     * Other cached custom colors are kept.
+     */
+    void invalidateColorSource(std::string_view source);
+    /*!
+     * Returns \a color as a single RGBA value.
+     *
+     * Custom colors and modified colors that depend on them are resolved
+     * using the cached results of the ColorProvider. Returns std::nullopt if
+     * \a color is empty or a custom color it needs could not be resolved.
+     *
+     * \sa Color::Color::resolve()
+     */
+    std::optional<Color::RgbaData> resolveColor(const Color::Color &color) const;
+
+    /*!
+     * Create a StyleSheet for \a path and parse it using the cache in \a cacheDir.
+     *
+     * \sa parseCached()
+     */
+    static std::unique_ptr<StyleSheet> loadCached(const std::filesystem::path &path, const std::filesystem::path &cacheDir);
+
+    // Internal. Calls function with the rust StyleSheet backing this
+    // StyleSheet. It is locked while function runs, the reference must not
+    // be kept afterwards.
+    void withRustStyleSheet(const std::function<void(const rust::StyleSheet &)> &function) const;
 
 private:
     struct Private;
-    const std::unique_ptr<Private> d;
+    // Shared with the threads started by parseAsync(), nothing else holds a
+    // reference to it.
+    const std::shared_ptr<Private> d;
 };
 
 }
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#include "FragmentParser.h"
+
+#include "cxx-rust-cssparser-impl/src/ffi.rs.h"
+
+using namespace cssparser;
+
+std::size_t FragmentBatch::size() const
+{
+    return m_fragments.size();
+}
+
+std::span<const Rule> FragmentBatch::rules(std::size_t index) const
+{
+    const auto range = m_fragments.at(index).rules;
+    return std::span<const Rule>(m_rules.cbegin() + range.start, m_rules.cbegin() + range.end);
+}
+
+std::span<const Property> FragmentBatch::properties(std::size_t index) const
+{
+    const auto range = m_fragments.at(index).properties;
+    return std::span<const Property>(m_properties.cbegin() + range.start, m_properties.cbegin() + range.end);
+}
+
+std::span<const Error> FragmentBatch::errors(std::size_t index) const
+{
+    const auto range = m_fragments.at(index).errors;
+    return std::span<const Error>(m_errors.cbegin() + range.start, m_errors.cbegin() + range.end);
+}
+
+struct FragmentParser::Private
+{
+    Private(Mode mode, const PropertyRegistry &registry)
+        : registry(registry)
+        , parser(rust::create_fragment_parser(mode == Mode::Declarations ? rust::FragmentKind::Declarations : rust::FragmentKind::Rules,
+                                              registry.rustRegistry()))
+    {
+    }
+
+    PropertyRegistry registry;
+    ::rust::Box<rust::FragmentParser> parser;
+};
+
+FragmentParser::FragmentParser(Mode mode)
+    : FragmentParser(mode, PropertyRegistry::global())
+{
+}
+
+FragmentParser::FragmentParser(Mode mode, const PropertyRegistry &registry)
+    : d(std::make_unique<Private>(mode, registry))
+{
+}
+
+FragmentParser::~FragmentParser() = default;
+
+void FragmentParser::setOrigin(const std::filesystem::path &path)
+{
+    d->parser->set_origin(path.string());
+}
+
+FragmentBatch FragmentParser::parseFragments(std::span<const std::string_view> fragments) const
+{
+    // All fragments are passed to Rust as a single buffer, so only one
+    // buffer needs to be created instead of one string per fragment. It is
+    // passed as bytes rather than a string so Rust can check each fragment
+    // for invalid UTF-8 separately.
+    std::string data;
+    std::vector<std::size_t> ends;
+    ends.reserve(fragments.size());
+    for (const auto &fragment : fragments) {
+        data.append(fragment);
+        ends.push_back(data.size());
+    }
+
+    const auto bytes = ::rust::Slice<const std::uint8_t>(reinterpret_cast<const std::uint8_t *>(data.data()), data.size());
+    const auto rustBatch = d->parser->parse_fragments(bytes, ::rust::Slice<const std::size_t>(ends.data(), ends.size()));
+
+    FragmentBatch result;
+    const auto count = rustBatch->fragment_count();
+    result.m_fragments.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto ranges = rustBatch->fragment_ranges(i);
+        result.m_fragments.push_back(FragmentBatch::Fragment{
+            .rules = {ranges.rules_start, ranges.rules_end},
+            .properties = {ranges.properties_start, ranges.properties_end},
+            .errors = {ranges.errors_start, ranges.errors_end},
+        });
+    }
+
+    if (count > 0) {
+        const auto &last = result.m_fragments.back();
+        result.m_rules.reserve(last.rules.end);
+        for (std::size_t i = 0; i < last.rules.end; ++i) {
+            result.m_rules.push_back(Rule::fromRust(rustBatch->rule_at(i)));
+        }
+
+        result.m_properties.reserve(last.properties.end);
+        for (std::size_t i = 0; i < last.properties.end; ++i) {
+            result.m_properties.push_back(Property::fromRust(rustBatch->property_at(i)));
+        }
+    }
+
+    for (const auto &entry : rustBatch->all_errors()) {
+        result.m_errors.push_back(Error{
+            .file = std::string(entry.file),
+            .line = entry.line,
+            .column = entry.column,
+            .message = std::string(entry.message),
+        });
+    }
+
+    return result;
+}
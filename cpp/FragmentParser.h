@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "CssParser.h"
+#include "PropertyRegistry.h"
+
+#include "cssparser_export.h"
+
+namespace cssparser
+{
+namespace rust
+{
+struct FragmentParser;
+}
+
+/*!
+ * \class cssparser::FragmentBatch
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief The results of parsing a number of fragments with FragmentParser.
+ *
+ * The rules, properties and errors of all fragments are stored together,
+ * each fragment refers to a range of them.
+ */
+class CSSPARSER_EXPORT FragmentBatch
+{
+public:
+    /*!
+     * Returns the number of fragments that were parsed.
+     */
+    std::size_t size() const;
+    /*!
+     * Returns the rules of the fragment at \a index.
+     *
+     * The source order of each rule is its position within the fragment.
+     * This is always empty when parsing declarations.
+     */
+    std::span<const Rule> rules(std::size_t index) const;
+    /*!
+     * Returns the properties of the fragment at \a index.
+     *
+     * This is always empty when parsing rules.
+     */
+    std::span<const Property> properties(std::size_t index) const;
+    /*!
+     * Returns the errors that happened while parsing the fragment at \a index.
+     */
+    std::span<const Error> errors(std::size_t index) const;
+
+private:
+    friend class FragmentParser;
+
+    struct Range {
+        std::size_t start = 0;
+        std::size_t end = 0;
+    };
+
+    struct Fragment {
+        Range rules;
+        Range properties;
+        Range errors;
+    };
+
+    std::vector<Fragment> m_fragments;
+    std::vector<Rule> m_rules;
+    std::vector<Property> m_properties;
+    std::vector<Error> m_errors;
+};
+
+/*!
+ * \class cssparser::FragmentParser
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief Parses many small pieces of CSS at once.
+ *
+ * Parsing small pieces of CSS like the inline styles of widgets as separate
+ * StyleSheets has a lot of overhead compared to the time spent parsing them.
+ * FragmentParser parses many of them in one call and stores the results of
+ * all of them together.
+ *
+ * Property definitions from custom properties or \c{@property} rules are
+ * added to the registry. \c{@import} is not supported.
+ */
+class CSSPARSER_EXPORT FragmentParser
+{
+public:
+    /*!
+     * What the fragments contain.
+     *
+     * \value Rules Fragments contain rules, like a StyleSheet.
+     * \value Declarations Fragments only contain declarations, like the
+     * contents of a \c{style} attribute.
+     */
+    enum class Mode {
+        Rules,
+        Declarations,
+    };
+
+    /*!
+     * Constructs a FragmentParser that parses fragments as \a mode, using the
+     * global PropertyRegistry.
+     */
+    explicit FragmentParser(Mode mode = Mode::Rules);
+    /*!
+     * Constructs a FragmentParser that parses fragments as \a mode, using
+     * \a registry to look up and store property definitions.
+     */
+    FragmentParser(Mode mode, const PropertyRegistry &registry);
+    ~FragmentParser();
+
+    /*!
+     * Set the path that errors are reported from to \a path.
+     *
+     * Relative URLs are resolved relative to \a path as well.
+     */
+    void setOrigin(const std::filesystem::path &path);
+
+    /*!
+     * Parse every entry of \a fragments separately.
+     *
+     * The returned batch contains one result for each fragment, in the same
+     * order. A fragment that is not valid UTF-8 is not parsed and only has an
+     * error, the other fragments are parsed as usual.
+     */
+    FragmentBatch parseFragments(std::span<const std::string_view> fragments) const;
+
+private:
+    struct Private;
+    const std::unique_ptr<Private> d;
+};
+
+}
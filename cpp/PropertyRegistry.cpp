@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#include "PropertyRegistry.h"
+
+#include "cxx-rust-cssparser-impl/src/ffi.rs.h"
+
+using namespace cssparser;
+
+struct PropertyRegistry::Private
+{
+    Private(::rust::Box<rust::PropertyRegistry> &&registry)
+        : registry(std::move(registry))
+    {
+    }
+
+    ::rust::Box<rust::PropertyRegistry> registry;
+};
+
+PropertyRegistry::PropertyRegistry()
+    : d(std::make_unique<Private>(rust::create_property_registry()))
+{
+}
+
+PropertyRegistry::PropertyRegistry(std::unique_ptr<Private> &&d)
+    : d(std::move(d))
+{
+}
+
+PropertyRegistry::PropertyRegistry(const PropertyRegistry &other)
+    : d(std::make_unique<Private>(rust::clone_property_registry(*other.d->registry)))
+{
+}
+
+PropertyRegistry::~PropertyRegistry() = default;
+
+PropertyRegistry &PropertyRegistry::operator=(const PropertyRegistry &other)
+{
+    if (this != &other) {
+        d->registry = rust::clone_property_registry(*other.d->registry);
+    }
+    return *this;
+}
+
+bool PropertyRegistry::operator==(const PropertyRegistry &other) const
+{
+    return d->registry->is_same(*other.d->registry);
+}
+
+bool PropertyRegistry::contains(std::string_view name) const
+{
+    return d->registry->contains(::rust::Str(name.data(), name.size()));
+}
+
+PropertyRegistry PropertyRegistry::withParent(const PropertyRegistry &parent)
+{
+    return PropertyRegistry(std::make_unique<Private>(rust::create_property_registry_with_parent(*parent.d->registry)));
+}
+
+PropertyRegistry PropertyRegistry::global()
+{
+    return PropertyRegistry(std::make_unique<Private>(rust::global_property_registry()));
+}
+
+const rust::PropertyRegistry &PropertyRegistry::rustRegistry() const
+{
+    return *d->registry;
+}
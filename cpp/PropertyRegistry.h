@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#pragma once
+
+#include <memory>
+#include <string_view>
+
+#include "cssparser_export.h"
+
+namespace cssparser
+{
+namespace rust
+{
+struct PropertyRegistry;
+}
+
+/*!
+ * \class cssparser::PropertyRegistry
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief A collection of property definitions used while parsing.
+ *
+ * Every StyleSheet looks up the definitions of the properties it contains in
+ * a PropertyRegistry and adds definitions from \c{@property} rules and custom
+ * properties to it. By default, all StyleSheets share the global registry.
+ * Giving StyleSheets their own registry keeps their definitions separate,
+ * which allows parsing them independently and frees the definitions together
+ * with the StyleSheets using them.
+ *
+ * A registry can have a parent registry. Definitions that are not found in a
+ * registry are looked up in its parent, but new definitions are only added to
+ * the registry itself. This can be used to share a common set of definitions
+ * between a number of registries.
+ *
+ * PropertyRegistry is a handle, copies refer to the same registry.
+ */
+class CSSPARSER_EXPORT PropertyRegistry
+{
+public:
+    /*!
+     * Constructs a new, empty registry without a parent.
+     */
+    PropertyRegistry();
+    PropertyRegistry(const PropertyRegistry &other);
+    ~PropertyRegistry();
+
+    PropertyRegistry &operator=(const PropertyRegistry &other);
+
+    /*!
+     * Returns true if \a other refers to the same registry as this one.
+     */
+    bool operator==(const PropertyRegistry &other) const;
+
+    /*!
+     * Returns true if this registry or any of its parents contain a
+     * definition for the property \a name.
+     */
+    bool contains(std::string_view name) const;
+
+    /*!
+     * Returns a new, empty registry that uses \a parent as parent.
+     */
+    static PropertyRegistry withParent(const PropertyRegistry &parent);
+    /*!
+     * Returns the global registry.
+     *
+     * This is the registry used by StyleSheets that were not given a
+     * registry explicitly.
+     */
+    static PropertyRegistry global();
+
+    // Internal. Returns the rust PropertyRegistry this refers to.
+    const rust::PropertyRegistry &rustRegistry() const;
+
+private:
+    struct Private;
+    PropertyRegistry(std::unique_ptr<Private> &&d);
+    std::unique_ptr<Private> d;
+};
+
+}
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#pragma once
+
+// Internal header, this is included by the generated rust bridge so it
+// cannot depend on anything else of this library.
+
+namespace cssparser
+{
+namespace rust
+{
+struct StyleRule;
+}
+
+// Internal. Passed to the rust side while parsing with a RuleVisitor, to call
+// back into C++ for every parsed rule.
+class RuleVisitorAdapter
+{
+public:
+    using Callback = void (*)(void *context, const rust::StyleRule &rule);
+
+    RuleVisitorAdapter(Callback callback, void *context)
+        : m_callback(callback)
+        , m_context(context)
+    {
+    }
+
+    void visit_rule(const rust::StyleRule &rule) const
+    {
+        m_callback(m_context, rule);
+    }
+
+private:
+    Callback m_callback;
+    void *m_context;
+};
+
+}
@@ -4,6 +4,7 @@
 #include "Selector.h"
 
 #include <format>
+#include <stdexcept>
 
 #include "cxx-rust-cssparser-impl/src/ffi.rs.h"
 
@@ -28,6 +29,18 @@ SelectorPart::SelectorPart(Kind kind, const Value &value, std::optional<Attribut
     , m_value(value)
     , m_attributeMatch(match)
 {
+    switch (kind) {
+    case Kind::Type:
+    case Kind::Class:
+    case Kind::Id:
+    case Kind::PseudoClass:
+        if (value.type() == Value::Type::String) {
+            m_atom = Atom(value.get<std::string>());
+        }
+        break;
+    default:
+        break;
+    }
 }
 
 std::string kindToString(SelectorPart::Kind kind)
@@ -139,9 +152,10 @@ SelectorPart SelectorPart::fromRust(const rust::SelectorPart &rustData)
 
     result.m_kind = convertKind(rustData.kind());
     result.m_value = Value::fromRust(rustData.value());
+    result.m_atom = Atom::fromId(rustData.value_atom());
 
     if (rustData.attribute_operator() != rust::AttributeOperator::None) {
-        result.m_attributeMatch = AttributeMatch{std::string(rustData.attribute_name()),
+        result.m_attributeMatch = AttributeMatch{std::string(rustData.attribute_name_str()),
                                                  convertMatchOperator(rustData.attribute_operator()),
                                                  Value::fromRust(rustData.attribute_value())};
     }
@@ -177,11 +191,96 @@ Selector Selector::fromRust(const rust::Selector &rustData)
 {
     auto result = Selector();
 
-    std::ranges::transform(rustData.parts(), std::back_inserter(result.m_parts), [](const auto &part) {
-        return SelectorPart::fromRust(part);
-    });
+    const auto count = rustData.part_count();
+    result.m_parts.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        result.m_parts.push_back(SelectorPart::fromRust(rustData.part_at(i)));
+    }
 
     return result;
 }
 
+SelectorPartView::SelectorPartView(const rust::SelectorPart &rustData)
+    : m_part(&rustData)
+{
+}
+
+bool SelectorPartView::isCombinator() const
+{
+    return int(kind()) > int(SelectorPart::Kind::CombinatorStart);
+}
+
+SelectorPart::Kind SelectorPartView::kind() const
+{
+    return convertKind(m_part->kind());
+}
+
+ValueView SelectorPartView::value() const
+{
+    return ValueView(m_part->value());
+}
+
+Atom SelectorPartView::atom() const
+{
+    return Atom::fromId(m_part->value_atom());
+}
+
+AttributeMatch::Operator SelectorPartView::attributeOperator() const
+{
+    return convertMatchOperator(m_part->attribute_operator());
+}
+
+std::string_view SelectorPartView::attributeName() const
+{
+    const auto name = m_part->attribute_name_str();
+    return std::string_view(name.data(), name.size());
+}
+
+ValueView SelectorPartView::attributeValue() const
+{
+    return ValueView(m_part->attribute_value());
+}
+
+SelectorPart SelectorPartView::toSelectorPart() const
+{
+    return SelectorPart::fromRust(*m_part);
+}
+
+SelectorView::SelectorView(const rust::Selector &rustData)
+    : m_selector(&rustData)
+{
+}
+
+std::size_t SelectorView::partCount() const
+{
+    return m_selector->part_count();
+}
+
+SelectorPartView SelectorView::part(std::size_t index) const
+{
+    if (index >= partCount()) {
+        throw std::out_of_range("Selector part index out of range");
+    }
+
+    return SelectorPartView(m_selector->part_at(index));
+}
+
+std::vector<SelectorPartView> SelectorView::parts() const
+{
+    std::vector<SelectorPartView> result;
+
+    const auto count = partCount();
+    result.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        result.emplace_back(m_selector->part_at(i));
+    }
+
+    return result;
+}
+
+Selector SelectorView::toSelector() const
+{
+    return Selector::fromRust(*m_selector);
+}
+
 }
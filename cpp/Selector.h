@@ -3,8 +3,11 @@
 
 #pragma once
 
+#include <compare>
 #include <span>
+#include <string_view>
 
+#include "Atom.h"
 #include "Value.h"
 
 #include "cssparser_export.h"
@@ -104,6 +107,16 @@ public:
         return m_value;
     }
 
+    /*!
+     * Returns the name used by a Type, Class, Id or PseudoClass part as an Atom.
+     *
+     * Returns the empty Atom for other kinds of parts.
+     */
+    inline Atom atom() const
+    {
+        return m_atom;
+    }
+
     inline std::optional<AttributeMatch> attributeMatch() const
     {
         return m_attributeMatch;
@@ -116,9 +129,26 @@ public:
 private:
     Kind m_kind = Kind::Unknown;
     Value m_value;
+    Atom m_atom;
     std::optional<AttributeMatch> m_attributeMatch;
 };
 
+/*!
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief The specificity of a selector.
+ *
+ * Pseudo-classes, \c{:root} and attribute selectors count as classes.
+ * Specificities compare component-wise, starting with ids.
+ */
+struct CSSPARSER_EXPORT Specificity {
+    uint32_t ids = 0;
+    uint32_t classes = 0;
+    uint32_t types = 0;
+
+    auto operator<=>(const Specificity &other) const = default;
+};
+
 /*!
  * \class cssparser::Selector
  *
@@ -143,4 +173,85 @@ private:
     std::vector<SelectorPart> m_parts;
 };
 
+/*!
+ * \class cssparser::SelectorPartView
+ *
+ * \brief A non-owning view on a SelectorPart that is part of a StyleSheet.
+ *
+ * The view is only valid as long as the StyleSheet it was retrieved from is
+ * alive and has not been modified.
+ */
+class CSSPARSER_EXPORT SelectorPartView
+{
+public:
+    // Internal. Constructs a view on a rust SelectorPart.
+    explicit SelectorPartView(const rust::SelectorPart &rustData);
+
+    bool isCombinator() const;
+    SelectorPart::Kind kind() const;
+    ValueView value() const;
+    /*!
+     * Returns the name used by the viewed part as an Atom.
+     *
+     * \sa SelectorPart::atom()
+     */
+    Atom atom() const;
+
+    /*!
+     * Returns the operator of the attribute match of this part.
+     *
+     * This is AttributeMatch::Operator::None if this part is not an attribute
+     * selector.
+     */
+    AttributeMatch::Operator attributeOperator() const;
+    std::string_view attributeName() const;
+    ValueView attributeValue() const;
+
+    /*!
+     * Returns a copy of the viewed SelectorPart.
+     */
+    SelectorPart toSelectorPart() const;
+
+private:
+    const rust::SelectorPart *m_part;
+};
+
+/*!
+ * \class cssparser::SelectorView
+ *
+ * \brief A non-owning view on a Selector that is part of a StyleSheet.
+ *
+ * The view is only valid as long as the StyleSheet it was retrieved from is
+ * alive and has not been modified.
+ */
+class CSSPARSER_EXPORT SelectorView
+{
+public:
+    // Internal. Constructs a view on a rust Selector.
+    explicit SelectorView(const rust::Selector &rustData);
+
+    /*!
+     * Returns the number of parts of the viewed selector.
+     */
+    std::size_t partCount() const;
+    /*!
+     * Returns a view on the part at \a index.
+     *
+     * Throws std::out_of_range if \a index is not smaller than partCount().
+     */
+    SelectorPartView part(std::size_t index) const;
+    /*!
+     * Returns views on all parts of the viewed selector.
+     */
+    std::vector<SelectorPartView> parts() const;
+
+    /*!
+     * Returns a copy of the viewed Selector.
+     */
+    Selector toSelector() const;
+
+private:
+    const rust::Selector *m_selector;
+};
+
 }
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#include "StyleMatcher.h"
+
+#include <optional>
+
+#include "CssParser.h"
+
+#include "cxx-rust-cssparser-impl/src/ffi.rs.h"
+
+using namespace cssparser;
+
+// The Rust StyleMatcher copies what it needs, so the StyleSheet only needs to
+// stay locked while it is created.
+static ::rust::Box<rust::StyleMatcher> createMatcher(const StyleSheet &styleSheet)
+{
+    std::optional<::rust::Box<rust::StyleMatcher>> matcher;
+    styleSheet.withRustStyleSheet([&matcher](const rust::StyleSheet &stylesheet) {
+        matcher.emplace(rust::create_style_matcher(stylesheet));
+    });
+    return std::move(*matcher);
+}
+
+struct StyleMatcher::Private
+{
+    Private(const StyleSheet &styleSheet)
+        : styleSheet(styleSheet)
+        , matcher(createMatcher(styleSheet))
+    {
+    }
+
+    const StyleSheet &styleSheet;
+    ::rust::Box<rust::StyleMatcher> matcher;
+};
+
+StyleMatcher::StyleMatcher(const StyleSheet &styleSheet)
+    : d(std::make_unique<Private>(styleSheet))
+{
+}
+
+StyleMatcher::~StyleMatcher() = default;
+
+inline ::rust::Vec<::rust::String> convertStrings(const std::vector<std::string> &strings)
+{
+    ::rust::Vec<::rust::String> result;
+    result.reserve(strings.size());
+    for (const auto &string : strings) {
+        result.push_back(::rust::String(string));
+    }
+    return result;
+}
+
+std::vector<std::size_t> StyleMatcher::matchingRuleIndices(std::span<const Element> elements) const
+{
+    std::vector<rust::MatchElement> rustElements;
+    rustElements.reserve(elements.size());
+
+    for (const auto &element : elements) {
+        ::rust::Vec<rust::MatchAttribute> attributes;
+        for (const auto &[name, value] : element.attributes) {
+            attributes.push_back(rust::MatchAttribute{
+                .name = ::rust::String(name),
+                .value = ::rust::String(value),
+            });
+        }
+
+        rustElements.push_back(rust::MatchElement{
+            .type_name = ::rust::String(element.type),
+            .id = ::rust::String(element.id),
+            .classes = convertStrings(element.classes),
+            .pseudo_classes = convertStrings(element.pseudoClasses),
+            .attributes = std::move(attributes),
+        });
+    }
+
+    const auto indices = d->matcher->match_elements(::rust::Slice<const rust::MatchElement>(rustElements.data(), rustElements.size()));
+    return std::vector<std::size_t>(indices.begin(), indices.end());
+}
+
+std::vector<const Rule *> StyleMatcher::matchingRules(std::span<const Element> elements) const
+{
+    const auto rules = d->styleSheet.rules();
+
+    std::vector<const Rule *> result;
+    for (auto index : matchingRuleIndices(elements)) {
+        result.push_back(&rules[index]);
+    }
+    return result;
+}
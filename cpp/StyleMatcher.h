@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cssparser_export.h"
+
+namespace cssparser
+{
+namespace rust
+{
+struct StyleMatcher;
+}
+
+class Rule;
+class StyleSheet;
+
+/*!
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief A description of an element that rules can be matched against.
+ */
+struct CSSPARSER_EXPORT Element {
+    std::string type;
+    std::string id;
+    std::vector<std::string> classes;
+    std::vector<std::string> pseudoClasses;
+    std::vector<std::pair<std::string, std::string>> attributes;
+};
+
+/*!
+ * \class cssparser::StyleMatcher
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief Finds the rules of a StyleSheet that apply to an element.
+ *
+ * StyleMatcher indexes the rules of a StyleSheet by the id, class, type or
+ * pseudo-class that their selector requires on the element it applies to.
+ * Matching an element only checks the rules that could possibly apply to it,
+ * instead of every rule in the StyleSheet. Rules that require ancestors with
+ * a certain id, class or type are rejected using a bloom filter of the
+ * ancestors, so most of them never need to walk the ancestors.
+ *
+ * The index is built when the StyleMatcher is constructed. If the StyleSheet
+ * is changed afterwards, a new StyleMatcher needs to be created.
+ */
+class CSSPARSER_EXPORT StyleMatcher
+{
+public:
+    /*!
+     * Constructs a StyleMatcher for the rules of \a styleSheet.
+     *
+     * \a styleSheet needs to outlive this StyleMatcher.
+     */
+    explicit StyleMatcher(const StyleSheet &styleSheet);
+    ~StyleMatcher();
+
+    /*!
+     * Returns the indices of the rules that match an element.
+     *
+     * The first entry of \a elements is the element to match, the remaining
+     * entries are its ancestors, starting with its parent. The last entry is
+     * considered to be the document root.
+     *
+     * The indices refer to StyleSheet::rules() and are sorted by specificity
+     * and then by source order, so applying the rules in the returned order
+     * results in the correct cascade.
+     */
+    std::vector<std::size_t> matchingRuleIndices(std::span<const Element> elements) const;
+    /*!
+     * Returns the rules that match an element.
+     *
+     * This is the same as matchingRuleIndices(), but returns pointers to the
+     * rules in StyleSheet::rules() instead.
+     */
+    std::vector<const Rule *> matchingRules(std::span<const Element> elements) const;
+
+private:
+    struct Private;
+    const std::unique_ptr<Private> d;
+};
+
+}
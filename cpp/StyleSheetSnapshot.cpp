@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#include "StyleSheetSnapshot.h"
+
+using namespace cssparser;
+
+StyleSheetSnapshot::StyleSheetSnapshot()
+{
+}
+
+StyleSheetSnapshot::StyleSheetSnapshot(std::vector<Rule> &&rules,
+                                       std::vector<std::size_t> &&cascadeOrder,
+                                       std::vector<Error> &&errors,
+                                       std::vector<std::filesystem::path> &&paths,
+                                       std::size_t generation)
+    : m_rules(std::move(rules))
+    , m_cascadeOrder(std::move(cascadeOrder))
+    , m_errors(std::move(errors))
+    , m_paths(std::move(paths))
+    , m_generation(generation)
+{
+}
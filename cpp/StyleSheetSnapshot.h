@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "CssParser.h"
+
+#include "cssparser_export.h"
+
+namespace cssparser
+{
+
+/*!
+ * \class cssparser::StyleSheetSnapshot
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief An immutable copy of the contents of a StyleSheet.
+ *
+ * A StyleSheetSnapshot contains everything a StyleSheet provides at the time
+ * it was created and never changes afterwards. It does not refer to the
+ * StyleSheet it was created from, so it can be shared and read from any
+ * number of threads without locking, while the StyleSheet itself is modified
+ * on another thread.
+ *
+ * \sa StyleSheet::snapshot(), StyleSheet::publishedSnapshot()
+ */
+class CSSPARSER_EXPORT StyleSheetSnapshot
+{
+public:
+    /*!
+     * Constructs an empty StyleSheetSnapshot.
+     */
+    StyleSheetSnapshot();
+    /*!
+     * Constructs a StyleSheetSnapshot from its contents.
+     */
+    StyleSheetSnapshot(std::vector<Rule> &&rules,
+                       std::vector<std::size_t> &&cascadeOrder,
+                       std::vector<Error> &&errors,
+                       std::vector<std::filesystem::path> &&paths,
+                       std::size_t generation);
+
+    /*!
+     * The rules of the StyleSheet.
+     *
+     * \sa StyleSheet::rules()
+     */
+    inline std::span<const Rule> rules() const
+    {
+        return std::span<const Rule>(m_rules.cbegin(), m_rules.cend());
+    }
+    /*!
+     * The indices of rules() sorted by their position in the cascade.
+     *
+     * \sa StyleSheet::cascadeOrder()
+     */
+    inline std::span<const std::size_t> cascadeOrder() const
+    {
+        return std::span<const std::size_t>(m_cascadeOrder.cbegin(), m_cascadeOrder.cend());
+    }
+    /*!
+     * The errors of the StyleSheet.
+     *
+     * \sa StyleSheet::errors()
+     */
+    inline std::span<const Error> errors() const
+    {
+        return std::span<const Error>(m_errors.cbegin(), m_errors.cend());
+    }
+    /*!
+     * The files that were parsed by the StyleSheet.
+     *
+     * \sa StyleSheet::paths()
+     */
+    inline std::span<const std::filesystem::path> paths() const
+    {
+        return std::span<const std::filesystem::path>(m_paths.cbegin(), m_paths.cend());
+    }
+    /*!
+     * The generation of the StyleSheet this snapshot was created at.
+     *
+     * \sa StyleSheet::generation()
+     */
+    inline std::size_t generation() const
+    {
+        return m_generation;
+    }
+
+private:
+    std::vector<Rule> m_rules;
+    std::vector<std::size_t> m_cascadeOrder;
+    std::vector<Error> m_errors;
+    std::vector<std::filesystem::path> m_paths;
+    std::size_t m_generation = 0;
+};
+
+}
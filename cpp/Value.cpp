@@ -3,7 +3,11 @@
 
 #include "Value.h"
 
+#include <atomic>
+#include <cstring>
 #include <format>
+#include <stdexcept>
+#include <variant>
 
 #include "cxx-rust-cssparser-impl/src/ffi.rs.h"
 
@@ -92,10 +96,220 @@ Dimension Dimension::fromRust(rust::Dimension rustData)
     return Dimension{convertUnit(rustData.unit), rustData.value};
 }
 
+// Out-of-line data for values that do not fit inline. It is shared by all
+// copies of a value and freed when the last copy is destroyed.
+struct Value::Shared {
+    std::atomic<uint32_t> references = 1;
+    std::string string;
+    Color::Color color;
+};
+
+static_assert(sizeof(Value) == 16, "Value should be 16 bytes");
+static_assert(sizeof(Dimension) <= 8, "Dimension should fit in the aligned part of Value");
+static_assert(std::is_trivially_copyable_v<Dimension>, "Value::packedDimension() copies Dimension with memcpy");
+static_assert(sizeof(Color::RgbaData) <= 8, "RgbaData should fit in the aligned part of Value");
+
+template<typename T>
+inline void storeAligned(char *data, const T &value)
+{
+    std::memcpy(data, &value, sizeof(T));
+}
+
+template<typename T>
+inline T loadAligned(const char *data)
+{
+    T result;
+    std::memcpy(&result, data, sizeof(T));
+    return result;
+}
+
 Value::Value()
 {
 }
 
+Value::Value(const Value &other)
+    : m_type(other.m_type)
+    , m_storage(other.m_storage)
+    , m_size(other.m_size)
+{
+    std::memcpy(m_data, other.m_data, sizeof(m_data));
+    if (m_storage == Storage::Shared) {
+        shared()->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+Value::Value(Value &&other) noexcept
+    : m_type(other.m_type)
+    , m_storage(other.m_storage)
+    , m_size(other.m_size)
+{
+    std::memcpy(m_data, other.m_data, sizeof(m_data));
+    other.m_type = Type::Empty;
+    other.m_storage = Storage::None;
+}
+
+Value::~Value()
+{
+    release();
+}
+
+Value &Value::operator=(const Value &other)
+{
+    if (this != &other) {
+        *this = Value(other);
+    }
+    return *this;
+}
+
+Value &Value::operator=(Value &&other) noexcept
+{
+    if (this != &other) {
+        release();
+
+        m_type = other.m_type;
+        m_storage = other.m_storage;
+        m_size = other.m_size;
+        std::memcpy(m_data, other.m_data, sizeof(m_data));
+
+        other.m_type = Type::Empty;
+        other.m_storage = Storage::None;
+    }
+    return *this;
+}
+
+std::string_view Value::string() const
+{
+    if (m_type != Type::String && m_type != Type::Image && m_type != Type::Url) {
+        return std::string_view{};
+    }
+
+    switch (m_storage) {
+    case Storage::None:
+        return std::string_view{};
+    case Storage::Inline:
+        return std::string_view(m_data, m_size);
+    case Storage::Shared:
+        return shared()->string;
+    }
+
+    return std::string_view{};
+}
+
+void Value::set(std::nullopt_t)
+{
+}
+
+void Value::set(const Dimension &dimension)
+{
+    m_storage = Storage::Inline;
+    storeAligned(m_data + AlignedOffset, dimension);
+}
+
+void Value::set(std::string_view string)
+{
+    if (string.size() <= InlineStringSize) {
+        m_storage = Storage::Inline;
+        m_size = uint8_t(string.size());
+        std::memcpy(m_data, string.data(), string.size());
+        return;
+    }
+
+    auto data = new Shared{};
+    data->string = std::string(string);
+    m_storage = Storage::Shared;
+    storeAligned(m_data + AlignedOffset, data);
+}
+
+void Value::set(const Color::Color &color)
+{
+    switch (color.type()) {
+    case Color::Color::Type::Empty:
+        m_storage = Storage::None;
+        break;
+    case Color::Color::Type::Rgba:
+        m_storage = Storage::Inline;
+        storeAligned(m_data + AlignedOffset, color.get<Color::RgbaData>());
+        break;
+    default: {
+        // Custom and modified colors are rare, so only those pay for an
+        // allocation.
+        auto data = new Shared{};
+        data->color = color;
+        m_storage = Storage::Shared;
+        storeAligned(m_data + AlignedOffset, data);
+        break;
+    }
+    }
+}
+
+void Value::set(int integer)
+{
+    m_storage = Storage::Inline;
+    storeAligned(m_data + AlignedOffset, integer);
+}
+
+Dimension Value::dimension() const
+{
+    if (m_type != Type::Dimension) {
+        throw std::bad_variant_access{};
+    }
+
+    return loadAligned<Dimension>(m_data + AlignedOffset);
+}
+
+std::string_view Value::checkedString() const
+{
+    if (m_type != Type::String && m_type != Type::Image && m_type != Type::Url) {
+        throw std::bad_variant_access{};
+    }
+
+    return string();
+}
+
+Color::Color Value::color() const
+{
+    if (m_type != Type::Color) {
+        throw std::bad_variant_access{};
+    }
+
+    switch (m_storage) {
+    case Storage::None:
+        return Color::Color{};
+    case Storage::Inline:
+        return Color::Color{Color::Color::Type::Rgba, loadAligned<Color::RgbaData>(m_data + AlignedOffset)};
+    case Storage::Shared:
+        return shared()->color;
+    }
+
+    return Color::Color{};
+}
+
+int Value::integer() const
+{
+    if (m_type != Type::Integer) {
+        throw std::bad_variant_access{};
+    }
+
+    return loadAligned<int>(m_data + AlignedOffset);
+}
+
+Value::Shared *Value::shared() const
+{
+    return loadAligned<Shared *>(m_data + AlignedOffset);
+}
+
+void Value::release()
+{
+    if (m_storage == Storage::Shared) {
+        auto data = shared();
+        if (data->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete data;
+        }
+    }
+
+    m_storage = Storage::None;
+}
+
 inline Value::Type convertType(rust::ValueType rustType)
 {
     switch (rustType) {
@@ -149,18 +363,18 @@ std::string Value::toString() const
         data = "(Empty)";
         break;
     case Value::Type::Dimension:
-        data = std::get<Dimension>(m_data).toString();
+        data = dimension().toString();
         break;
     case Value::Type::String:
     case Value::Type::Image:
     case Value::Type::Url:
-        data = std::get<std::string>(m_data);
+        data = std::string(string());
         break;
     case Value::Type::Color:
-        data = std::get<Color::Color>(m_data).toString();
+        data = color().toString();
         break;
     case Value::Type::Integer:
-        data = std::to_string(std::get<int>(m_data));
+        data = std::to_string(integer());
     }
 
     return std::format("Value(type: {}, data: {})", valueTypeToString(m_type), data);
@@ -175,26 +389,71 @@ Value Value::fromRust(const rust::Value &rustData)
     case rust::ValueType::Empty:
         break;
     case rust::ValueType::Dimension:
-        result.m_data = Dimension::fromRust(rustData.to_dimension());
+        result.set(Dimension::fromRust(rustData.to_dimension()));
         break;
     case rust::ValueType::String:
-        result.m_data = std::string(rustData.to_string());
-        break;
     case rust::ValueType::Image:
-        result.m_data = std::string(rustData.to_image());
-        break;
-    case rust::ValueType::Url:
-        result.m_data = std::string(rustData.to_url());
+    case rust::ValueType::Url: {
+        // as_str() borrows the contents of all string types, which avoids
+        // creating an intermediate std::string.
+        const auto string = rustData.as_str();
+        result.set(std::string_view(string.data(), string.size()));
         break;
+    }
     case rust::ValueType::Color:
-        result.m_data = Color::Color::fromRust(rustData.to_color());
+        result.set(Color::Color::fromRust(rustData.to_color()));
         break;
     case rust::ValueType::Integer:
-        result.m_data = rustData.to_integer();
+        result.set(int(rustData.to_integer()));
         break;
     }
 
     return result;
 }
 
+ValueView::ValueView(const rust::Value &rustData)
+    : m_value(&rustData)
+{
+}
+
+Value::Type ValueView::type() const
+{
+    return convertType(m_value->value_type());
+}
+
+Dimension ValueView::dimension() const
+{
+    return Dimension::fromRust(m_value->to_dimension());
+}
+
+Dimension::Packed ValueView::packedDimension() const
+{
+    if (m_value->value_type() != rust::ValueType::Dimension) {
+        return Dimension::Packed{};
+    }
+
+    return dimension().packed();
+}
+
+std::string_view ValueView::string() const
+{
+    const auto str = m_value->as_str();
+    return std::string_view(str.data(), str.size());
+}
+
+Color::Color ValueView::color() const
+{
+    return Color::Color::fromRust(m_value->to_color());
+}
+
+int ValueView::integer() const
+{
+    return m_value->to_integer();
+}
+
+Value ValueView::toValue() const
+{
+    return Value::fromRust(*m_value);
+}
+
 }
@@ -3,8 +3,13 @@
 
 #pragma once
 
+#include <array>
+#include <cstring>
 #include <format>
+#include <numbers>
 #include <sstream>
+#include <string_view>
+#include <type_traits>
 
 #include "Color.h"
 
@@ -78,6 +83,51 @@ public:
         Milliseconds,
     };
 
+    /*!
+     * \enum cssparser::Dimension::UnitClass
+     *
+     * What a dimension measures, independent of the unit it was written in.
+     *
+     * \value None
+     *      The unit is unknown or unsupported.
+     * \value Number
+     *      A unitless number.
+     * \value Length
+     *      An absolute length, in pixels.
+     * \value Em
+     *      A length relative to the parent font size, in Ems.
+     * \value Rem
+     *      A length relative to the root font size, in Rems.
+     * \value Percent
+     *      A percentage.
+     * \value Angle
+     *      An angle, in radians.
+     * \value Time
+     *      A length of time, in milliseconds.
+     */
+    enum class UnitClass : uint8_t {
+        None,
+        Number,
+        Length,
+        Em,
+        Rem,
+        Percent,
+        Angle,
+        Time,
+    };
+
+    /*!
+     * \class cssparser::Dimension::Packed
+     * \inmodule cxx-rust-cssparser
+     *
+     * \brief The value of a dimension converted to the canonical unit of its
+     * unit class.
+     */
+    struct Packed {
+        float value = 0.0f;
+        UnitClass unitClass = UnitClass::None;
+    };
+
     /*!
      * Default constructor.
      */
@@ -109,6 +159,25 @@ public:
     {
         return m_value;
     }
+    /*!
+     * Returns the unit class of this Dimension.
+     */
+    inline UnitClass unitClass() const
+    {
+        return UnitClasses[std::size_t(m_unit)];
+    }
+    /*!
+     * Returns the value of this Dimension converted to the canonical unit of
+     * its unit class, together with that class.
+     *
+     * This is a table lookup and a multiplication, so it can be used when
+     * resolving many values without switching over all units.
+     */
+    inline Packed packed() const
+    {
+        const auto index = std::size_t(m_unit);
+        return Packed{m_value * CanonicalFactors[index], UnitClasses[index]};
+    }
     /*!
      * Returns a string representation of this dimension.
      */
@@ -118,6 +187,37 @@ public:
     static Dimension fromRust(rust::Dimension rustData);
 
 private:
+    // Indexed by Unit, these need to be updated when Unit changes.
+    static constexpr std::array<UnitClass, 12> UnitClasses = {
+        UnitClass::None, // Unknown
+        UnitClass::None, // Unsupported
+        UnitClass::Number,
+        UnitClass::Length, // Px
+        UnitClass::Em,
+        UnitClass::Rem,
+        UnitClass::Length, // Pt
+        UnitClass::Percent,
+        UnitClass::Angle, // Degrees
+        UnitClass::Angle, // Radians
+        UnitClass::Time, // Seconds
+        UnitClass::Time, // Milliseconds
+    };
+    static constexpr std::array<float, 12> CanonicalFactors = {
+        0.0f,
+        0.0f,
+        1.0f,
+        1.0f,
+        1.0f,
+        1.0f,
+        96.0f / 72.0f,
+        1.0f,
+        std::numbers::pi_v<float> / 180.0f,
+        1.0f,
+        1000.0f,
+        1.0f,
+    };
+    static_assert(UnitClasses.size() == std::size_t(Unit::Milliseconds) + 1);
+
     Unit m_unit = Unit::Unknown;
     float m_value = 0.0;
 };
@@ -127,6 +227,11 @@ private:
  * \inmodule cxx-rust-cssparser
  *
  * \brief A representation of a single value that can have several types.
+ *
+ * Value is 16 bytes large. Dimensions, integers, RGBA colors and strings of
+ * up to 13 characters are stored inline. Longer strings and other colors are
+ * stored in a reference counted block that is shared between copies, so
+ * copying a Value never allocates.
  */
 class CSSPARSER_EXPORT Value
 {
@@ -151,7 +256,7 @@ public:
      * \value Integer
      *      An integer.
      */
-    enum class Type {
+    enum class Type : uint8_t {
         Empty,
         Dimension,
         String,
@@ -173,9 +278,16 @@ public:
     template<typename T>
     Value(Type type, const T &data)
         : m_type(type)
-        , m_data(data)
     {
+        set(data);
     }
+    Value(const Value &other);
+    Value(Value &&other) noexcept;
+    ~Value();
+
+    Value &operator=(const Value &other);
+    Value &operator=(Value &&other) noexcept;
+
     /*!
      * Conversion operator to T.
      *
@@ -184,15 +296,30 @@ public:
     template<typename T>
     inline operator T() const
     {
-        return std::get<T>(m_data);
+        return get<T>();
     }
     /*!
      * Returns the T stored in this value.
+     *
+     * T can be Dimension, std::string, std::string_view, Color::Color or int.
+     * Throws std::bad_variant_access if this value does not store a T.
      */
     template<typename T>
     inline T get() const
     {
-        return std::get<T>(m_data);
+        if constexpr (std::is_same_v<T, Dimension>) {
+            return dimension();
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            return std::string(checkedString());
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            return checkedString();
+        } else if constexpr (std::is_same_v<T, Color::Color>) {
+            return color();
+        } else if constexpr (std::is_same_v<T, int>) {
+            return integer();
+        } else {
+            static_assert(std::is_same_v<T, Dimension>, "Unsupported type for Value::get()");
+        }
     }
     /*!
      * Returns the type of this value.
@@ -201,6 +328,31 @@ public:
     {
         return m_type;
     }
+    /*!
+     * Returns the Dimension stored in this value as Dimension::Packed.
+     *
+     * Unlike get<Dimension>(), this does not throw. If this value is not a
+     * Dimension, the unit class of the result is Dimension::UnitClass::None.
+     *
+     * \sa Dimension::packed()
+     */
+    inline Dimension::Packed packedDimension() const
+    {
+        if (m_type != Type::Dimension) {
+            return Dimension::Packed{};
+        }
+
+        Dimension result;
+        std::memcpy(&result, m_data + AlignedOffset, sizeof(Dimension));
+        return result.packed();
+    }
+    /*!
+     * Returns the contents of this value if it is a String, Image or Url.
+     *
+     * Returns an empty string_view for other types. The returned string_view
+     * is only valid as long as this value is.
+     */
+    std::string_view string() const;
     /*!
      * Returns a string representation of this value.
      */
@@ -210,8 +362,98 @@ public:
     static Value fromRust(const rust::Value &rustData);
 
 private:
-    Type m_type = Type::Empty;
-    std::variant<std::nullopt_t, Dimension, std::string, Color::Color, int> m_data = std::nullopt;
+    struct Shared;
+
+    enum class Storage : uint8_t {
+        None,
+        Inline,
+        Shared,
+    };
+
+    void set(std::nullopt_t);
+    void set(const Dimension &dimension);
+    void set(std::string_view string);
+    void set(const Color::Color &color);
+    void set(int integer);
+
+    Dimension dimension() const;
+    std::string_view checkedString() const;
+    Color::Color color() const;
+    int integer() const;
+
+    Shared *shared() const;
+    void release();
+
+    // The first three bytes store type, storage and the length of an inline
+    // string, m_data stores the rest. Inline strings use all of m_data, other
+    // inline data and the pointer to shared data are stored in the last eight
+    // bytes, which are 8-byte aligned.
+    alignas(8) Type m_type = Type::Empty;
+    Storage m_storage = Storage::None;
+    uint8_t m_size = 0;
+    char m_data[13] = {};
+
+    static constexpr std::size_t InlineStringSize = sizeof(m_data);
+    static constexpr std::size_t AlignedOffset = 5;
+};
+
+/*!
+ * \class cssparser::ValueView
+ * \inmodule cxx-rust-cssparser
+ *
+ * \brief A non-owning view on a Value that is part of a StyleSheet.
+ *
+ * Unlike Value, a ValueView does not copy any data out of the StyleSheet. It
+ * is only valid as long as the StyleSheet it was retrieved from is alive and
+ * has not been modified.
+ */
+class CSSPARSER_EXPORT ValueView
+{
+public:
+    // Internal. Constructs a view on a rust Value.
+    explicit ValueView(const rust::Value &rustData);
+    /*!
+     * Returns the type of the viewed value.
+     */
+    Value::Type type() const;
+    /*!
+     * Returns the viewed value as Dimension.
+     *
+     * Throws an exception if the value is not a Dimension.
+     */
+    Dimension dimension() const;
+    /*!
+     * Returns the viewed value as Dimension::Packed.
+     *
+     * If the value is not a Dimension, the unit class of the result is
+     * Dimension::UnitClass::None.
+     */
+    Dimension::Packed packedDimension() const;
+    /*!
+     * Returns the contents of the viewed value if it is a String, Image or Url.
+     *
+     * Returns an empty string_view for other types.
+     */
+    std::string_view string() const;
+    /*!
+     * Returns the viewed value as Color.
+     *
+     * Throws an exception if the value is not a Color.
+     */
+    Color::Color color() const;
+    /*!
+     * Returns the viewed value as integer.
+     *
+     * Throws an exception if the value is not an Integer.
+     */
+    int integer() const;
+    /*!
+     * Returns a copy of the viewed value.
+     */
+    Value toValue() const;
+
+private:
+    const rust::Value *m_value;
 };
 
 }
@@ -0,0 +1,300 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+// Benchmarks for parsing StyleSheets.
+//
+// Run with `cargo bench`. Criterion stores its results as JSON in
+// target/criterion, or in $CRITERION_HOME if that is set.
+
+use std::fmt::Write;
+use std::hint::black_box;
+use std::path::{Path, PathBuf};
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+
+use cxx_rust_cssparser_impl::fragment::{FragmentKind, FragmentParser};
+use cxx_rust_cssparser_impl::property::{PropertyDefinition, PropertyRegistry};
+use cxx_rust_cssparser_impl::selector::{Selector, SelectorKind, SelectorPart};
+use cxx_rust_cssparser_impl::stylematcher::{AncestorFilter, ElementData, StyleMatcher};
+use cxx_rust_cssparser_impl::stylesheet::StyleSheet;
+use cxx_rust_cssparser_impl::value::Value;
+
+const SIZES: [usize; 3] = [100, 1000, 10000];
+
+fn theme_path() -> PathBuf {
+    PathBuf::from(concat!(env!("CARGO_MANIFEST_DIR"), "/benches/data/theme.css"))
+}
+
+// The @property rules of the theme, so synthetic sheets use the same
+// definitions.
+fn definitions() -> String {
+    let theme = std::fs::read_to_string(theme_path()).unwrap();
+    let end = theme.find(":root").unwrap();
+    theme[..end].to_string()
+}
+
+// About `count` rules that resemble a large generated theme: comma
+// separated selector lists, a mix of selector kinds and nested rules for
+// interaction states. Each block results in six rules.
+fn synthetic_rules(count: usize) -> String {
+    let mut result = String::new();
+
+    for index in 0..count / 6 {
+        let _ = write!(result, "
+.widget-{index},
+#item-{index} > label,
+button.variant-{index}[role=\"tab\"] {{
+    width: {}px;
+    padding: 2px 4px 2px 4px;
+    color: #{:06x};
+    border: solid 1px rgba(0, 0, 0, 0.5);
+
+    &:hovered {{
+        background-color: modify-color(#{:06x} add #101010);
+    }}
+}}
+",
+            index % 200,
+            (index * 2654435761) % 0xffffff,
+            (index * 40503) % 0xffffff,
+        );
+    }
+
+    result
+}
+
+fn synthetic_sheet(count: usize) -> String {
+    definitions() + &synthetic_rules(count)
+}
+
+// A sheet where each level of nesting has `width` selectors, `depth` levels
+// deep.
+fn nested_sheet(depth: usize, width: usize) -> String {
+    let mut result = definitions();
+
+    let list = |level: usize, prefix: &str| (0..width).map(|index| format!("{}level{}-{}", prefix, level, index)).collect::<Vec<_>>().join(", ");
+
+    result.push_str(&list(0, ""));
+    result.push_str(" {\n    width: 1px;\n");
+    for level in 1..depth {
+        result.push_str(&list(level, "& "));
+        result.push_str(" {\n    width: 1px;\n");
+    }
+    for _ in 0..depth {
+        result.push_str("}\n");
+    }
+
+    result
+}
+
+fn parse_string(input: &str) -> StyleSheet {
+    let mut sheet = StyleSheet::new_with_registry(PathBuf::new(), &PropertyRegistry::new());
+    sheet.parse_string(input).unwrap();
+    sheet
+}
+
+fn parse(c: &mut Criterion) {
+    let mut group = c.benchmark_group("parse");
+
+    let theme = std::fs::read_to_string(theme_path()).unwrap();
+    group.throughput(Throughput::Bytes(theme.len() as u64));
+    group.bench_function("theme", |b| b.iter(|| parse_string(black_box(&theme))));
+    group.bench_function("theme_file", |b| b.iter(|| {
+        let mut sheet = StyleSheet::new_with_registry(theme_path(), &PropertyRegistry::new());
+        sheet.parse().unwrap();
+        sheet
+    }));
+    group.bench_function("theme_visitor", |b| b.iter(|| {
+        let mut count = 0;
+        let mut sheet = StyleSheet::new_with_registry(PathBuf::new(), &PropertyRegistry::new());
+        sheet.parse_string_with_visitor(black_box(&theme), &mut |_| count += 1).unwrap();
+        count
+    }));
+
+    for size in SIZES {
+        let input = synthetic_sheet(size);
+        group.throughput(Throughput::Bytes(input.len() as u64));
+        group.bench_with_input(BenchmarkId::new("synthetic", size), &input, |b, input| b.iter(|| parse_string(input)));
+    }
+
+    // The largest synthetic sheet, split across all cores.
+    let input = synthetic_sheet(SIZES[SIZES.len() - 1]);
+    group.throughput(Throughput::Bytes(input.len() as u64));
+    group.bench_function("synthetic_threads", |b| b.iter(|| {
+        let mut sheet = StyleSheet::new_with_registry(PathBuf::new(), &PropertyRegistry::new());
+        sheet.set_parse_threads(0);
+        sheet.parse_string(black_box(&input)).unwrap();
+        sheet
+    }));
+
+    group.finish();
+}
+
+// Create a directory with a main file that imports `count` files.
+fn import_tree(count: usize) -> PathBuf {
+    let directory = std::env::temp_dir().join(format!("cxx-rust-cssparser-bench-{}-{}", std::process::id(), count));
+    std::fs::create_dir_all(&directory).unwrap();
+
+    let mut main = definitions();
+    for index in 0..count {
+        let _ = writeln!(main, "@import \"import-{}.css\";", index);
+        std::fs::write(directory.join(format!("import-{}.css", index)), synthetic_rules(40)).unwrap();
+    }
+    std::fs::write(directory.join("main.css"), main).unwrap();
+
+    directory
+}
+
+fn imports(c: &mut Criterion) {
+    let mut group = c.benchmark_group("import");
+
+    for count in [1, 16, 64] {
+        let directory = import_tree(count);
+        let path = directory.join("main.css");
+
+        let parse_file = |path: &Path, parallel: bool| {
+            let mut sheet = StyleSheet::new_with_registry(path.to_path_buf(), &PropertyRegistry::new());
+            sheet.set_parallel_imports(parallel);
+            sheet.parse().unwrap();
+            sheet
+        };
+
+        group.bench_with_input(BenchmarkId::new("sequential", count), &path, |b, path| b.iter(|| parse_file(path, false)));
+        group.bench_with_input(BenchmarkId::new("parallel", count), &path, |b, path| b.iter(|| parse_file(path, true)));
+
+        let _ = std::fs::remove_dir_all(&directory);
+    }
+
+    group.finish();
+}
+
+// Parsing the syntax of @property rules and validating values against it.
+fn syntax(c: &mut Criterion) {
+    let mut group = c.benchmark_group("syntax");
+
+    let syntaxes = [
+        ("simple", "<color>"),
+        ("repeat", "<length>{1,4}"),
+        ("alternatives", "(solid | dashed | dotted | none) <length> <color>"),
+        ("nested_groups", "(auto | <length>) | (<length> <length>) | (<length> <length> <length> <length>)"),
+    ];
+
+    for (name, syntax) in syntaxes {
+        group.bench_with_input(BenchmarkId::new("definition", name), syntax, |b, syntax| b.iter(|| {
+            PropertyDefinition::from_name_syntax("bench", black_box(syntax), "", 0, 0).unwrap()
+        }));
+    }
+
+    let values = [
+        ("simple", "<color>", "#ff0000"),
+        ("repeat", "<length>{1,4}", "1px 2px 3px 4px"),
+        ("alternatives", "(solid | dashed | dotted | none) <length> <color>", "dashed 2px rgba(0, 0, 0, 0.5)"),
+        ("nested_groups", "(auto | <length>) | (<length> <length>) | (<length> <length> <length> <length>)", "1px 2px 3px 4px"),
+    ];
+
+    for (name, syntax, value) in values {
+        let mut input = format!("@property bench {{ syntax: \"{}\"; inherits: false; }}\n", syntax);
+        for index in 0..100 {
+            let _ = writeln!(input, "rule-{} {{ bench: {}; }}", index, value);
+        }
+
+        group.bench_with_input(BenchmarkId::new("validate", name), &input, |b, input| b.iter(|| parse_string(input)));
+    }
+
+    group.finish();
+}
+
+fn nesting(c: &mut Criterion) {
+    let mut group = c.benchmark_group("nesting");
+
+    for (depth, width) in [(4, 2), (6, 2), (4, 4)] {
+        let input = nested_sheet(depth, width);
+        let id = format!("{}x{}", depth, width);
+        group.bench_with_input(BenchmarkId::new("parse", &id), &input, |b, input| b.iter(|| parse_string(input)));
+    }
+
+    // Combine a selector with a parent selector for each level of nesting,
+    // like flattening a deeply nested rule does.
+    for depth in [4, 16, 64] {
+        let nested = Selector::from_parts(&[
+            SelectorPart::new_with_empty(SelectorKind::RelativeParent),
+            SelectorPart::new_with_empty(SelectorKind::DescendantCombinator),
+            SelectorPart::new_with_value(SelectorKind::Class, Value::from("nested")),
+        ]);
+        let root = Selector::from_parts(&[SelectorPart::new_with_value(SelectorKind::Type, Value::from("root"))]);
+
+        group.bench_with_input(BenchmarkId::new("combine", depth), &depth, |b, depth| b.iter(|| {
+            let mut selector = root.clone();
+            for _ in 0..*depth {
+                selector = Selector::combine(&nested, &selector);
+            }
+            selector
+        }));
+    }
+
+    group.finish();
+}
+
+// Many small inline styles, parsed as separate StyleSheets compared to
+// parsing them as one batch of fragments.
+fn fragments(c: &mut Criterion) {
+    let mut group = c.benchmark_group("fragments");
+
+    let registry = PropertyRegistry::new();
+    parse_string(&definitions()).defined_properties().iter().for_each(|definition| { registry.add(definition); });
+
+    let styles: Vec<String> = (0..1000).map(|index| format!("width: {}px; color: #{:06x}", index % 200, (index * 40503) % 0xffffff)).collect();
+    let rules: Vec<String> = styles.iter().map(|style| format!("widget {{ {} }}", style)).collect();
+
+    group.throughput(Throughput::Elements(styles.len() as u64));
+    group.bench_function("stylesheets", |b| b.iter(|| {
+        rules.iter().map(|rule| {
+            let mut sheet = StyleSheet::new_with_registry(PathBuf::new(), &registry);
+            sheet.parse_string(rule).unwrap();
+            sheet.rule_count()
+        }).sum::<usize>()
+    }));
+
+    let rules: Vec<&str> = rules.iter().map(String::as_str).collect();
+    let parser = FragmentParser::new_with_registry(FragmentKind::Rules, &registry);
+    group.bench_function("rules", |b| b.iter(|| parser.parse(black_box(&rules))));
+
+    let styles: Vec<&str> = styles.iter().map(String::as_str).collect();
+    let parser = FragmentParser::new_with_registry(FragmentKind::Declarations, &registry);
+    group.bench_function("declarations", |b| b.iter(|| parser.parse(black_box(&styles))));
+
+    group.finish();
+}
+
+// Matching an element against many rules that need an ancestor, where only
+// a few of those ancestors exist.
+fn matching(c: &mut Criterion) {
+    let mut group = c.benchmark_group("matching");
+
+    let mut input = String::new();
+    for index in 0..1000 {
+        let _ = write!(input, "window .panel-{index} button {{}}\nwindow > #frame-{index} button {{}}\n");
+    }
+    let sheet = parse_string(&input);
+    let matcher = StyleMatcher::new(&sheet);
+
+    let element = |type_name: &str, class: &str| ElementData {
+        type_name: type_name.to_string(),
+        classes: if class.is_empty() { Vec::new() } else { vec![class.to_string()] },
+        ..Default::default()
+    };
+    let mut elements = vec![element("button", "")];
+    elements.extend((0..20).map(|index| element("frame", &format!("panel-{}", index * 50))));
+    elements.push(element("window", ""));
+
+    group.bench_function("matching_rules", |b| b.iter(|| matcher.matching_rules(black_box(&elements))));
+
+    let mut filter = AncestorFilter::new();
+    elements[1..].iter().rev().for_each(|ancestor| filter.push(ancestor));
+    group.bench_function("with_filter", |b| b.iter(|| matcher.matching_rules_with_filter(black_box(&elements), &filter)));
+
+    group.finish();
+}
+
+criterion_group!(benches, parse, imports, syntax, nesting, fragments, matching);
+criterion_main!(benches);
@@ -2,7 +2,11 @@
 // SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
 
 fn main() {
+    // The C++ side of the bridge includes headers from the C++ library.
     cxx_build::bridge("src/ffi.rs")
+        .include("../cpp")
         .std("c++20")
         .compile("cxx-rust-cssparser-impl");
+
+    println!("cargo:rerun-if-changed=../cpp/RuleVisitorAdapter.h");
 }
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+// Interned strings.
+//
+// Names like property names, classes and ids are repeated many times in a
+// StyleSheet. Atoms store each distinct string only once, in a table that is
+// shared by the entire process, and refer to it by index. Comparing or
+// hashing an Atom only compares or hashes that index.
+//
+// Strings are never removed from the table, so only names that matching
+// compares by Atom are interned: property names, types, ids, classes and
+// attribute names. The set of those used by stylesheets is small enough that
+// this is not a problem. Attribute values are compared as strings and not
+// interned.
+
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicU32, Ordering};
+use std::sync::{OnceLock, RwLock};
+
+// The ids of all strings in the table. Only needed to create atoms.
+fn table() -> &'static RwLock<HashMap<&'static str, u32>> {
+    static TABLE: OnceLock<RwLock<HashMap<&'static str, u32>>> = OnceLock::new();
+    TABLE.get_or_init(|| {
+        // The empty string is always atom 0, so Atom::default() does not need
+        // to touch the table.
+        let mut ids = HashMap::new();
+        ids.insert("", 0);
+        STRINGS.push(0, "");
+        RwLock::new(ids)
+    })
+}
+
+const FIRST_CHUNK_BITS: u32 = 8;
+const CHUNK_COUNT: usize = (u32::BITS + 1 - FIRST_CHUNK_BITS) as usize;
+
+// The strings of the table, by id.
+//
+// Strings are only ever appended, into chunks that do not move once they
+// are allocated, so they can be read without taking the lock of the table.
+// Chunk `n` has room for 2^(FIRST_CHUNK_BITS + n) strings.
+struct Strings {
+    chunks: [OnceLock<Box<[OnceLock<&'static str>]>>; CHUNK_COUNT],
+    len: AtomicU32,
+}
+
+static STRINGS: Strings = {
+    const EMPTY: OnceLock<Box<[OnceLock<&'static str>]>> = OnceLock::new();
+    Strings { chunks: [EMPTY; CHUNK_COUNT], len: AtomicU32::new(0) }
+};
+
+impl Strings {
+    // The chunk and the position in that chunk of the string for `id`.
+    fn position(id: u32) -> (usize, usize) {
+        let index = id as u64 + (1 << FIRST_CHUNK_BITS);
+        let bits = u64::BITS - 1 - index.leading_zeros();
+        ((bits - FIRST_CHUNK_BITS) as usize, (index - (1 << bits)) as usize)
+    }
+
+    fn get(&self, id: u32) -> Option<&'static str> {
+        let (chunk, offset) = Strings::position(id);
+        self.chunks[chunk].get().and_then(|strings| strings[offset].get()).copied()
+    }
+
+    // Store `string` as the string for `id`. Needs to be called with the
+    // table locked for writing, for the next id.
+    fn push(&self, id: u32, string: &'static str) {
+        let (chunk, offset) = Strings::position(id);
+        let strings = self.chunks[chunk].get_or_init(|| (0..1usize << (FIRST_CHUNK_BITS as usize + chunk)).map(|_| OnceLock::new()).collect());
+        let _ = strings[offset].set(string);
+        self.len.store(id + 1, Ordering::Release);
+    }
+
+    fn len(&self) -> u32 {
+        self.len.load(Ordering::Acquire)
+    }
+}
+
+#[derive(Default, Clone, Copy, PartialEq, Eq, Hash, PartialOrd, Ord)]
+pub struct Atom(u32);
+
+impl Atom {
+    // Returns the Atom for `string`, adding it to the table if needed.
+    pub fn new(string: &str) -> Atom {
+        if let Some(atom) = Atom::lookup(string) {
+            return atom;
+        }
+
+        let mut ids = table().write().unwrap();
+        // Another thread may have added it between releasing the read lock
+        // and acquiring the write lock.
+        if let Some(id) = ids.get(string) {
+            return Atom(*id);
+        }
+
+        let id = STRINGS.len();
+        let leaked: &'static str = Box::leak(string.to_string().into_boxed_str());
+        STRINGS.push(id, leaked);
+        ids.insert(leaked, id);
+        Atom(id)
+    }
+
+    // Returns the Atom for `string` if it was added to the table before.
+    //
+    // This is useful for matching, a string that was never interned cannot
+    // be equal to any existing Atom.
+    pub fn lookup(string: &str) -> Option<Atom> {
+        table().read().unwrap().get(string).map(|id| Atom(*id))
+    }
+
+    // Returns the Atom with index `id`, or None if no such Atom exists.
+    pub fn from_id(id: u32) -> Option<Atom> {
+        // The empty string is added along with the table.
+        (id == 0 || id < STRINGS.len()).then_some(Atom(id))
+    }
+
+    pub fn id(&self) -> u32 {
+        self.0
+    }
+
+    // This does not take any lock, so it is cheap enough to call for every
+    // comparison with a string.
+    pub fn as_str(&self) -> &'static str {
+        STRINGS.get(self.0).unwrap_or("")
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.0 == 0
+    }
+}
+
+impl From<&str> for Atom {
+    fn from(value: &str) -> Self {
+        Atom::new(value)
+    }
+}
+
+impl From<&String> for Atom {
+    fn from(value: &String) -> Self {
+        Atom::new(value)
+    }
+}
+
+impl From<String> for Atom {
+    fn from(value: String) -> Self {
+        Atom::new(&value)
+    }
+}
+
+impl PartialEq<str> for Atom {
+    fn eq(&self, other: &str) -> bool {
+        self.as_str() == other
+    }
+}
+
+impl PartialEq<&str> for Atom {
+    fn eq(&self, other: &&str) -> bool {
+        self.as_str() == *other
+    }
+}
+
+impl std::fmt::Debug for Atom {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        write!(f, "Atom({:?})", self.as_str())
+    }
+}
+
+impl std::fmt::Display for Atom {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.write_str(self.as_str())
+    }
+}
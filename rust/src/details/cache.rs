@@ -0,0 +1,811 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+// A binary cache of parsed StyleSheets.
+//
+// The cache stores everything a parse produces: rules, errors, imported
+// StyleSheets and the property definitions used by or defined in them. It
+// also stores the modification time and size of every file when it was read
+// and the definitions that were in the registry before parsing, a cache is
+// only used if none of these changed.
+//
+// Layout, all integers are little endian:
+//
+// magic       "CSSC"
+// version     u32
+// options     the parse options that affect the result: u8 flags for
+//             stop_at_first_error and canonicalize_units, then max_errors,
+//             max_rules, max_nesting_depth and max_input_size as u64, u64::MAX
+//             if unlimited
+// inputs      u32 count, then for each: path, mtime as u64 nanoseconds, size as u64
+// definitions u32 count, then for each: name, syntax, inherit, initial values
+// stylesheet  the root StyleSheet, imported StyleSheets are nested inside it
+// registry    u32 count, then the definitions of the registry that were not
+//             added by the StyleSheets, sorted by name
+//
+// Strings are stored as u32 length followed by UTF-8 data, lists as u32 count
+// followed by their items. Properties refer to their definition by index.
+
+use std::collections::{HashMap, HashSet};
+use std::fs::File;
+use std::io::Write;
+use std::path::{Path, PathBuf};
+use std::sync::Arc;
+use std::time::UNIX_EPOCH;
+
+use memmap2::Mmap;
+
+use crate::atom::Atom;
+use crate::parseerror::{ParseError, ParseErrorKind, SourceLocation};
+use crate::property::{BlockInterner, Property, PropertyBlock, PropertyDefinition, PropertyRegistry};
+use crate::selector::{AttributeOperator, Selector, SelectorKind, SelectorPart, SelectorValue};
+use crate::stylerule::StyleRule;
+use crate::stylesheet::{Contribution, ParseOptions, StyleSheet};
+use crate::value::{Color, ColorData, ColorOperation, Dimension, Unit, Value, ValueData};
+
+use super::property::syntax::{DataType, ParsedPropertySyntax, SyntaxAlternatives, SyntaxComponent, SyntaxGroup};
+
+const MAGIC: &[u8; 4] = b"CSSC";
+// Increment this whenever the layout or any of the stored types change.
+const VERSION: u32 = 5;
+
+// Returns the path of the cache file for the StyleSheet at `path`.
+pub fn cache_file_path(path: &Path, cache_dir: &Path) -> PathBuf {
+    // FNV-1a, this needs to be stable between runs so DefaultHasher can't be
+    // used.
+    let mut hash: u64 = 0xcbf29ce484222325;
+    for byte in path.to_string_lossy().bytes() {
+        hash ^= byte as u64;
+        hash = hash.wrapping_mul(0x100000001b3);
+    }
+
+    let stem = path.file_stem().map(|stem| stem.to_string_lossy().to_string()).unwrap_or_default();
+    cache_dir.join(format!("{}-{:016x}.csscache", stem, hash))
+}
+
+// The modification time in nanoseconds and size of the file at `path`.
+pub(crate) fn file_stamp(path: &Path) -> Option<(u64, u64)> {
+    let metadata = std::fs::metadata(path).ok()?;
+    let mtime = metadata.modified().ok()?.duration_since(UNIX_EPOCH).ok()?.as_nanos() as u64;
+    Some((mtime, metadata.len()))
+}
+
+// Load the StyleSheet for `path` from `cache_path`. Returns None if there is
+// no cache, it is invalid, any of its inputs changed or it was parsed with
+// options that give a different result than `options` or with different
+// definitions in `registry`.
+//
+// The definitions of the loaded StyleSheets are only added to `registry` if
+// loading succeeds.
+pub fn load(cache_path: &Path, path: &Path, registry: &PropertyRegistry, options: &ParseOptions) -> Option<StyleSheet> {
+    let file = File::open(cache_path).ok()?;
+    // Safety: The map is only read from and dropped before returning. A
+    // cache file that is modified while reading it will fail to decode.
+    let map = unsafe { Mmap::map(&file) }.ok()?;
+
+    let mut reader = Reader { data: &map[..], position: 0, definitions: Vec::new(), blocks: BlockInterner::default() };
+    if reader.bytes(MAGIC.len())? != MAGIC || reader.u32()? != VERSION || reader.bytes(OPTIONS_SIZE)? != &options_key(options)[..] {
+        return None;
+    }
+
+    let mut stamps = HashMap::new();
+    for _ in 0..reader.u32()? {
+        let input = PathBuf::from(reader.string()?);
+        let stamp = (reader.u64()?, reader.u64()?);
+        if file_stamp(&input)? != stamp {
+            return None;
+        }
+        stamps.insert(input, stamp);
+    }
+
+    let mut definitions = Vec::new();
+    for _ in 0..reader.u32()? {
+        definitions.push(Arc::new(reader.definition()?));
+    }
+
+    reader.definitions = definitions;
+    let mut sheet = reader.stylesheet(registry)?;
+    if sheet.path != path {
+        return None;
+    }
+
+    let key = registry_key(registry, &sheet);
+    if reader.bytes(key.len())? != &key[..] || reader.position != reader.data.len() {
+        return None;
+    }
+
+    // The stamps were verified above, so they match the cached contents.
+    restore_file_stamps(&mut sheet, &stamps);
+    register_definitions(&sheet, registry);
+    Some(sheet)
+}
+
+fn restore_file_stamps(sheet: &mut StyleSheet, stamps: &HashMap<PathBuf, (u64, u64)>) {
+    sheet.file_stamp = stamps.get(&sheet.path).copied();
+    sheet.imported_sheets.iter_mut().for_each(|imported| restore_file_stamps(imported, stamps));
+}
+
+// Restore the definitions `sheet` and its imported StyleSheets added to
+// `registry`, so they are available to anything parsed afterwards, the same
+// as when the StyleSheets were parsed. Imported StyleSheets are registered
+// first, as @import needs to be in front of the rules of a StyleSheet.
+fn register_definitions(sheet: &StyleSheet, registry: &PropertyRegistry) {
+    for imported in &sheet.imported_sheets {
+        register_definitions(imported, registry);
+    }
+
+    for definition in &sheet.defined_properties {
+        registry.add(definition);
+    }
+}
+
+// The definitions in `registry` that parsing `sheet` could have used, in the
+// form they are stored in the cache. Definitions added by `sheet` or its
+// imported StyleSheets are part of the parse result and left out, so the key
+// is the same before and after parsing.
+fn registry_key(registry: &PropertyRegistry, sheet: &StyleSheet) -> Vec<u8> {
+    let mut defined = HashSet::new();
+    collect_defined_names(sheet, &mut defined);
+
+    let mut definitions: Vec<_> = registry.all_definitions().into_iter()
+        .filter(|definition| !defined.contains(definition.name.as_str()))
+        .collect();
+    definitions.sort_by(|first, second| first.name.cmp(&second.name));
+
+    let mut writer = Writer { data: Vec::new(), definitions: HashMap::new() };
+    writer.u32(definitions.len() as u32);
+    definitions.iter().for_each(|definition| writer.definition(definition));
+    writer.data
+}
+
+fn collect_defined_names<'a>(sheet: &'a StyleSheet, names: &mut HashSet<&'a str>) {
+    names.extend(sheet.defined_properties.iter().map(|definition| definition.name.as_str()));
+    sheet.imported_sheets.iter().for_each(|imported| collect_defined_names(imported, names));
+}
+
+const OPTIONS_SIZE: usize = 1 + 4 * 8;
+
+// The parse options that change the result of parsing, as stored in the
+// cache.
+fn options_key(options: &ParseOptions) -> [u8; OPTIONS_SIZE] {
+    let mut key = [0; OPTIONS_SIZE];
+    key[0] = options.stop_at_first_error as u8 | (options.canonicalize_units as u8) << 1;
+
+    let limits = [options.max_errors, options.max_rules, options.max_nesting_depth, options.max_input_size];
+    for (index, limit) in limits.iter().enumerate() {
+        let value = limit.map_or(u64::MAX, |limit| limit as u64);
+        key[1 + index * 8..9 + index * 8].copy_from_slice(&value.to_le_bytes());
+    }
+
+    key
+}
+
+// Write `sheet` to `cache_path`.
+//
+// The inputs are stored with the stamps taken when they were read, so a file
+// that was modified after reading it does not match the cache. Nothing is
+// stored if any of the StyleSheets was not read from a file.
+pub fn store(cache_path: &Path, sheet: &StyleSheet) -> std::io::Result<()> {
+    let mut writer = Writer { data: Vec::new(), definitions: HashMap::new() };
+    writer.data.extend_from_slice(MAGIC);
+    writer.u32(VERSION);
+    writer.data.extend_from_slice(&options_key(sheet.parse_options()));
+
+    let mut inputs = Vec::new();
+    collect_file_stamps(sheet, &mut inputs)?;
+    writer.u32(inputs.len() as u32);
+    for (input, (mtime, size)) in inputs {
+        writer.string(&input.to_string_lossy());
+        writer.u64(mtime);
+        writer.u64(size);
+    }
+
+    // Definitions are written first so they can be referenced by index.
+    let mut definitions = Vec::new();
+    collect_definitions(sheet, &mut definitions);
+    writer.u32(definitions.len() as u32);
+    for (index, definition) in definitions.iter().enumerate() {
+        writer.definition(definition);
+        writer.definitions.insert(Arc::as_ptr(definition), index as u32);
+    }
+
+    writer.stylesheet(sheet);
+    writer.data.extend_from_slice(&registry_key(sheet.registry(), sheet));
+
+    if let Some(parent) = cache_path.parent() {
+        std::fs::create_dir_all(parent)?;
+    }
+
+    // Write to a temporary file first so a concurrent load never sees a
+    // partially written cache.
+    let temporary_path = cache_path.with_extension(format!("tmp{}", std::process::id()));
+    let mut file = File::create(&temporary_path)?;
+    file.write_all(&writer.data)?;
+    drop(file);
+    std::fs::rename(&temporary_path, cache_path)
+}
+
+// The path and stamp of `sheet` and its imported StyleSheets, in the same order
+// as StyleSheet::all_paths().
+fn collect_file_stamps<'a>(sheet: &'a StyleSheet, inputs: &mut Vec<(&'a Path, (u64, u64))>) -> std::io::Result<()> {
+    for imported in &sheet.imported_sheets {
+        collect_file_stamps(imported, inputs)?;
+    }
+
+    let Some(stamp) = sheet.file_stamp else {
+        return Err(std::io::Error::new(std::io::ErrorKind::NotFound, format!("{} was not read from a file", sheet.path.display())));
+    };
+    inputs.push((sheet.path.as_path(), stamp));
+    Ok(())
+}
+
+fn collect_definitions(sheet: &StyleSheet, definitions: &mut Vec<Arc<PropertyDefinition>>) {
+    let mut add = |definition: &Arc<PropertyDefinition>| {
+        if !definitions.iter().any(|existing| Arc::ptr_eq(existing, definition)) {
+            definitions.push(definition.clone());
+        }
+    };
+
+    sheet.defined_properties.iter().for_each(&mut add);
+    for rule in &sheet.rules {
+        rule.properties.iter().for_each(|property| add(&property.definition));
+    }
+
+    for imported in &sheet.imported_sheets {
+        collect_definitions(imported, definitions);
+    }
+}
+
+// Conversion of fieldless enums to and from a single byte, based on the order
+// of the variants listed.
+trait Code: Sized {
+    fn code(&self) -> u8;
+    fn from_code(code: u8) -> Option<Self>;
+}
+
+macro_rules! impl_code {
+    ($type:ty, [$($variant:expr),* $(,)?]) => {
+        impl Code for $type {
+            fn code(&self) -> u8 {
+                [$($variant),*].iter().position(|variant| variant == self).unwrap() as u8
+            }
+
+            fn from_code(code: u8) -> Option<Self> {
+                [$($variant),*].into_iter().nth(code as usize)
+            }
+        }
+    }
+}
+
+impl_code!(Unit, [Unit::Unknown, Unit::Unsupported, Unit::Number, Unit::Px, Unit::Em, Unit::Rem, Unit::Pt,
+                  Unit::Percent, Unit::Degrees, Unit::Radians, Unit::Seconds, Unit::Milliseconds]);
+
+impl_code!(SelectorKind, [SelectorKind::Unknown, SelectorKind::AnyElement, SelectorKind::Type, SelectorKind::Class,
+                          SelectorKind::Id, SelectorKind::PseudoClass, SelectorKind::Attribute, SelectorKind::RelativeParent,
+                          SelectorKind::DocumentRoot, SelectorKind::DescendantCombinator, SelectorKind::ChildCombinator]);
+
+impl_code!(AttributeOperator, [AttributeOperator::None, AttributeOperator::Exists, AttributeOperator::Equals,
+                               AttributeOperator::Includes, AttributeOperator::Prefixed, AttributeOperator::Suffixed,
+                               AttributeOperator::Substring, AttributeOperator::DashMatch]);
+
+impl_code!(DataType, [DataType::Length, DataType::Number, DataType::Percentage, DataType::LengthPercentage,
+                      DataType::String, DataType::Color, DataType::Url, DataType::Integer, DataType::Angle,
+                      DataType::Time, DataType::Resolution, DataType::TransformFunction, DataType::CustomIdent]);
+
+impl_code!(ParseErrorKind, [ParseErrorKind::Unspecified, ParseErrorKind::Unimplemented, ParseErrorKind::UnexpectedEndOfInput,
+                            ParseErrorKind::Unknown, ParseErrorKind::UnknownProperty, ParseErrorKind::UnexpectedToken,
+                            ParseErrorKind::InvalidSelectors, ParseErrorKind::InvalidPropertySyntax,
+                            ParseErrorKind::InvalidPropertyValue, ParseErrorKind::UnknownFunction,
+                            ParseErrorKind::InvalidPropertyDefinition, ParseErrorKind::PropertyValueDoesNotMatchSyntax,
+                            ParseErrorKind::UnsupportedAtRule, ParseErrorKind::InvalidAtRule,
+                            ParseErrorKind::InvalidQualifiedRule, ParseErrorKind::FileError,
+                            ParseErrorKind::StyleSheetParseError, ParseErrorKind::LimitExceeded,
+                            ParseErrorKind::Cancelled]);
+
+struct Writer {
+    data: Vec<u8>,
+    definitions: HashMap<*const PropertyDefinition, u32>,
+}
+
+impl Writer {
+    fn u8(&mut self, value: u8) {
+        self.data.push(value);
+    }
+
+    fn u32(&mut self, value: u32) {
+        self.data.extend_from_slice(&value.to_le_bytes());
+    }
+
+    fn u64(&mut self, value: u64) {
+        self.data.extend_from_slice(&value.to_le_bytes());
+    }
+
+    fn i32(&mut self, value: i32) {
+        self.data.extend_from_slice(&value.to_le_bytes());
+    }
+
+    fn f32(&mut self, value: f32) {
+        self.data.extend_from_slice(&value.to_le_bytes());
+    }
+
+    fn string(&mut self, value: &str) {
+        self.u32(value.len() as u32);
+        self.data.extend_from_slice(value.as_bytes());
+    }
+
+    fn code(&mut self, value: &impl Code) {
+        self.u8(value.code());
+    }
+
+    fn values(&mut self, values: &[Value]) {
+        self.u32(values.len() as u32);
+        values.iter().for_each(|value| self.value(value));
+    }
+
+    fn value(&mut self, value: &Value) {
+        match &value.data {
+            ValueData::Empty => self.u8(0),
+            ValueData::Dimension(dimension) => {
+                self.u8(1);
+                self.f32(dimension.value);
+                self.code(&dimension.unit);
+            },
+            ValueData::String(string) => {
+                self.u8(2);
+                self.string(string);
+            },
+            ValueData::Color(color) => {
+                self.u8(3);
+                self.color(color);
+            },
+            ValueData::Image(image) => {
+                self.u8(4);
+                self.string(image);
+            },
+            ValueData::Url(url) => {
+                self.u8(5);
+                self.string(url);
+            },
+            ValueData::Integer(integer) => {
+                self.u8(6);
+                self.i32(*integer);
+            },
+        }
+    }
+
+    fn color(&mut self, color: &Color) {
+        match &color.data {
+            ColorData::Empty => self.u8(0),
+            ColorData::Rgba { r, g, b, a } => {
+                self.u8(1);
+                self.data.extend_from_slice(&[*r, *g, *b, *a]);
+            },
+            ColorData::Custom { source, arguments } => {
+                self.u8(2);
+                self.string(source);
+                self.u32(arguments.len() as u32);
+                arguments.iter().for_each(|argument| self.string(argument));
+            },
+            ColorData::Modified { color, operation } => {
+                self.u8(3);
+                self.color(color);
+                self.color_operation(operation);
+            },
+        }
+    }
+
+    fn color_operation(&mut self, operation: &ColorOperation) {
+        match operation {
+            ColorOperation::Set { r, g, b, a } => {
+                self.u8(0);
+                for component in [r, g, b, a] {
+                    match component {
+                        Some(value) => self.data.extend_from_slice(&[1, *value]),
+                        None => self.data.extend_from_slice(&[0, 0]),
+                    }
+                }
+            },
+            ColorOperation::Add { other } => {
+                self.u8(1);
+                self.color(other);
+            },
+            ColorOperation::Subtract { other } => {
+                self.u8(2);
+                self.color(other);
+            },
+            ColorOperation::Multiply { other } => {
+                self.u8(3);
+                self.color(other);
+            },
+            ColorOperation::Mix { other, amount } => {
+                self.u8(4);
+                self.color(other);
+                self.f32(*amount);
+            },
+        }
+    }
+
+    fn definition(&mut self, definition: &PropertyDefinition) {
+        self.string(&definition.name);
+        self.syntax(&definition.syntax);
+        self.u8(definition.inherit as u8);
+        self.values(&definition.initial);
+    }
+
+    fn syntax(&mut self, syntax: &ParsedPropertySyntax) {
+        match syntax {
+            ParsedPropertySyntax::Empty => self.u8(0),
+            ParsedPropertySyntax::Universal => self.u8(1),
+            ParsedPropertySyntax::Expression(expression) => {
+                self.u8(2);
+                self.expression(expression);
+            },
+        }
+    }
+
+    fn expression(&mut self, expression: &[SyntaxAlternatives]) {
+        self.u32(expression.len() as u32);
+        for alternatives in expression {
+            match alternatives {
+                SyntaxAlternatives::Component(component) => {
+                    self.u8(0);
+                    self.syntax_component(component);
+                },
+                SyntaxAlternatives::Group(group) => {
+                    self.u8(1);
+                    self.syntax_group(group);
+                },
+                SyntaxAlternatives::Alternatives(groups) => {
+                    self.u8(2);
+                    self.u32(groups.len() as u32);
+                    groups.iter().for_each(|group| self.syntax_group(group));
+                },
+            }
+        }
+    }
+
+    fn syntax_group(&mut self, group: &SyntaxGroup) {
+        match group {
+            SyntaxGroup::Component(component) => {
+                self.u8(0);
+                self.syntax_component(component);
+            },
+            SyntaxGroup::Expression(expression) => {
+                self.u8(1);
+                self.expression(expression);
+            },
+        }
+    }
+
+    fn syntax_component(&mut self, component: &SyntaxComponent) {
+        match component {
+            SyntaxComponent::DataType(data_type) => {
+                self.u8(0);
+                self.code(data_type);
+            },
+            SyntaxComponent::Keyword(keyword) => {
+                self.u8(1);
+                self.string(keyword);
+            },
+            SyntaxComponent::SpaceSeparatedList(data_type) => {
+                self.u8(2);
+                self.code(data_type);
+            },
+            SyntaxComponent::CommaSeparatedList(data_type) => {
+                self.u8(3);
+                self.code(data_type);
+            },
+            SyntaxComponent::Repeat { data_type, minimum, maximum } => {
+                self.u8(4);
+                self.code(data_type);
+                self.u64(*minimum as u64);
+                self.u64(*maximum as u64);
+            },
+            SyntaxComponent::Comma => self.u8(5),
+        }
+    }
+
+    fn definition_reference(&mut self, definition: &Arc<PropertyDefinition>) {
+        let index = self.definitions[&Arc::as_ptr(definition)];
+        self.u32(index);
+    }
+
+    fn stylesheet(&mut self, sheet: &StyleSheet) {
+        self.string(&sheet.path.to_string_lossy());
+
+        self.u32(sheet.rules.len() as u32);
+        sheet.rules.iter().for_each(|rule| self.rule(rule));
+
+        self.u32(sheet.errors.len() as u32);
+        sheet.errors.iter().for_each(|error| self.error(error));
+
+        self.u32(sheet.defined_properties.len() as u32);
+        for definition in &sheet.defined_properties {
+            self.definition_reference(definition);
+        }
+
+        self.u32(sheet.imported_sheets.len() as u32);
+        sheet.imported_sheets.iter().for_each(|imported| self.stylesheet(imported));
+
+        self.u32(sheet.contributions.len() as u32);
+        for contribution in &sheet.contributions {
+            match contribution {
+                Contribution::Import(index) => {
+                    self.u8(0);
+                    self.u32(*index as u32);
+                },
+                Contribution::Parse { rules, errors } => {
+                    self.u8(1);
+                    for value in [rules.start, rules.end, errors.start, errors.end] {
+                        self.u32(value as u32);
+                    }
+                },
+            }
+        }
+
+        self.u32(sheet.next_source_order as u32);
+    }
+
+    fn rule(&mut self, rule: &StyleRule) {
+        self.u32(rule.source_order as u32);
+
+        self.u32(rule.selector.parts.len() as u32);
+        rule.selector.parts.iter().for_each(|part| self.selector_part(part));
+
+        self.u32(rule.properties.len() as u32);
+        for property in rule.properties.iter() {
+            self.string(property.name.as_str());
+            self.definition_reference(&property.definition);
+            self.values(&property.values);
+        }
+    }
+
+    fn selector_part(&mut self, part: &SelectorPart) {
+        self.code(&part.kind);
+        match &part.value {
+            SelectorValue::Empty => self.u8(0),
+            SelectorValue::Value(value) => {
+                self.u8(1);
+                self.value(value);
+            },
+            SelectorValue::Attribute { name, operator, value } => {
+                self.u8(2);
+                self.string(name);
+                self.code(operator);
+                self.value(value);
+            },
+        }
+    }
+
+    fn error(&mut self, error: &ParseError) {
+        self.code(&error.kind);
+        self.string(&error.message);
+        self.string(&error.location.file);
+        self.u32(error.location.line);
+        self.u32(error.location.column);
+    }
+}
+
+struct Reader<'a> {
+    data: &'a [u8],
+    position: usize,
+    definitions: Vec<Arc<PropertyDefinition>>,
+    // Blocks are stored once per rule, this shares them again.
+    blocks: BlockInterner,
+}
+
+impl<'a> Reader<'a> {
+    fn bytes(&mut self, count: usize) -> Option<&'a [u8]> {
+        let end = self.position.checked_add(count)?;
+        let bytes = self.data.get(self.position..end)?;
+        self.position = end;
+        Some(bytes)
+    }
+
+    fn u8(&mut self) -> Option<u8> {
+        Some(self.bytes(1)?[0])
+    }
+
+    fn u32(&mut self) -> Option<u32> {
+        Some(u32::from_le_bytes(self.bytes(4)?.try_into().ok()?))
+    }
+
+    fn u64(&mut self) -> Option<u64> {
+        Some(u64::from_le_bytes(self.bytes(8)?.try_into().ok()?))
+    }
+
+    fn i32(&mut self) -> Option<i32> {
+        Some(i32::from_le_bytes(self.bytes(4)?.try_into().ok()?))
+    }
+
+    fn f32(&mut self) -> Option<f32> {
+        Some(f32::from_le_bytes(self.bytes(4)?.try_into().ok()?))
+    }
+
+    fn string(&mut self) -> Option<String> {
+        let length = self.u32()? as usize;
+        let bytes = self.bytes(length)?;
+        std::str::from_utf8(bytes).ok().map(str::to_string)
+    }
+
+    fn code<T: Code>(&mut self) -> Option<T> {
+        T::from_code(self.u8()?)
+    }
+
+    fn list<T>(&mut self, mut item: impl FnMut(&mut Self) -> Option<T>) -> Option<Vec<T>> {
+        let count = self.u32()? as usize;
+        // Don't trust count for the allocation, a corrupt file could
+        // otherwise request a huge amount of memory.
+        let mut result = Vec::with_capacity(count.min(self.data.len() - self.position));
+        for _ in 0..count {
+            result.push(item(self)?);
+        }
+        Some(result)
+    }
+
+    fn value(&mut self) -> Option<Value> {
+        let data = match self.u8()? {
+            0 => ValueData::Empty,
+            1 => ValueData::Dimension(Dimension { value: self.f32()?, unit: self.code()? }),
+            2 => ValueData::String(self.string()?),
+            3 => ValueData::Color(self.color()?),
+            4 => ValueData::Image(self.string()?),
+            5 => ValueData::Url(self.string()?),
+            6 => ValueData::Integer(self.i32()?),
+            _ => return None,
+        };
+        Some(Value { data })
+    }
+
+    fn color(&mut self) -> Option<Color> {
+        let data = match self.u8()? {
+            0 => ColorData::Empty,
+            1 => {
+                let bytes = self.bytes(4)?;
+                ColorData::Rgba { r: bytes[0], g: bytes[1], b: bytes[2], a: bytes[3] }
+            },
+            2 => ColorData::Custom { source: self.string()?, arguments: self.list(Self::string)? },
+            3 => ColorData::Modified { color: Box::new(self.color()?), operation: self.color_operation()? },
+            _ => return None,
+        };
+        Some(Color { data })
+    }
+
+    fn color_operation(&mut self) -> Option<ColorOperation> {
+        let operation = match self.u8()? {
+            0 => {
+                let mut components = [None; 4];
+                for component in &mut components {
+                    let bytes = self.bytes(2)?;
+                    *component = if bytes[0] != 0 { Some(bytes[1]) } else { None };
+                }
+                let [r, g, b, a] = components;
+                ColorOperation::Set { r, g, b, a }
+            },
+            1 => ColorOperation::Add { other: Box::new(self.color()?) },
+            2 => ColorOperation::Subtract { other: Box::new(self.color()?) },
+            3 => ColorOperation::Multiply { other: Box::new(self.color()?) },
+            4 => ColorOperation::Mix { other: Box::new(self.color()?), amount: self.f32()? },
+            _ => return None,
+        };
+        Some(operation)
+    }
+
+    fn definition(&mut self) -> Option<PropertyDefinition> {
+        let name = self.string()?;
+        let syntax = self.syntax()?;
+        let inherit = self.u8()? != 0;
+        Some(PropertyDefinition::new(name, syntax, inherit, self.list(Self::value)?))
+    }
+
+    fn syntax(&mut self) -> Option<ParsedPropertySyntax> {
+        match self.u8()? {
+            0 => Some(ParsedPropertySyntax::Empty),
+            1 => Some(ParsedPropertySyntax::Universal),
+            2 => Some(ParsedPropertySyntax::Expression(self.expression()?)),
+            _ => None,
+        }
+    }
+
+    fn expression(&mut self) -> Option<Vec<SyntaxAlternatives>> {
+        self.list(|reader| {
+            match reader.u8()? {
+                0 => Some(SyntaxAlternatives::Component(reader.syntax_component()?)),
+                1 => Some(SyntaxAlternatives::Group(reader.syntax_group()?)),
+                2 => Some(SyntaxAlternatives::Alternatives(reader.list(Self::syntax_group)?)),
+                _ => None,
+            }
+        })
+    }
+
+    fn syntax_group(&mut self) -> Option<SyntaxGroup> {
+        match self.u8()? {
+            0 => Some(SyntaxGroup::Component(self.syntax_component()?)),
+            1 => Some(SyntaxGroup::Expression(self.expression()?)),
+            _ => None,
+        }
+    }
+
+    fn syntax_component(&mut self) -> Option<SyntaxComponent> {
+        match self.u8()? {
+            0 => Some(SyntaxComponent::DataType(self.code()?)),
+            1 => Some(SyntaxComponent::Keyword(self.string()?)),
+            2 => Some(SyntaxComponent::SpaceSeparatedList(self.code()?)),
+            3 => Some(SyntaxComponent::CommaSeparatedList(self.code()?)),
+            4 => Some(SyntaxComponent::Repeat {
+                data_type: self.code()?,
+                minimum: self.u64()? as usize,
+                maximum: self.u64()? as usize,
+            }),
+            5 => Some(SyntaxComponent::Comma),
+            _ => None,
+        }
+    }
+
+    fn definition_reference(&mut self) -> Option<Arc<PropertyDefinition>> {
+        let index = self.u32()? as usize;
+        self.definitions.get(index).cloned()
+    }
+
+    fn stylesheet(&mut self, registry: &PropertyRegistry) -> Option<StyleSheet> {
+        let mut sheet = StyleSheet::new_with_registry(PathBuf::from(self.string()?), registry);
+        sheet.rules = self.list(Self::rule)?;
+        sheet.errors = self.list(Self::error)?;
+        sheet.defined_properties = self.list(Self::definition_reference)?;
+        sheet.imported_sheets = self.list(|reader| reader.stylesheet(registry))?;
+        sheet.contributions = self.list(|reader| {
+            match reader.u8()? {
+                0 => {
+                    let index = reader.u32()? as usize;
+                    (index < sheet.imported_sheets.len()).then_some(Contribution::Import(index))
+                },
+                1 => {
+                    let (rules_start, rules_end) = (reader.u32()? as usize, reader.u32()? as usize);
+                    let (errors_start, errors_end) = (reader.u32()? as usize, reader.u32()? as usize);
+                    let valid = rules_start <= rules_end && rules_end <= sheet.rules.len()
+                        && errors_start <= errors_end && errors_end <= sheet.errors.len();
+                    valid.then_some(Contribution::Parse { rules: rules_start..rules_end, errors: errors_start..errors_end })
+                },
+                _ => None,
+            }
+        })?;
+        sheet.next_source_order = self.u32()? as usize;
+
+        Some(sheet)
+    }
+
+    fn rule(&mut self) -> Option<StyleRule> {
+        let source_order = self.u32()? as usize;
+        let parts = self.list(Self::selector_part)?;
+        let properties = self.list(|reader| {
+            Some(Property {
+                name: Atom::from(reader.string()?),
+                definition: reader.definition_reference()?,
+                values: reader.list(Self::value)?,
+            })
+        })?;
+        let properties = self.blocks.intern(&PropertyBlock::new(properties));
+        // Specificity is cheap to compute from the selector, so it is not
+        // stored.
+        Some(StyleRule::new(Selector { parts }, properties, source_order))
+    }
+
+    fn selector_part(&mut self) -> Option<SelectorPart> {
+        let kind = self.code()?;
+        let value = match self.u8()? {
+            0 => SelectorValue::Empty,
+            1 => SelectorValue::Value(self.value()?),
+            2 => SelectorValue::Attribute { name: self.string()?, operator: self.code()?, value: self.value()? },
+            _ => return None,
+        };
+        Some(SelectorPart::new(kind, value))
+    }
+
+    fn error(&mut self) -> Option<ParseError> {
+        Some(ParseError {
+            kind: self.code()?,
+            message: self.string()?.into(),
+            location: SourceLocation { file: self.string()?, line: self.u32()?, column: self.u32()? },
+        })
+    }
+}
@@ -4,13 +4,16 @@
 use precomputed_hash::PrecomputedHash;
 use cssparser::ToCss;
 
+use crate::atom::Atom;
+
+// The atom is interned when the identifier is created, so the hash used by
+// selectors is just the atom's index.
 #[derive(Eq, PartialEq, Clone, Default, Debug)]
-pub struct Identifier(String);
+pub struct Identifier(String, Atom);
 
 impl PrecomputedHash for Identifier {
     fn precomputed_hash(&self) -> u32 {
-        // let Identifier(contents) = self;
-        return 0;
+        self.1.id()
     }
 }
 
@@ -24,7 +27,7 @@ impl ToCss for Identifier {
 
 impl <'a> From<&'a str> for Identifier {
     fn from(value: &'a str) -> Self {
-        return Identifier(value.to_string());
+        return Identifier(value.to_string(), Atom::new(value));
     }
 }
 
@@ -51,3 +54,29 @@ impl Into<String> for &Identifier {
         self.0.clone()
     }
 }
+
+// The value of an attribute selector. Attribute values are compared as
+// strings when matching, so unlike Identifier they are not interned, which
+// would add every value used in a StyleSheet to the atom table for good.
+#[derive(Eq, PartialEq, Clone, Default, Debug)]
+pub struct AttributeValue(String);
+
+impl ToCss for AttributeValue {
+    fn to_css<W>(&self, dest: &mut W) -> std::fmt::Result
+    where
+    W: std::fmt::Write {
+        dest.write_str(&self.0)
+    }
+}
+
+impl <'a> From<&'a str> for AttributeValue {
+    fn from(value: &'a str) -> Self {
+        AttributeValue(value.to_string())
+    }
+}
+
+impl AttributeValue {
+    pub fn as_str(&self) -> &str {
+        &self.0
+    }
+}
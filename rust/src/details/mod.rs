@@ -1,16 +1,34 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 // SPDX-FileCopyrightText: 2025 Arjen Hiemstra <ahiemstra@heimr.nl>
 
+pub mod cache;
 pub mod identifier;
+pub mod parallel;
+pub mod parsecontext;
+pub mod prescan;
 pub mod rulesparser;
 pub mod selectorparser;
 
 pub mod property;
 
+use std::borrow::Cow;
+
 use crate::parseerror::{ParseError, ParseErrorKind, SourceLocation};
 
-pub fn parse_error<'i, 't, R>(parser: &cssparser::Parser<'i, 't>, kind: ParseErrorKind, message: String) -> Result<R, cssparser::ParseError<'i, ParseError>> {
-    Err(parser.new_custom_error(ParseError{ kind, message, location: SourceLocation::from_file_location(parser.current_source_url().unwrap_or("").to_string(), parser.current_source_location())}))
+// The file name to use for errors reported by `parser`.
+pub fn source_file(parser: &cssparser::Parser) -> String {
+    match parser.current_source_url() {
+        Some(url) => url.to_string(),
+        None => parsecontext::current_file(),
+    }
+}
+
+// Create an error for the current position of `parser`. `message` is
+// usually a string literal, which is stored without copying it. Errors that
+// are created while trying alternatives are discarded, so they should not
+// format their message.
+pub fn parse_error<'i, 't, R>(parser: &cssparser::Parser<'i, 't>, kind: ParseErrorKind, message: impl Into<Cow<'static, str>>) -> Result<R, cssparser::ParseError<'i, ParseError>> {
+    Err(parser.new_custom_error(ParseError{ kind, message: message.into(), location: SourceLocation::from_file_location(source_file(parser), parser.current_source_location())}))
 }
 
 pub fn unwrap_parse_error<'i, 't, R>(error: &'t Result<R, cssparser::ParseError<'i, ParseError>>) -> Option<&'t ParseError> {
@@ -48,11 +66,11 @@ impl ToParseError for cssparser::BasicParseErrorKind<'_> {
     fn to_parse_error(&self, file: String, location: cssparser::SourceLocation) -> ParseError {
         let location = SourceLocation::from_file_location(file, location);
         match self {
-            cssparser::BasicParseErrorKind::UnexpectedToken(token) => ParseError{ kind: ParseErrorKind::UnexpectedToken, message: format!("{:?}", token), location },
-            cssparser::BasicParseErrorKind::EndOfInput => ParseError{ kind: ParseErrorKind::UnexpectedEndOfInput, message: String::new(), location },
-            cssparser::BasicParseErrorKind::AtRuleInvalid(at_rule) => ParseError{ kind: ParseErrorKind::InvalidAtRule, message: at_rule.to_string(), location },
-            cssparser::BasicParseErrorKind::AtRuleBodyInvalid => ParseError{ kind: ParseErrorKind::InvalidAtRule, message: String::from("Invalid @-rule body"), location },
-            cssparser::BasicParseErrorKind::QualifiedRuleInvalid => ParseError{ kind:ParseErrorKind::InvalidQualifiedRule, message: String::new(), location },
+            cssparser::BasicParseErrorKind::UnexpectedToken(token) => ParseError{ kind: ParseErrorKind::UnexpectedToken, message: format!("{:?}", token).into(), location },
+            cssparser::BasicParseErrorKind::EndOfInput => ParseError{ kind: ParseErrorKind::UnexpectedEndOfInput, message: "".into(), location },
+            cssparser::BasicParseErrorKind::AtRuleInvalid(at_rule) => ParseError{ kind: ParseErrorKind::InvalidAtRule, message: at_rule.to_string().into(), location },
+            cssparser::BasicParseErrorKind::AtRuleBodyInvalid => ParseError{ kind: ParseErrorKind::InvalidAtRule, message: "Invalid @-rule body".into(), location },
+            cssparser::BasicParseErrorKind::QualifiedRuleInvalid => ParseError{ kind:ParseErrorKind::InvalidQualifiedRule, message: "".into(), location },
         }
     }
 }
@@ -63,11 +81,11 @@ impl ToParseError for selectors::parser::SelectorParseErrorKind<'_>
         let location = SourceLocation::from_file_location(file, location);
         match self {
             selectors::parser::SelectorParseErrorKind::NoQualifiedNameInAttributeSelector(_) =>
-                ParseError{ kind: ParseErrorKind::InvalidSelectors, message: String::from("No qualified name in attribute selector"), location },
-            selectors::parser::SelectorParseErrorKind::EmptySelector => ParseError{ kind: ParseErrorKind::InvalidSelectors, message: String::from("Empty Selector"), location },
-            selectors::parser::SelectorParseErrorKind::DanglingCombinator => ParseError{ kind: ParseErrorKind::InvalidSelectors, message: String::from("Dangling Combinator"), location },
-            selectors::parser::SelectorParseErrorKind::NonCompoundSelector => ParseError{ kind: ParseErrorKind::InvalidSelectors, message: String::from("Non-compound Selector"), location },
-            _ => ParseError{ kind: ParseErrorKind::InvalidSelectors, message: String::from("Selectors failed to parse"), location },
+                ParseError{ kind: ParseErrorKind::InvalidSelectors, message: "No qualified name in attribute selector".into(), location },
+            selectors::parser::SelectorParseErrorKind::EmptySelector => ParseError{ kind: ParseErrorKind::InvalidSelectors, message: "Empty Selector".into(), location },
+            selectors::parser::SelectorParseErrorKind::DanglingCombinator => ParseError{ kind: ParseErrorKind::InvalidSelectors, message: "Dangling Combinator".into(), location },
+            selectors::parser::SelectorParseErrorKind::NonCompoundSelector => ParseError{ kind: ParseErrorKind::InvalidSelectors, message: "Non-compound Selector".into(), location },
+            _ => ParseError{ kind: ParseErrorKind::InvalidSelectors, message: "Selectors failed to parse".into(), location },
         }
     }
 }
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+// Parsing chunks of a single StyleSheet on multiple threads.
+//
+// Every thread parses its chunk with a parse context of its own, using a
+// registry that has the registry of the StyleSheet as parent. That way the
+// definitions a chunk adds are only visible to the chunk itself, and the
+// StyleSheet can decide afterwards whether the result of a chunk is the same
+// as when it would have been parsed after the chunks in front of it.
+
+use std::path::Path;
+use std::sync::Arc;
+use std::thread;
+
+use crate::details::parse_error_from_cssparser_error;
+use crate::details::parsecontext::{check_cancelled, count, enter_parse_context, take_defined, take_missed_lookups, take_statistics, timed, track_missed_lookups};
+use crate::details::prescan::Chunk;
+use crate::details::rulesparser::{ParseResult, TopLevelParser};
+use crate::parseerror::{ParseError, ParseErrorKind, SourceLocation};
+use crate::property::{add_property_definition, PropertyDefinition, PropertyRegistry};
+use crate::statistics::{FileStatistics, Phase};
+use crate::stylerule::StyleRule;
+use crate::stylesheet::ParseOptions;
+
+#[derive(Debug, Default)]
+pub struct ChunkResult {
+    pub rules: Vec<StyleRule>,
+    pub errors: Vec<ParseError>,
+    // The error parsing stopped with, if it was cancelled.
+    pub stopped: Option<ParseError>,
+    // The definitions the chunk added to its registry, in order.
+    pub defined: Vec<Arc<PropertyDefinition>>,
+    // The names of properties the chunk looked up without finding them.
+    pub missed: Vec<String>,
+    pub statistics: Option<FileStatistics>,
+}
+
+fn unexpected_entry(kind: ParseErrorKind, message: &'static str, file: &str, location: cssparser::SourceLocation) -> ParseError {
+    ParseError { kind, message: message.into(), location: SourceLocation::from_file_location(file.to_string(), location) }
+}
+
+// Parse `chunk` of `input` using the parse context that is currently active.
+//
+// Limits other than cancellation are not checked, chunks are only parsed
+// separately if there are none.
+pub fn parse_chunk(input: &str, chunk: &Chunk, path: &Path) -> ChunkResult {
+    let file = path.to_string_lossy().to_string();
+    // Lines are reported starting at 1.
+    let mut parser_input = cssparser::ParserInput::new_with_line_number_offset(&input[chunk.range.clone()], chunk.line + 1);
+    let mut parser = cssparser::Parser::new(&mut parser_input);
+    let mut rules_parser = TopLevelParser{};
+    let mut style_sheet_parser = cssparser::StyleSheetParser::new(&mut parser, &mut rules_parser);
+
+    let mut result = ChunkResult::default();
+    while let Some(entry) = style_sheet_parser.next() {
+        if let Some(error) = check_cancelled() {
+            result.stopped = Some(error);
+            break;
+        }
+
+        match entry {
+            Ok(ParseResult::Rule(rule)) => {
+                let start = result.rules.len();
+                timed(Phase::Flatten, || StyleRule::from_parsed_rule_into(&rule, path, &mut result.rules));
+                count(|statistics| statistics.rules += result.rules.len() - start);
+            },
+            Ok(ParseResult::PropertyDefinition(definition)) => {
+                add_property_definition(&Arc::new(definition));
+            },
+            // Chunks only start after the last @import, so these can only
+            // happen if the pre-scan and the parser disagree. They are
+            // reported instead of parsed since they can't be handled here.
+            Ok(ParseResult::Import(_)) => {
+                result.errors.push(unexpected_entry(ParseErrorKind::UnsupportedAtRule, "@import can only be used in front of the rules that are parsed in parallel", &file, style_sheet_parser.input.current_source_location()));
+            },
+            Ok(ParseResult::Property(_)) => {
+                result.errors.push(unexpected_entry(ParseErrorKind::UnexpectedToken, "Properties can not be used at top level", &file, style_sheet_parser.input.current_source_location()));
+            },
+            Err(error) => result.errors.push(parse_error_from_cssparser_error(&error.0, file.clone())),
+        }
+    }
+
+    result
+}
+
+// Parse every entry of `chunks` on a thread of its own.
+pub fn parse_chunks(input: &str, chunks: &[Chunk], path: &Path, registry: &PropertyRegistry, options: &ParseOptions) -> Vec<ChunkResult> {
+    let file = path.to_string_lossy().to_string();
+
+    thread::scope(|scope| {
+        let handles: Vec<_> = chunks.iter().map(|chunk| {
+            let file = &file;
+            scope.spawn(move || {
+                let registry = PropertyRegistry::new_with_parent(registry);
+                let _context = enter_parse_context(&registry, file, options);
+                track_missed_lookups();
+
+                let mut result = parse_chunk(input, chunk, path);
+                result.defined = take_defined();
+                result.missed = take_missed_lookups();
+                result.statistics = take_statistics();
+                result
+            })
+        }).collect();
+
+        handles.into_iter().map(|handle| handle.join().unwrap_or_else(|panic| std::panic::resume_unwind(panic))).collect()
+    })
+}
@@ -0,0 +1,345 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+// State that applies to the parse that is currently running on this thread.
+//
+// The cssparser traits and property functions do not allow passing along
+// extra state, so this is stored in a thread local instead. A StyleSheet
+// enters a context for the duration of a parse, the returned guard restores
+// the previous context when it is dropped so nested parses (for @import)
+// work as expected.
+//
+// Besides the registry and file, a context tracks the limits of
+// ParseOptions and the property blocks that were parsed. A context that is
+// entered while another one is active, like that of an imported file, shares
+// both with the outer context, so the limits apply to everything it parses
+// and identical blocks in different files are only stored once. Statistics,
+// if enabled, are collected separately for every context so they are per
+// file.
+
+use std::cell::{Cell, RefCell};
+use std::rc::Rc;
+use std::sync::Arc;
+use std::time::Instant;
+
+use crate::parseerror::{ParseError, ParseErrorKind, SourceLocation};
+use crate::property::{BlockInterner, PropertyBlock, PropertyDefinition, PropertyRegistry};
+use crate::statistics::{FileStatistics, Phase};
+use crate::stylesheet::ParseOptions;
+
+// What was parsed so far, counted against the limits of `options`.
+#[derive(Default)]
+struct ParseBudget {
+    options: ParseOptions,
+    errors: usize,
+    rules: usize,
+    input: usize,
+    // Whether one of the limits was exceeded.
+    stopped: bool,
+}
+
+impl ParseBudget {
+    fn stop(&mut self, error: ParseError) -> Option<ParseError> {
+        self.stopped = true;
+        Some(error)
+    }
+}
+
+struct ParseContext {
+    registry: PropertyRegistry,
+    file: String,
+    // Definitions that were added to the registry by this parse.
+    defined: Vec<Arc<PropertyDefinition>>,
+    budget: Rc<RefCell<ParseBudget>>,
+    blocks: Rc<RefCell<BlockInterner>>,
+    // How many rule blocks the parser is currently inside of.
+    depth: usize,
+    statistics: Option<FileStatistics>,
+    // Names of properties that were looked up but not found, only recorded
+    // if enabled with track_missed_lookups().
+    missed: Option<Vec<String>>,
+}
+
+thread_local! {
+    static CURRENT: RefCell<Option<ParseContext>> = const { RefCell::new(None) };
+    // Whether the current context collects statistics. This is checked
+    // before doing anything else, so collecting statistics costs nothing
+    // more than this when it is disabled.
+    static COLLECTING: Cell<bool> = const { Cell::new(false) };
+    // Whether the current parse converts dimensions to canonical units. Like
+    // COLLECTING, this is checked for every dimension so it is kept separate.
+    static CANONICALIZE_UNITS: Cell<bool> = const { Cell::new(false) };
+}
+
+pub struct ParseContextGuard {
+    previous: Option<ParseContext>,
+}
+
+impl Drop for ParseContextGuard {
+    fn drop(&mut self) {
+        let previous = self.previous.take();
+        COLLECTING.with(|collecting| collecting.set(previous.as_ref().is_some_and(|context| context.statistics.is_some())));
+        CANONICALIZE_UNITS.with(|canonicalize| canonicalize.set(previous.as_ref().is_some_and(|context| context.budget.borrow().options.canonicalize_units)));
+        CURRENT.with(|current| *current.borrow_mut() = previous);
+    }
+}
+
+// `file` is the name of the file that is being parsed. It is used for the
+// location of errors instead of passing it through cssparser.
+//
+// `options` is only used if no other context is active, otherwise the limits
+// of that context apply.
+pub fn enter_parse_context(registry: &PropertyRegistry, file: &str, options: &ParseOptions) -> ParseContextGuard {
+    let outer = CURRENT.with(|current| current.borrow().as_ref().map(|context| (context.budget.clone(), context.blocks.clone())));
+    let (budget, blocks) = outer.unwrap_or_else(|| (Rc::new(RefCell::new(ParseBudget { options: options.clone(), ..Default::default() })), Rc::default()));
+
+    let statistics = options.collect_statistics.then(|| FileStatistics::new(file.into()));
+    COLLECTING.with(|collecting| collecting.set(statistics.is_some()));
+    CANONICALIZE_UNITS.with(|canonicalize| canonicalize.set(budget.borrow().options.canonicalize_units));
+
+    let context = ParseContext { registry: registry.clone(), file: file.to_string(), defined: Vec::new(), budget, blocks, depth: 0, statistics, missed: None };
+    let previous = CURRENT.with(|current| current.replace(Some(context)));
+    ParseContextGuard { previous }
+}
+
+fn limit_error(message: String, location: SourceLocation) -> ParseError {
+    ParseError { kind: ParseErrorKind::LimitExceeded, message: message.into(), location }
+}
+
+fn with_budget<R: Default>(function: impl FnOnce(&mut ParseBudget, &str) -> R) -> R {
+    CURRENT.with(|current| {
+        match current.borrow().as_ref() {
+            Some(context) => function(&mut context.budget.borrow_mut(), &context.file),
+            None => R::default(),
+        }
+    })
+}
+
+// Returns the error to stop parsing with if the current parse was cancelled.
+pub fn check_cancelled() -> Option<ParseError> {
+    with_budget(|budget, file| {
+        match &budget.options.cancellation {
+            Some(cancellation) if cancellation.is_cancelled() => {
+                budget.stop(ParseError { kind: ParseErrorKind::Cancelled, message: "".into(), location: SourceLocation::from_file(file) })
+            },
+            _ => None,
+        }
+    })
+}
+
+// Count `bytes` of input against the limits of the current parse. Returns
+// the error to stop parsing with if the input is too large or the parse was
+// cancelled.
+pub fn count_input(bytes: usize) -> Option<ParseError> {
+    if let Some(error) = check_cancelled() {
+        return Some(error);
+    }
+
+    with_budget(|budget, file| {
+        budget.input += bytes;
+        match budget.options.max_input_size {
+            Some(maximum) if budget.input > maximum => {
+                budget.stop(limit_error(format!("Input is larger than {} bytes", maximum), SourceLocation::from_file(file)))
+            },
+            _ => None,
+        }
+    })
+}
+
+// Count `count` rules against the limits of the current parse. Returns the
+// error to stop parsing with if there are too many rules.
+pub fn count_rules(count: usize, location: &SourceLocation) -> Option<ParseError> {
+    with_budget(|budget, _| {
+        budget.rules += count;
+        match budget.options.max_rules {
+            Some(maximum) if budget.rules > maximum => budget.stop(limit_error(format!("More than {} rules", maximum), location.clone())),
+            _ => None,
+        }
+    })
+}
+
+// Count `error` against the limits of the current parse. Returns the error to
+// stop parsing with if parsing should stop, otherwise `error` should be
+// recorded.
+pub fn count_error(error: &ParseError) -> Option<ParseError> {
+    with_budget(|budget, _| {
+        if budget.options.stop_at_first_error {
+            return budget.stop(error.clone());
+        }
+
+        budget.errors += 1;
+        match budget.options.max_errors {
+            Some(maximum) if budget.errors > maximum => budget.stop(limit_error(format!("More than {} errors", maximum), error.location.clone())),
+            _ => None,
+        }
+    })
+}
+
+// Whether the current parse stopped because one of the limits was exceeded.
+pub fn parse_stopped() -> bool {
+    with_budget(|budget, _| budget.stopped)
+}
+
+pub struct BlockGuard;
+
+impl Drop for BlockGuard {
+    fn drop(&mut self) {
+        CURRENT.with(|current| {
+            if let Some(context) = current.borrow_mut().as_mut() {
+                context.depth -= 1;
+            }
+        })
+    }
+}
+
+// Enter a rule block. Returns the maximum nesting depth as error if that
+// would exceed it, otherwise the depth is restored when the returned guard is
+// dropped.
+pub fn enter_block() -> Result<BlockGuard, usize> {
+    CURRENT.with(|current| {
+        let mut current = current.borrow_mut();
+        let Some(context) = current.as_mut() else {
+            return Ok(BlockGuard);
+        };
+
+        if let Some(maximum) = context.budget.borrow().options.max_nesting_depth {
+            if context.depth >= maximum {
+                return Err(maximum);
+            }
+        }
+
+        context.depth += 1;
+        Ok(BlockGuard)
+    })
+}
+
+pub fn with_current_registry<R>(function: impl FnOnce(&PropertyRegistry) -> R) -> R {
+    CURRENT.with(|current| {
+        match current.borrow().as_ref() {
+            Some(context) => function(&context.registry),
+            None => function(PropertyRegistry::global()),
+        }
+    })
+}
+
+pub fn current_file() -> String {
+    CURRENT.with(|current| current.borrow().as_ref().map(|context| context.file.clone()).unwrap_or_default())
+}
+
+// Returns the block equal to `block` that was used before during the current
+// parse, or `block` if there is none.
+pub fn intern_block(block: &PropertyBlock) -> PropertyBlock {
+    CURRENT.with(|current| {
+        match current.borrow().as_ref() {
+            Some(context) => context.blocks.borrow_mut().intern(block),
+            None => block.clone(),
+        }
+    })
+}
+
+// Start recording the names of properties that are looked up in the registry
+// of the current context without finding a definition.
+pub fn track_missed_lookups() {
+    CURRENT.with(|current| {
+        if let Some(context) = current.borrow_mut().as_mut() {
+            context.missed = Some(Vec::new());
+        }
+    })
+}
+
+pub fn record_missed_lookup(name: &str) {
+    CURRENT.with(|current| {
+        if let Some(missed) = current.borrow_mut().as_mut().and_then(|context| context.missed.as_mut()) {
+            missed.push(name.to_string());
+        }
+    })
+}
+
+// Returns the names recorded since track_missed_lookups() was called.
+pub fn take_missed_lookups() -> Vec<String> {
+    CURRENT.with(|current| {
+        current.borrow_mut().as_mut()
+            .and_then(|context| context.missed.as_mut())
+            .map(std::mem::take)
+            .unwrap_or_default()
+    })
+}
+
+pub fn add_definition(definition: &Arc<PropertyDefinition>) -> bool {
+    CURRENT.with(|current| {
+        match current.borrow_mut().as_mut() {
+            Some(context) => {
+                let added = context.registry.add(definition);
+                if added {
+                    context.defined.push(definition.clone());
+                }
+                added
+            },
+            None => PropertyRegistry::global().add(definition),
+        }
+    })
+}
+
+fn with_statistics(function: impl FnOnce(&mut FileStatistics)) {
+    if !COLLECTING.with(|collecting| collecting.get()) {
+        return;
+    }
+
+    CURRENT.with(|current| {
+        if let Some(statistics) = current.borrow_mut().as_mut().and_then(|context| context.statistics.as_mut()) {
+            function(statistics);
+        }
+    })
+}
+
+// Run `function` and add the time it took to `phase` of the statistics of the
+// current context.
+pub fn timed<R>(phase: Phase, function: impl FnOnce() -> R) -> R {
+    if !COLLECTING.with(|collecting| collecting.get()) {
+        return function();
+    }
+
+    let start = Instant::now();
+    let result = function();
+    let elapsed = start.elapsed();
+
+    with_statistics(|statistics| {
+        match phase {
+            Phase::Selectors => statistics.selectors += elapsed,
+            Phase::Values => statistics.values += elapsed,
+            Phase::Flatten => statistics.flatten += elapsed,
+        }
+    });
+
+    result
+}
+
+// Update the statistics of the current context, if it collects them.
+pub fn count(function: impl FnOnce(&mut FileStatistics)) {
+    with_statistics(function)
+}
+
+// Whether dimensions should be converted to canonical units, see
+// ParseOptions::canonicalize_units.
+pub fn canonicalize_units() -> bool {
+    CANONICALIZE_UNITS.with(|canonicalize| canonicalize.get())
+}
+
+// Returns the statistics collected by the current context so far and resets
+// them.
+pub fn take_statistics() -> Option<FileStatistics> {
+    CURRENT.with(|current| {
+        current.borrow_mut().as_mut()
+            .and_then(|context| context.statistics.as_mut())
+            .map(|statistics| {
+                let path = statistics.path.clone();
+                std::mem::replace(statistics, FileStatistics::new(path))
+            })
+    })
+}
+
+// Returns the definitions that were added to the registry since the current
+// context was entered or this was last called.
+pub fn take_defined() -> Vec<Arc<PropertyDefinition>> {
+    CURRENT.with(|current| current.borrow_mut().as_mut().map(|context| std::mem::take(&mut context.defined)).unwrap_or_default())
+}
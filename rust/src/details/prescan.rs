@@ -0,0 +1,448 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+// Quick scans over CSS input that run before the actual parse.
+//
+// scan_top_level() splits input into its top-level rules without tokenizing
+// it. It only looks at the bytes that matter for the block structure of CSS:
+// brackets, at-rules, strings, comments, escapes and semicolons. Everything
+// in between is skipped 16 bytes at a time using SSE2 or NEON, which are
+// always available on x86_64 and aarch64 respectively.
+
+use std::ops::Range;
+
+use cssparser::Token;
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum ItemKind {
+    Rule,
+    Import,
+    Property,
+    AtRule,
+}
+
+// A top-level rule of a StyleSheet. `range` starts at the first byte of the
+// rule and ends after its block or the semicolon ending it. Whitespace and
+// comments between rules are not part of any item.
+#[derive(Debug, Clone, PartialEq)]
+pub struct TopLevelItem {
+    pub kind: ItemKind,
+    pub range: Range<usize>,
+}
+
+// The bytes that scan_top_level() needs to look at.
+const SPECIAL: [u8; 12] = [b'{', b'}', b'(', b')', b'[', b']', b'@', b'"', b'\'', b'/', b'\\', b';'];
+
+const fn special_table() -> [bool; 256] {
+    let mut table = [false; 256];
+    let mut index = 0;
+    while index < SPECIAL.len() {
+        table[SPECIAL[index] as usize] = true;
+        index += 1;
+    }
+    table
+}
+
+static IS_SPECIAL: [bool; 256] = special_table();
+
+fn find_special_scalar(bytes: &[u8], from: usize) -> usize {
+    bytes[from..].iter().position(|byte| IS_SPECIAL[*byte as usize]).map_or(bytes.len(), |position| from + position)
+}
+
+// Returns the position of the first special byte at or after `from`, or the
+// length of `bytes` if there is none.
+#[cfg(target_arch = "x86_64")]
+fn find_special(bytes: &[u8], from: usize) -> usize {
+    use std::arch::x86_64::*;
+
+    let mut position = from;
+    // Safety: SSE2 is part of the x86_64 baseline and every load reads 16
+    // bytes that are within `bytes`.
+    unsafe {
+        let needles = SPECIAL.map(|byte| _mm_set1_epi8(byte as i8));
+        while position + 16 <= bytes.len() {
+            let chunk = _mm_loadu_si128(bytes.as_ptr().add(position) as *const __m128i);
+            let matches = needles.iter().fold(_mm_setzero_si128(), |matches, needle| _mm_or_si128(matches, _mm_cmpeq_epi8(chunk, *needle)));
+            let mask = _mm_movemask_epi8(matches) as u32;
+            if mask != 0 {
+                return position + mask.trailing_zeros() as usize;
+            }
+            position += 16;
+        }
+    }
+
+    find_special_scalar(bytes, position)
+}
+
+#[cfg(target_arch = "aarch64")]
+fn find_special(bytes: &[u8], from: usize) -> usize {
+    use std::arch::aarch64::*;
+
+    let mut position = from;
+    // Safety: NEON is part of the aarch64 baseline and every load reads 16
+    // bytes that are within `bytes`.
+    unsafe {
+        let needles = SPECIAL.map(|byte| vdupq_n_u8(byte));
+        while position + 16 <= bytes.len() {
+            let chunk = vld1q_u8(bytes.as_ptr().add(position));
+            let matches = needles.iter().fold(vdupq_n_u8(0), |matches, needle| vorrq_u8(matches, vceqq_u8(chunk, *needle)));
+            // Narrow every byte of the mask to four bits so it fits in a u64.
+            let mask = vget_lane_u64::<0>(vreinterpret_u64_u8(vshrn_n_u16::<4>(vreinterpretq_u16_u8(matches))));
+            if mask != 0 {
+                return position + (mask.trailing_zeros() / 4) as usize;
+            }
+            position += 16;
+        }
+    }
+
+    find_special_scalar(bytes, position)
+}
+
+#[cfg(not(any(target_arch = "x86_64", target_arch = "aarch64")))]
+fn find_special(bytes: &[u8], from: usize) -> usize {
+    find_special_scalar(bytes, from)
+}
+
+fn is_whitespace(byte: u8) -> bool {
+    matches!(byte, b' ' | b'\t' | b'\n' | b'\r' | b'\x0c')
+}
+
+fn is_name_byte(byte: u8) -> bool {
+    byte.is_ascii_alphanumeric() || byte == b'-' || byte == b'_' || byte >= 0x80
+}
+
+// Returns the position after the comment starting at `position`.
+fn skip_comment(bytes: &[u8], position: usize) -> usize {
+    let mut index = position + 2;
+    while index < bytes.len() {
+        match bytes[index..].iter().position(|byte| *byte == b'*') {
+            Some(offset) => index += offset + 1,
+            None => return bytes.len(),
+        }
+
+        if bytes.get(index) == Some(&b'/') {
+            return index + 1;
+        }
+    }
+    bytes.len()
+}
+
+fn is_comment_start(bytes: &[u8], position: usize) -> bool {
+    bytes[position] == b'/' && bytes.get(position + 1) == Some(&b'*')
+}
+
+fn skip_whitespace_and_comments(bytes: &[u8], mut position: usize) -> usize {
+    while position < bytes.len() {
+        if is_whitespace(bytes[position]) {
+            position += 1;
+        } else if is_comment_start(bytes, position) {
+            position = skip_comment(bytes, position);
+        } else {
+            break;
+        }
+    }
+    position
+}
+
+// Returns the position after the string starting at `position`. Like the
+// tokenizer, an unescaped newline ends the string.
+fn skip_string(bytes: &[u8], position: usize) -> usize {
+    let quote = bytes[position];
+    let mut index = position + 1;
+    while index < bytes.len() {
+        match bytes[index] {
+            byte if byte == quote => return index + 1,
+            b'\\' => index += 2,
+            b'\n' | b'\r' | b'\x0c' => return index,
+            _ => index += 1,
+        }
+    }
+    bytes.len()
+}
+
+// If the parenthesis at `position` starts an unquoted url(), returns the
+// position of the closing parenthesis. Unquoted URLs may contain brackets
+// that do not take part in the block structure.
+fn unquoted_url_end(bytes: &[u8], position: usize) -> Option<usize> {
+    if position < 3 || !bytes[position - 3..position].eq_ignore_ascii_case(b"url") {
+        return None;
+    }
+
+    if position > 3 && (is_name_byte(bytes[position - 4]) || bytes[position - 4] == b'\\') {
+        return None;
+    }
+
+    let mut index = position + 1;
+    while index < bytes.len() && is_whitespace(bytes[index]) {
+        index += 1;
+    }
+
+    // A quoted URL is a function, its contents are scanned as usual.
+    if index < bytes.len() && (bytes[index] == b'"' || bytes[index] == b'\'') {
+        return None;
+    }
+
+    while index < bytes.len() {
+        match bytes[index] {
+            b')' => return Some(index),
+            b'\\' => index += 2,
+            _ => index += 1,
+        }
+    }
+    Some(bytes.len())
+}
+
+fn at_rule_kind(bytes: &[u8], position: usize) -> ItemKind {
+    // The lowercase name with escapes resolved, but only as much of it as is
+    // needed to compare it.
+    let mut name = Vec::new();
+    let mut index = position + 1;
+    while index < bytes.len() && name.len() <= "property".len() {
+        let byte = bytes[index];
+        if is_name_byte(byte) {
+            name.push(byte.to_ascii_lowercase());
+            index += 1;
+            continue;
+        }
+
+        if byte != b'\\' || index + 1 >= bytes.len() || matches!(bytes[index + 1], b'\n' | b'\r' | b'\x0c') {
+            break;
+        }
+
+        let digits = bytes[index + 1..].iter().take(6).take_while(|byte| byte.is_ascii_hexdigit()).count();
+        if digits == 0 {
+            name.push(bytes[index + 1].to_ascii_lowercase());
+            index += 2;
+            continue;
+        }
+
+        let code = bytes[index + 1..index + 1 + digits].iter().fold(0u32, |code, digit| code * 16 + (*digit as char).to_digit(16).unwrap());
+        // Anything that is not ASCII cannot be part of the names we look for.
+        name.push(if code < 0x80 { (code as u8).to_ascii_lowercase() } else { 0x80 });
+        index += 1 + digits;
+        if index < bytes.len() && is_whitespace(bytes[index]) {
+            index += 1;
+        }
+    }
+
+    match name.as_slice() {
+        b"import" => ItemKind::Import,
+        b"property" => ItemKind::Property,
+        _ => ItemKind::AtRule,
+    }
+}
+
+// Split `input` into its top-level rules, in order.
+//
+// Every item can be parsed on its own with the same result as when parsing
+// all of `input`, as items only end where no block, string or comment is
+// open.
+pub fn scan_top_level(input: &str) -> Vec<TopLevelItem> {
+    let bytes = input.as_bytes();
+
+    let mut items = Vec::new();
+    // The closing brackets of the blocks that are currently open.
+    let mut blocks: Vec<u8> = Vec::new();
+    let mut current: Option<(ItemKind, usize)> = None;
+    let mut position = 0;
+
+    loop {
+        let Some((kind, start)) = current else {
+            position = skip_whitespace_and_comments(bytes, position);
+            if position >= bytes.len() {
+                break;
+            }
+
+            // The tokenizer skips CDO and CDC tokens in front of top-level
+            // rules.
+            if bytes[position..].starts_with(b"<!--") {
+                position += 4;
+                continue;
+            }
+            if bytes[position..].starts_with(b"-->") {
+                position += 3;
+                continue;
+            }
+
+            let kind = if bytes[position] == b'@' { at_rule_kind(bytes, position) } else { ItemKind::Rule };
+            current = Some((kind, position));
+            continue;
+        };
+
+        position = find_special(bytes, position);
+        if position >= bytes.len() {
+            break;
+        }
+
+        let byte = bytes[position];
+        match byte {
+            b'{' => blocks.push(b'}'),
+            b'[' => blocks.push(b']'),
+            b'(' => match unquoted_url_end(bytes, position) {
+                Some(end) => position = end,
+                None => blocks.push(b')'),
+            },
+            b'}' | b']' | b')' => {
+                // Closing brackets that do not match the innermost block are
+                // ignored, the same as the tokenizer does.
+                if blocks.last() == Some(&byte) {
+                    blocks.pop();
+                    if blocks.is_empty() && byte == b'}' {
+                        items.push(TopLevelItem { kind, range: start..position + 1 });
+                        current = None;
+                    }
+                }
+            },
+            b';' => {
+                if blocks.is_empty() && kind != ItemKind::Rule {
+                    items.push(TopLevelItem { kind, range: start..position + 1 });
+                    current = None;
+                }
+            },
+            b'"' | b'\'' => {
+                position = skip_string(bytes, position);
+                continue;
+            },
+            b'/' => {
+                if is_comment_start(bytes, position) {
+                    position = skip_comment(bytes, position);
+                    continue;
+                }
+            },
+            b'\\' => position += 1,
+            _ => {},
+        }
+
+        position += 1;
+    }
+
+    if let Some((kind, start)) = current {
+        items.push(TopLevelItem { kind, range: start..bytes.len() });
+    }
+
+    items
+}
+
+// A part of a StyleSheet that can be parsed on its own, see split_chunks().
+#[derive(Debug, Clone, PartialEq)]
+pub struct Chunk {
+    pub range: Range<usize>,
+    // The number of lines in front of the chunk.
+    pub line: u32,
+}
+
+// The number of lines `bytes` contains, counted the same way as the
+// tokenizer does.
+fn count_lines(bytes: &[u8]) -> u32 {
+    let mut lines = 0;
+    for (index, byte) in bytes.iter().enumerate() {
+        match byte {
+            b'\n' | b'\x0c' => lines += 1,
+            b'\r' if bytes.get(index + 1) != Some(&b'\n') => lines += 1,
+            _ => {},
+        }
+    }
+    lines
+}
+
+// Returns the position after the last line break between `from` and `to`
+// that is not part of a comment. Only whitespace and comments are expected
+// between the two.
+fn line_start(bytes: &[u8], from: usize, to: usize) -> Option<usize> {
+    let mut result = None;
+    let mut position = from;
+    while position < to {
+        if is_comment_start(bytes, position) {
+            position = skip_comment(bytes, position);
+            continue;
+        }
+
+        match bytes[position] {
+            b'\n' | b'\x0c' => result = Some(position + 1),
+            b'\r' if bytes.get(position + 1) != Some(&b'\n') => result = Some(position + 1),
+            _ => {},
+        }
+        position += 1;
+    }
+    result
+}
+
+// Split `input` into chunks of top-level rules that can be parsed separately.
+//
+// The first chunk contains all @import and @property rules and everything in
+// front of them, as those affect how the rest of the input is parsed. It is
+// empty if there are none. It is followed by at most `count` chunks of at
+// least `min_size` bytes, unless the input is smaller than that.
+//
+// Chunks only start at the beginning of a line, so parsing a chunk reports
+// the same locations as parsing all of `input` given the line it starts at.
+// Input without line breaks between rules is therefore not split.
+pub fn split_chunks(input: &str, count: usize, min_size: usize) -> Vec<Chunk> {
+    let bytes = input.as_bytes();
+    let items = scan_top_level(input);
+
+    let independent = items.iter()
+        .rposition(|item| matches!(item.kind, ItemKind::Import | ItemKind::Property))
+        .map_or(0, |index| index + 1);
+
+    // The positions at which a chunk could start.
+    let starts: Vec<usize> = (independent..items.len()).filter_map(|index| {
+        if index == 0 {
+            Some(0)
+        } else {
+            line_start(bytes, items[index - 1].range.end, items[index].range.start)
+        }
+    }).collect();
+
+    let Some(first) = starts.first().copied() else {
+        return vec![Chunk { range: 0..bytes.len(), line: 0 }];
+    };
+
+    let size = ((bytes.len() - first) / count.max(1)).max(min_size);
+
+    let mut boundaries = vec![0, first];
+    for start in starts.into_iter().skip(1) {
+        if boundaries.len() > count {
+            break;
+        }
+
+        let chunk_start = *boundaries.last().unwrap();
+        if start - chunk_start >= size && bytes.len() - start >= min_size {
+            boundaries.push(start);
+        }
+    }
+    boundaries.push(bytes.len());
+
+    let mut line = 0;
+    boundaries.windows(2).map(|window| {
+        let chunk = Chunk { range: window[0]..window[1], line };
+        line += count_lines(&bytes[chunk.range.clone()]);
+        chunk
+    }).collect()
+}
+
+// Returns the targets of all top-level @import rules in `input`, in order.
+//
+// Only the @import rules found by scan_top_level() are tokenized. Invalid
+// @import rules are ignored here, the actual parse will report them.
+pub fn scan_imports(input: &str) -> Vec<String> {
+    let mut imports = Vec::new();
+
+    for item in scan_top_level(input) {
+        if item.kind != ItemKind::Import {
+            continue;
+        }
+
+        let mut parser_input = cssparser::ParserInput::new(&input[item.range]);
+        let mut parser = cssparser::Parser::new(&mut parser_input);
+        if !matches!(parser.next(), Ok(Token::AtKeyword(_))) {
+            continue;
+        }
+
+        if let Ok(url) = parser.expect_url_or_string() {
+            imports.push(url.to_string());
+        }
+    }
+
+    imports
+}
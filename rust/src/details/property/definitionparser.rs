@@ -1,10 +1,10 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 // SPDX-FileCopyrightText: 2025 Arjen Hiemstra <ahiemstra@heimr.nl>
 
-use crate::details::{parse_error, ParseError, ParseErrorKind, SourceLocation};
+use crate::details::{parse_error, source_file, ParseError, ParseErrorKind, SourceLocation};
 
 use super::syntax::{parse_syntax, ParsedPropertySyntax};
-use super::value::parse_values;
+use super::value::parse_values_matching;
 use super::function::property_function;
 
 use crate::property::PropertyDefinition;
@@ -33,7 +33,7 @@ impl<'i> cssparser::DeclarationParser<'i> for PropertyDefinitionParser {
     fn parse_value<'t>(&mut self, name: cssparser::CowRcStr<'i>, input: &mut cssparser::Parser<'i, 't>, _state: &cssparser::ParserState) -> Result<Self::Declaration, cssparser::ParseError<'i, Self::Error>> {
         match name.to_lowercase().as_str() {
             "syntax" => {
-                let location = SourceLocation::from_file_location(input.current_source_url().unwrap_or("").to_string(), input.current_source_location());
+                let location = SourceLocation::from_file_location(source_file(input), input.current_source_location());
 
                 let token = input.next()?.clone();
                 let syntax = match token {
@@ -66,9 +66,9 @@ impl<'i> cssparser::DeclarationParser<'i> for PropertyDefinitionParser {
 
                 let parsed = parse_syntax(&syntax, location);
                 if let Ok(syntax) = parsed {
-                    self.definition.syntax = syntax;
+                    self.definition.set_syntax(syntax);
                 } else {
-                    return parse_error(input, ParseErrorKind::InvalidPropertyDefinition, String::from("Expected string for property syntax"));
+                    return parse_error(input, ParseErrorKind::InvalidPropertyDefinition, "Expected string for property syntax");
                 }
             },
             "inherits" => {
@@ -77,11 +77,11 @@ impl<'i> cssparser::DeclarationParser<'i> for PropertyDefinitionParser {
                 match value_string.to_lowercase().as_str() {
                     "true" => self.definition.inherit = true,
                     "false" => self.definition.inherit = false,
-                    _ => return parse_error(input, ParseErrorKind::InvalidPropertyDefinition, String::from("Unexpected value for inherit")),
+                    _ => return parse_error(input, ParseErrorKind::InvalidPropertyDefinition, "Unexpected value for inherit"),
                 }
             },
             "initial-value" => {
-                let value_result = parse_values(&self.definition.syntax, input);
+                let value_result = parse_values_matching(self.definition.matcher(), input);
                 if let Ok(values) = value_result {
                     self.definition.initial = values.into();
                 } else {
@@ -92,11 +92,11 @@ impl<'i> cssparser::DeclarationParser<'i> for PropertyDefinitionParser {
         }
 
         if self.definition.name.is_empty() {
-            parse_error(input, ParseErrorKind::InvalidPropertyDefinition, String::from("'name' is required for property definitions"))
+            parse_error(input, ParseErrorKind::InvalidPropertyDefinition, "'name' is required for property definitions")
         } else if let ParsedPropertySyntax::Empty = self.definition.syntax {
-            parse_error(input, ParseErrorKind::InvalidPropertyDefinition, String::from("'syntax' is required for property definitions"))
+            parse_error(input, ParseErrorKind::InvalidPropertyDefinition, "'syntax' is required for property definitions")
         } else if !input.is_exhausted() {
-            parse_error(input, ParseErrorKind::InvalidPropertyDefinition, String::from("Unexpected trailing characters"))
+            parse_error(input, ParseErrorKind::InvalidPropertyDefinition, "Unexpected trailing characters")
         } else {
             Ok(())
         }
@@ -1,7 +1,7 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 // SPDX-FileCopyrightText: 2025 Arjen Hiemstra <ahiemstra@heimr.nl>
 
-use std::sync::{RwLock, OnceLock};
+use std::sync::{Arc, RwLock, OnceLock};
 use std::collections::hash_map::HashMap;
 
 use crate::property::property_definition;
@@ -9,8 +9,8 @@ use crate::value::{Value, ValueData, Color, ColorOperation, Dimension};
 
 use crate::details::{parse_error, ParseError, ParseErrorKind, SourceLocation};
 
-use super::syntax::{ParsedPropertySyntax, parse_syntax};
-use super::value::parse_values;
+use super::syntax::{ParsedPropertySyntax, SyntaxMatcher, parse_syntax};
+use super::value::{parse_values, parse_values_matching};
 
 pub type PropertyFunctionResult<'i> = Result<Vec<Value>, cssparser::ParseError<'i, ParseError>>;
 pub type PropertyFunction = for <'a, 'i, 't> fn(&'a mut cssparser::Parser<'i, 't>) -> PropertyFunctionResult<'i>;
@@ -50,14 +50,32 @@ pub fn add_property_function(name: &str, function: PropertyFunction) -> bool {
     true
 }
 
-// Helper function to parse function arguments based on a CSS property syntax
-fn parse_arguments<'i, 't>(syntax: &str, parser: &mut cssparser::Parser<'i, 't>) -> PropertyFunctionResult<'i> {
-    let syntax_result = parse_syntax(syntax, SourceLocation::from_file("inline"));
-    if let Err(error) = syntax_result {
-        return Err(parser.new_custom_error(error));
+// The compiled syntax for the arguments of a function. Functions are used for
+// many values, so each syntax is only compiled the first time it is used.
+fn argument_matcher(syntax: &'static str) -> Result<Arc<SyntaxMatcher>, ParseError> {
+    static MATCHERS: OnceLock<RwLock<HashMap<&'static str, Arc<SyntaxMatcher>>>> = OnceLock::new();
+    let matchers = MATCHERS.get_or_init(|| RwLock::new(HashMap::new()));
+
+    if let Ok(matchers) = matchers.read() {
+        if let Some(matcher) = matchers.get(syntax) {
+            return Ok(matcher.clone());
+        }
+    }
+
+    let matcher = Arc::new(SyntaxMatcher::new(&parse_syntax(syntax, SourceLocation::from_file("inline"))?));
+    if let Ok(mut matchers) = matchers.write() {
+        matchers.insert(syntax, matcher.clone());
     }
 
-    parse_values(syntax_result.as_ref().unwrap(), parser)
+    Ok(matcher)
+}
+
+// Helper function to parse function arguments based on a CSS property syntax
+fn parse_arguments<'i, 't>(syntax: &'static str, parser: &mut cssparser::Parser<'i, 't>) -> PropertyFunctionResult<'i> {
+    match argument_matcher(syntax) {
+        Ok(matcher) => parse_values_matching(&matcher, parser),
+        Err(error) => Err(parser.new_custom_error(error)),
+    }
 }
 
 // Parse `var(<custom-property-name>, <declaration-value>?)`
@@ -120,7 +138,7 @@ fn modify_color<'i, 't>(parser: &mut cssparser::Parser<'i, 't>) -> PropertyFunct
             };
             Color::modified(&color, ColorOperation::set(None, None, None, alpha))
         },
-        _ => return parse_error(parser, ParseErrorKind::Unknown, String::from("Unexpected modifiy-color argument")),
+        _ => return parse_error(parser, ParseErrorKind::Unknown, "Unexpected modifiy-color argument"),
     };
 
     Ok(vec![Value::from(result)])
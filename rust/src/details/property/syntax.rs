@@ -409,255 +409,407 @@ pub fn parse_syntax(input: &str, location: SourceLocation) -> Result<ParsedPrope
         Ok(syntax)
     } else {
         match result.err().unwrap() {
-            nom::Err::Incomplete(_) => Err(ParseError{ kind: ParseErrorKind::InvalidPropertySyntax, message: String::from("Incomplete input"), location}),
+            nom::Err::Incomplete(_) => Err(ParseError{ kind: ParseErrorKind::InvalidPropertySyntax, message: "Incomplete input".into(), location}),
             nom::Err::Error(error) | nom::Err::Failure(error) => {
                 let message = format!("Input {} encountered error: {}", error.0, error.1);
-                Err(ParseError{ kind: ParseErrorKind::InvalidPropertySyntax, message, location})
+                Err(ParseError{ kind: ParseErrorKind::InvalidPropertySyntax, message: message.into(), location})
             }
         }
     }
 }
 
-struct SyntaxValidateError(String);
+// Why values did not match a syntax. Most of these are discarded while the
+// options of a Choice are tried, so the message is only formatted by
+// validate_syntax() for the error that is reported.
+enum SyntaxValidateError<'a> {
+    DataType(&'a DataType, &'a Value),
+    ExpectedDataType,
+    UnexpectedKeyword(&'a Value),
+    ExpectedKeyword,
+    WrongList(&'static str),
+    TooFewValues(usize, &'a DataType),
+    TooManyValues(usize, &'a DataType),
+    UnexpectedEnd(&'a [SequenceItem]),
+    NoAlternative,
+}
 
-fn validate_datatype<'a>(datatype: &DataType, values: &'a [Value]) -> Result<&'a [Value], SyntaxValidateError> {
-    if let Some((value, remain)) = values.split_first() {
-        match datatype {
-            DataType::Length => {
-                if let ValueData::Dimension(dimension) = &value.data {
-                    if dimension.is_length() {
-                        return Ok(remain)
-                    }
-                }
-                Err(SyntaxValidateError(format!("Expected Length, got {}", value)))
-            },
-            DataType::Number => {
-                if let ValueData::Dimension(dimension) = &value.data {
-                    if dimension.is_number() {
-                        return Ok(remain)
-                    }
-                }
-                Err(SyntaxValidateError(format!("Expected Number, got {}", value)))
-            },
-            DataType::Percentage => {
-                if let ValueData::Dimension(dimension) = &value.data {
-                    if dimension.is_percent() {
-                        return Ok(remain)
-                    }
-                }
-                Err(SyntaxValidateError(format!("Expected Percentage, got {}", value)))
-            },
-            DataType::LengthPercentage => {
-                if let ValueData::Dimension(dimension) = &value.data {
-                    if dimension.is_length() || dimension.is_percent() {
-                        return Ok(remain)
-                    }
-                }
-                Err(SyntaxValidateError(format!("Expected Length or Percentage, got {}", value)))
-            },
-            DataType::String => {
-                if let ValueData::String(_) = value.data {
-                    Ok(remain)
-                } else {
-                    Err(SyntaxValidateError(format!("Expected String, got {}", value)))
-                }
-            },
-            DataType::Color => {
-                if let ValueData::Color(_) = value.data {
-                    Ok(remain)
-                } else {
-                    Err(SyntaxValidateError(format!("Expected Color, got {}", value)))
-                }
-            },
-            DataType::Angle => {
-                if let ValueData::Dimension(dimension) = &value.data {
-                    if dimension.is_angle() {
-                        return Ok(remain);
-                    }
-                }
-                Err(SyntaxValidateError(format!("Expected Angle, got {}", value)))
+impl std::fmt::Display for SyntaxValidateError<'_> {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            Self::DataType(datatype, value) => match datatype {
+                DataType::Length => write!(f, "Expected Length, got {}", value),
+                DataType::Number => write!(f, "Expected Number, got {}", value),
+                DataType::Percentage => write!(f, "Expected Percentage, got {}", value),
+                DataType::LengthPercentage => write!(f, "Expected Length or Percentage, got {}", value),
+                DataType::String => write!(f, "Expected String, got {}", value),
+                DataType::Color => write!(f, "Expected Color, got {}", value),
+                DataType::Angle => write!(f, "Expected Angle, got {}", value),
+                DataType::Integer => write!(f, "Expected Integer, got {}", value),
+                DataType::Url => write!(f, "Expected URL, got {}", value),
+                _ => write!(f, "Unhandled data type {:?}", datatype),
             },
-            DataType::Integer => {
-                if let ValueData::Integer(_) = &value.data {
-                    return Ok(remain);
-                }
-                Err(SyntaxValidateError(format!("Expected Integer, got {}", value)))
+            Self::ExpectedDataType => write!(f, "Expected a datatype"),
+            Self::UnexpectedKeyword(value) => match &value.data {
+                ValueData::String(data) => write!(f, "Unexpected keyword {}", data),
+                _ => write!(f, "{:?} is not a keyword", value),
             },
-            DataType::Url => {
-                if let ValueData::Url(_) = &value.data {
-                    return Ok(remain);
-                }
-                Err(SyntaxValidateError(format!("Expected URL, got {}", value)))
+            Self::ExpectedKeyword => write!(f, "Expected a keyword"),
+            Self::WrongList(message) => write!(f, "{}", message),
+            Self::TooFewValues(minimum, datatype) => write!(f, "Expected at least {} values of type {:?}", minimum, datatype),
+            Self::TooManyValues(maximum, datatype) => write!(f, "Expected at most {} values of type {:?}", maximum, datatype),
+            Self::UnexpectedEnd(items) => {
+                let expected: Vec<_> = items.iter().map(|item| item.text.as_str()).collect();
+                write!(f, "Unexpected end of input, expected: {}", expected.join(" "))
             },
-            _ => {
-                Err(SyntaxValidateError(format!("Unhandled data type {:?}", datatype)))
-            }
+            Self::NoAlternative => write!(f, "None of the alternatives matched"),
         }
-    } else {
-        Err(SyntaxValidateError(String::from("Expected a datatype")))
     }
 }
 
-fn validate_keyword<'a>(keyword: &String, values: &'a [Value]) -> Result<&'a [Value], SyntaxValidateError> {
-    if let Some((value, remain)) = values.split_first() {
-        if let ValueData::String(data) = &value.data {
-            if data == keyword {
-                Ok(remain)
-            } else {
-                Err(SyntaxValidateError(format!("Unexpected keyword {}", data)))
-            }
-        } else {
-            Err(SyntaxValidateError(format!("{:?} is not a keyword", value)))
-        }
-    } else {
-        Err(SyntaxValidateError(String::from("Expected a keyword")))
-    }
-}
+// Bitmasks for the kinds of values a data type accepts. A value can be more
+// than one kind, kinds() returns all of them.
+type ValueKinds = u16;
 
-fn validate_list<'a>(datatype: &DataType, values: &'a [Value], minimum: usize, maximum: usize) -> Result<&'a [Value], SyntaxValidateError> {
-    let mut count = 0;
-    let mut remain = values;
-    while !remain.is_empty() {
-        let result = validate_datatype(datatype, remain);
-        if let Ok(validate_remain) = result {
-            count += 1;
-            remain = validate_remain;
+const LENGTH: ValueKinds = 1 << 0;
+const NUMBER: ValueKinds = 1 << 1;
+const PERCENTAGE: ValueKinds = 1 << 2;
+const STRING: ValueKinds = 1 << 3;
+const COLOR: ValueKinds = 1 << 4;
+const URL: ValueKinds = 1 << 5;
+const INTEGER: ValueKinds = 1 << 6;
+const ANGLE: ValueKinds = 1 << 7;
 
-            if count == maximum {
-                break
+fn kinds(value: &Value) -> ValueKinds {
+    match &value.data {
+        ValueData::Dimension(dimension) => {
+            let mut result = 0;
+            if dimension.is_length() {
+                result |= LENGTH;
             }
-        } else {
-            return result;
-        }
+            if dimension.is_number() {
+                result |= NUMBER;
+            }
+            if dimension.is_percent() {
+                result |= PERCENTAGE;
+            }
+            if dimension.is_angle() {
+                result |= ANGLE;
+            }
+            result
+        },
+        ValueData::String(_) => STRING,
+        ValueData::Color(_) => COLOR,
+        ValueData::Url(_) => URL,
+        ValueData::Integer(_) => INTEGER,
+        _ => 0,
     }
+}
 
-    if count < minimum {
-        Err(SyntaxValidateError(format!("Expected at least {} values of type {:?}", minimum, datatype)))
-    } else if count > maximum {
-        Err(SyntaxValidateError(format!("Expected at most {} values of type {:?}", maximum, datatype)))
-    } else {
-        Ok(remain)
+// The kinds of values accepted by `datatype`. Data types that are not handled
+// accept nothing.
+fn accepted_kinds(datatype: &DataType) -> ValueKinds {
+    match datatype {
+        DataType::Length => LENGTH,
+        DataType::Number => NUMBER,
+        DataType::Percentage => PERCENTAGE,
+        DataType::LengthPercentage => LENGTH | PERCENTAGE,
+        DataType::String => STRING,
+        DataType::Color => COLOR,
+        DataType::Angle => ANGLE,
+        DataType::Integer => INTEGER,
+        DataType::Url => URL,
+        _ => 0,
     }
 }
 
-#[derive(Debug, PartialEq)]
+#[derive(Debug, PartialEq, Clone, Copy)]
 enum ListType {
     NotAList,
     SpaceSeparated,
     CommaSeparated,
 }
 
-fn validate_component<'a>(component: &SyntaxComponent, values: &'a [Value], list_type: &ListType) -> Result<&'a [Value], SyntaxValidateError> {
-    match component {
-        SyntaxComponent::DataType(datatype) => validate_datatype(datatype, values),
-        SyntaxComponent::Keyword(keyword) => validate_keyword(keyword, values),
-        SyntaxComponent::Comma => Ok(values),
-        SyntaxComponent::SpaceSeparatedList(datatype) => {
-            if list_type == &ListType::CommaSeparated {
-                return Err(SyntaxValidateError(format!("Expected space separated list, got comma separated")))
-            }
-
-            validate_list(datatype, values, 0, usize::max_value())
-        },
-        SyntaxComponent::CommaSeparatedList(datatype) => {
-            if list_type == &ListType::SpaceSeparated {
-                return Err(SyntaxValidateError(format!("Expected comma separated list, got space separated")))
-            }
+#[derive(Debug, PartialEq, Clone)]
+enum MatchNode {
+    DataType { datatype: DataType, accepts: ValueKinds },
+    Keyword(String),
+    Comma,
+    List {
+        datatype: DataType,
+        accepts: ValueKinds,
+        minimum: usize,
+        maximum: usize,
+        // The kind of list this does not match, with the error to report.
+        rejects: ListType,
+        rejected: &'static str,
+    },
+    // A range of `SyntaxMatcher::items` that should match one after the other.
+    Sequence { start: usize, end: usize },
+    // A range of `SyntaxMatcher::options` of which the first that matches is
+    // used.
+    Choice { start: usize, end: usize },
+}
 
-            validate_list(datatype, values, 0, usize::max_value())
-        },
-        SyntaxComponent::Repeat { data_type, minimum, maximum } => {
-            if list_type == &ListType::CommaSeparated {
-                return Err(SyntaxValidateError(format!("Expected space separated list, got comma separated")))
-            }
-            validate_list(data_type, values, *minimum, *maximum)
-        },
-    }
+#[derive(Debug, PartialEq, Clone)]
+struct SequenceItem {
+    node: usize,
+    // How this item was written in the syntax, for error messages.
+    text: String,
 }
 
-fn validate_group<'a>(group: &SyntaxGroup, values: &'a [Value], list_type: &ListType) -> Result<&'a [Value], SyntaxValidateError> {
-    match group {
-        SyntaxGroup::Component(component) => validate_component(component, values, list_type),
-        SyntaxGroup::Expression(expression) => validate_expression(expression, values, list_type),
+// The values an option of a Choice can start with. Options that cannot match
+// the first value are skipped without trying them.
+#[derive(Debug, PartialEq, Clone)]
+struct ChoiceOption {
+    node: usize,
+    accepts: ValueKinds,
+    // Set if the option can only start with this keyword.
+    keyword: Option<String>,
+    // Set if the option may match without consuming the first value, in which
+    // case it is always tried.
+    nullable: bool,
+}
+
+impl ChoiceOption {
+    fn may_match(&self, value: &Value) -> bool {
+        if self.nullable {
+            return true;
+        }
+
+        if let Some(keyword) = &self.keyword {
+            return matches!(&value.data, ValueData::String(string) if string == keyword);
+        }
+
+        kinds(value) & self.accepts != 0
     }
 }
 
-fn validate_alternatives<'a>(alternatives: &SyntaxAlternatives, values: &'a [Value], list_type: &ListType) -> Result<&'a [Value], SyntaxValidateError> {
-    match alternatives {
-        SyntaxAlternatives::Component(component) => validate_component(component, values, list_type),
-        SyntaxAlternatives::Group(group) => validate_group(group, values, list_type),
-        SyntaxAlternatives::Alternatives(alternatives) => {
-            for group in alternatives {
-                if let Ok(remain) = validate_group(group, values, list_type) {
-                    return Ok(remain);
-                }
-            }
-            Err(SyntaxValidateError(format!("None of the alternatives matched")))
+// A property syntax compiled into a flat list of nodes.
+//
+// Validating values against a ParsedPropertySyntax directly means walking the
+// syntax tree and trying every alternative in turn. The compiled form
+// stores the tree as indices into flat vectors and knows, for each
+// alternative, which values it could start with, so for most syntaxes only a
+// single alternative is tried for each value. Matching otherwise behaves
+// exactly like validating against the syntax tree, including the errors it
+// reports.
+//
+// Property definitions compile their syntax once when they are created.
+#[derive(Debug, Default, PartialEq, Clone)]
+pub struct SyntaxMatcher {
+    nodes: Vec<MatchNode>,
+    items: Vec<SequenceItem>,
+    options: Vec<ChoiceOption>,
+    // None for syntaxes that accept anything.
+    root: Option<usize>,
+}
+
+impl SyntaxMatcher {
+    pub fn new(syntax: &ParsedPropertySyntax) -> SyntaxMatcher {
+        let mut matcher = SyntaxMatcher::default();
+        if let ParsedPropertySyntax::Expression(expression) = syntax {
+            matcher.root = Some(matcher.compile_expression(expression));
         }
+        matcher
     }
-}
 
-fn validate_expression<'a>(expression: &[SyntaxAlternatives], values: &'a [Value], list_type: &ListType) -> Result<&'a [Value], SyntaxValidateError> {
-    let mut remaining_values = values;
-    let mut remaining_expression = expression;
+    fn push(&mut self, node: MatchNode) -> usize {
+        self.nodes.push(node);
+        self.nodes.len() - 1
+    }
 
-    while !remaining_values.is_empty() && !remaining_expression.is_empty() {
-        let alternative: &SyntaxAlternatives;
+    fn compile_expression(&mut self, expression: &[SyntaxAlternatives]) -> usize {
+        let items: Vec<_> = expression.iter().map(|alternatives| SequenceItem {
+            node: self.compile_alternatives(alternatives),
+            text: alternatives.to_string(),
+        }).collect();
 
-        if let Some((alt, remain)) = remaining_expression.split_first() {
-            alternative = alt;
-            remaining_expression = remain;
-        } else {
-            break;
+        let start = self.items.len();
+        self.items.extend(items);
+        self.push(MatchNode::Sequence { start, end: self.items.len() })
+    }
+
+    fn compile_alternatives(&mut self, alternatives: &SyntaxAlternatives) -> usize {
+        match alternatives {
+            SyntaxAlternatives::Component(component) => self.compile_component(component),
+            SyntaxAlternatives::Group(group) => self.compile_group(group),
+            SyntaxAlternatives::Alternatives(groups) => {
+                let options: Vec<_> = groups.iter().map(|group| {
+                    let node = self.compile_group(group);
+                    let (accepts, keyword, nullable) = self.first(node);
+                    ChoiceOption { node, accepts, keyword, nullable }
+                }).collect();
+
+                let start = self.options.len();
+                self.options.extend(options);
+                self.push(MatchNode::Choice { start, end: self.options.len() })
+            },
         }
+    }
 
-        let result = validate_alternatives(alternative, remaining_values, list_type);
-        if let Ok(remain) = result {
-            remaining_values = remain;
-        } else {
-            return result;
+    fn compile_group(&mut self, group: &SyntaxGroup) -> usize {
+        match group {
+            SyntaxGroup::Component(component) => self.compile_component(component),
+            SyntaxGroup::Expression(expression) => self.compile_expression(expression),
         }
     }
 
-    if remaining_expression.is_empty() {
-        Ok(remaining_values)
-    } else {
-        Err(SyntaxValidateError(format!("Unexpected end of input, expected: {}", expression_to_string(remaining_expression, " "))))
+    fn compile_component(&mut self, component: &SyntaxComponent) -> usize {
+        let list = |datatype: &DataType, minimum, maximum, rejects, rejected| MatchNode::List {
+            datatype: datatype.clone(),
+            accepts: accepted_kinds(datatype),
+            minimum,
+            maximum,
+            rejects,
+            rejected,
+        };
+
+        let node = match component {
+            SyntaxComponent::DataType(datatype) => MatchNode::DataType { datatype: datatype.clone(), accepts: accepted_kinds(datatype) },
+            SyntaxComponent::Keyword(keyword) => MatchNode::Keyword(keyword.clone()),
+            SyntaxComponent::Comma => MatchNode::Comma,
+            SyntaxComponent::SpaceSeparatedList(datatype) => {
+                list(datatype, 0, usize::MAX, ListType::CommaSeparated, "Expected space separated list, got comma separated")
+            },
+            SyntaxComponent::CommaSeparatedList(datatype) => {
+                list(datatype, 0, usize::MAX, ListType::SpaceSeparated, "Expected comma separated list, got space separated")
+            },
+            SyntaxComponent::Repeat { data_type, minimum, maximum } => {
+                list(data_type, *minimum, *maximum, ListType::CommaSeparated, "Expected space separated list, got comma separated")
+            },
+        };
+        self.push(node)
+    }
+
+    // The kinds of values `node` can start with, the keyword it must start
+    // with if there is one, and whether it may match without consuming the
+    // first value.
+    fn first(&self, node: usize) -> (ValueKinds, Option<String>, bool) {
+        match &self.nodes[node] {
+            MatchNode::DataType { accepts, .. } | MatchNode::List { accepts, .. } => (*accepts, None, false),
+            MatchNode::Keyword(keyword) => (STRING, Some(keyword.clone()), false),
+            MatchNode::Comma => (0, None, true),
+            MatchNode::Sequence { start, end } => {
+                let mut accepts = 0;
+                let mut keyword = None;
+                for (index, item) in self.items[*start..*end].iter().enumerate() {
+                    let (item_accepts, item_keyword, nullable) = self.first(item.node);
+                    if !nullable {
+                        // Only the first item can restrict the option to a
+                        // single keyword.
+                        if index == 0 {
+                            keyword = item_keyword;
+                        }
+                        return (accepts | item_accepts, keyword, false);
+                    }
+                    accepts |= item_accepts;
+                }
+                (accepts, None, true)
+            },
+            MatchNode::Choice { start, end } => {
+                let options = &self.options[*start..*end];
+                let accepts = options.iter().fold(0, |accepts, option| accepts | option.accepts);
+                let nullable = options.iter().any(|option| option.nullable);
+                (accepts, None, nullable)
+            },
+        }
     }
-}
 
-pub(super) fn validate_syntax(syntax: &ParsedPropertySyntax, values_result: &ParseValuesResult, location: SourceLocation) -> Result<(), ParseError> {
-    let expression = match syntax {
-        ParsedPropertySyntax::Empty | ParsedPropertySyntax::Universal => return Ok(()),
-        ParsedPropertySyntax::Expression(expression) => expression,
-    };
+    fn match_node<'a>(&'a self, node: usize, values: &'a [Value], list_type: ListType) -> Result<&'a [Value], SyntaxValidateError<'a>> {
+        match &self.nodes[node] {
+            MatchNode::DataType { datatype, accepts } => match values.split_first() {
+                Some((value, remain)) if kinds(value) & accepts != 0 => Ok(remain),
+                Some((value, _)) => Err(SyntaxValidateError::DataType(datatype, value)),
+                None => Err(SyntaxValidateError::ExpectedDataType),
+            },
+            MatchNode::Keyword(keyword) => match values.split_first() {
+                Some((value, remain)) => match &value.data {
+                    ValueData::String(data) if data == keyword => Ok(remain),
+                    _ => Err(SyntaxValidateError::UnexpectedKeyword(value)),
+                },
+                None => Err(SyntaxValidateError::ExpectedKeyword),
+            },
+            MatchNode::Comma => Ok(values),
+            MatchNode::List { datatype, accepts, minimum, maximum, rejects, rejected } => {
+                if list_type == *rejects {
+                    return Err(SyntaxValidateError::WrongList(*rejected));
+                }
 
-    let values: &[Value];
-    let list_type: ListType;
-    match values_result {
-        ParseValuesResult::Single(v) => {
-            values = v;
-            list_type = ListType::NotAList;
-        },
-        ParseValuesResult::SpaceSeparated(v) => {
-            values = v;
-            list_type = ListType::SpaceSeparated;
-        },
-        ParseValuesResult::CommaSeparated(v) => {
-            values = v;
-            list_type = ListType::CommaSeparated;
+                let mut count = 0;
+                let mut remain = values;
+                while let Some((value, rest)) = remain.split_first() {
+                    if kinds(value) & accepts == 0 {
+                        return Err(SyntaxValidateError::DataType(datatype, value));
+                    }
+
+                    count += 1;
+                    remain = rest;
+
+                    if count == *maximum {
+                        break;
+                    }
+                }
+
+                if count < *minimum {
+                    Err(SyntaxValidateError::TooFewValues(*minimum, datatype))
+                } else if count > *maximum {
+                    Err(SyntaxValidateError::TooManyValues(*maximum, datatype))
+                } else {
+                    Ok(remain)
+                }
+            },
+            MatchNode::Sequence { start, end } => {
+                let mut remain = values;
+                let mut index = *start;
+                while !remain.is_empty() && index < *end {
+                    remain = self.match_node(self.items[index].node, remain, list_type)?;
+                    index += 1;
+                }
+
+                if index == *end {
+                    Ok(remain)
+                } else {
+                    Err(SyntaxValidateError::UnexpectedEnd(&self.items[index..*end]))
+                }
+            },
+            MatchNode::Choice { start, end } => {
+                // Values are never empty here, a Sequence stops before that.
+                let first = values.first();
+                for option in &self.options[*start..*end] {
+                    if first.is_some_and(|value| !option.may_match(value)) {
+                        continue;
+                    }
+
+                    if let Ok(remain) = self.match_node(option.node, values, list_type) {
+                        return Ok(remain);
+                    }
+                }
+                Err(SyntaxValidateError::NoAlternative)
+            },
         }
     }
+}
+
+pub(crate) fn validate_syntax(matcher: &SyntaxMatcher, values_result: &ParseValuesResult, location: SourceLocation) -> Result<(), ParseError> {
+    let Some(root) = matcher.root else {
+        return Ok(());
+    };
+
+    let (values, list_type) = match values_result {
+        ParseValuesResult::Single(values) => (values, ListType::NotAList),
+        ParseValuesResult::SpaceSeparated(values) => (values, ListType::SpaceSeparated),
+        ParseValuesResult::CommaSeparated(values) => (values, ListType::CommaSeparated),
+    };
 
-    let result = validate_expression(expression, values, &list_type);
+    let result = matcher.match_node(root, values, list_type);
     if let Ok(remain) = result {
         if remain.is_empty() {
             Ok(())
         } else {
-            Err(ParseError{ kind: ParseErrorKind::PropertyValueDoesNotMatchSyntax, message: format!("Received too many values, remaining: {:?}", remain), location})
+            Err(ParseError{ kind: ParseErrorKind::PropertyValueDoesNotMatchSyntax, message: format!("Received too many values, remaining: {:?}", remain).into(), location})
         }
     } else {
         let error = result.unwrap_err();
-        Err(ParseError { kind: ParseErrorKind::PropertyValueDoesNotMatchSyntax, message: error.0, location })
+        Err(ParseError { kind: ParseErrorKind::PropertyValueDoesNotMatchSyntax, message: error.to_string().into(), location })
     }
 }
@@ -4,13 +4,14 @@
 use super::syntax::*;
 use super::function::*;
 
-use crate::details::unwrap_parse_error;
+use crate::details::{source_file, unwrap_parse_error};
+use crate::details::parsecontext::canonicalize_units;
 use crate::details::SourceLocation;
 use crate::details::{parse_error, ParseError, ParseErrorKind};
 use crate::value::{Color, Dimension, Value, Unit};
 
 #[derive(Debug, PartialEq)]
-pub(super) enum ParseValuesResult {
+pub(crate) enum ParseValuesResult {
     Single(Vec<Value>),
     SpaceSeparated(Vec<Value>),
     CommaSeparated(Vec<Value>),
@@ -32,6 +33,12 @@ fn parse_dimension<'i, 't>(parser: &mut cssparser::Parser<'i, 't>) -> ParseValue
     let token = parser.next()?.clone();
     match token {
         cssparser::Token::Dimension{has_sign: _, value, int_value: _, unit: unit_string} => {
+            if canonicalize_units() {
+                if let Some(dimension) = Dimension::canonical(value, &unit_string) {
+                    return Ok(Value::from(dimension));
+                }
+            }
+
             let unit = Unit::parse(unit_string.to_string().as_str());
             match unit {
                 Unit::Unknown | Unit::Unsupported => {
@@ -45,7 +52,7 @@ fn parse_dimension<'i, 't>(parser: &mut cssparser::Parser<'i, 't>) -> ParseValue
         cssparser::Token::Percentage { has_sign: _, unit_value, int_value: _ } => {
             return Ok(Value::from(Dimension{value: unit_value, unit: Unit::Percent}))
         },
-        _ => parse_error(parser, ParseErrorKind::InvalidPropertyValue, String::from("Expected a dimension"))
+        _ => parse_error(parser, ParseErrorKind::InvalidPropertyValue, "Expected a dimension")
     }
 }
 
@@ -67,7 +74,7 @@ fn parse_color<'i, 't>(parser: &mut cssparser::Parser<'i, 't>) -> ParseValueComp
         }
     }
 
-    parse_error(parser, ParseErrorKind::InvalidPropertyValue, format!("Input could not be parsed as color"))
+    parse_error(parser, ParseErrorKind::InvalidPropertyValue, "Input could not be parsed as color")
 }
 
 fn parse_number<'i, 't>(parser: &mut cssparser::Parser<'i, 't>) -> ParseValueComponentResult<'i> {
@@ -89,8 +96,10 @@ fn parse_string<'i, 't>(parser: &mut cssparser::Parser<'i, 't>) -> ParseValueCom
         cssparser::Token::QuotedString(value) => {
             return Ok(Value::from(value.as_ref()))
         }
+        // This is one of the alternatives tried by parse_value_component(),
+        // which discards the error, so the token is not formatted.
         _ => {
-            parse_error(parser, ParseErrorKind::InvalidPropertyValue, format!("Unexpected token {:?}", token))
+            parse_error(parser, ParseErrorKind::InvalidPropertyValue, "Expected an identifier or a string")
         }
     }
 }
@@ -140,10 +149,16 @@ fn parse_value_component<'i, 't>(parser: &mut cssparser::Parser<'i, 't>) -> Resu
         return function_result;
     }
 
-    parse_error(parser, ParseErrorKind::InvalidPropertyValue, String::from("Could not parse input"))
+    parse_error(parser, ParseErrorKind::InvalidPropertyValue, "Could not parse input")
 }
 
 pub fn parse_values<'i, 't>(syntax: &ParsedPropertySyntax, parser: &mut cssparser::Parser<'i, 't>) -> Result<Vec<Value>, cssparser::ParseError<'i, ParseError>> {
+    parse_values_matching(&SyntaxMatcher::new(syntax), parser)
+}
+
+// Like parse_values() but validates against a syntax that was compiled
+// before, see PropertyDefinition::matcher().
+pub fn parse_values_matching<'i, 't>(matcher: &SyntaxMatcher, parser: &mut cssparser::Parser<'i, 't>) -> Result<Vec<Value>, cssparser::ParseError<'i, ParseError>> {
     let result = parser.parse_until_before(cssparser::Delimiter::Bang, |parser| {
         let mut values: Vec<Value> = Vec::new();
         let mut comma_separated = false;
@@ -171,7 +186,7 @@ pub fn parse_values<'i, 't>(syntax: &ParsedPropertySyntax, parser: &mut cssparse
     });
 
     if let Ok(values) = result {
-        let validation_result = validate_syntax(syntax, &values, SourceLocation::from_file_location(parser.current_source_url().unwrap_or("").to_string(), parser.current_source_location()));
+        let validation_result = validate_syntax(matcher, &values, SourceLocation::from_file_location(source_file(parser), parser.current_source_location()));
         if let Ok(_) = validation_result {
             Ok(values.into())
         } else {
@@ -7,14 +7,17 @@ use std::sync::Arc;
 
 use cssparser::{CowRcStr, RuleBodyParser};
 
+use crate::atom::Atom;
 use crate::property::{add_property_definition, property_definition, Property, PropertyDefinition};
 use crate::selector::Selector;
+use crate::statistics::Phase;
 
 use super::{parse_error, ParseError, ParseErrorKind};
+use super::parsecontext::{count, enter_block, timed};
 use super::selectorparser::{SelectorParser, ParseRelative};
 use super::property::syntax::ParsedPropertySyntax;
 use super::property::definitionparser::parse_property_definition;
-use super::property::value::parse_values;
+use super::property::value::{parse_values, parse_values_matching};
 
 #[derive(Debug)]
 pub struct ParsedRule {
@@ -49,9 +52,12 @@ impl<'i, const TOP_LEVEL: bool> cssparser::QualifiedRuleParser<'i> for RulesPars
     fn parse_prelude<'t>(&mut self, parser: &mut cssparser::Parser<'i, 't>) -> Result<Self::Prelude, cssparser::ParseError<'i, Self::Error>> {
         let selector_parser = SelectorParser{};
         let relative = if TOP_LEVEL { ParseRelative::No } else { ParseRelative::Nested };
-        let result = selector_parser.parse(parser, relative);
+        let result = timed(Phase::Selectors, || selector_parser.parse(parser, relative));
         match result {
-            Ok(selectors) => Ok(selectors),
+            Ok(selectors) => {
+                count(|statistics| statistics.selector_parts += selectors.iter().map(|selector| selector.parts.len()).sum::<usize>());
+                Ok(selectors)
+            },
             Err(error) => {
                 if let cssparser::ParseErrorKind::Custom(error) = error.kind {
                     parse_error(parser, ParseErrorKind::InvalidSelectors, format!("Invalid Selectors: {}", error.message))
@@ -68,6 +74,11 @@ impl<'i, const TOP_LEVEL: bool> cssparser::QualifiedRuleParser<'i> for RulesPars
         _location: &cssparser::ParserState,
         parser: &mut cssparser::Parser<'i, 't>) -> Result<Self::QualifiedRule, cssparser::ParseError<'i, Self::Error>>
     {
+        let _block = match enter_block() {
+            Ok(block) => block,
+            Err(maximum) => return parse_error(parser, ParseErrorKind::LimitExceeded, format!("Rules are nested more than {} levels deep", maximum)),
+        };
+
         let mut nested_parser = NestedParser{};
         let mut body_parser = RuleBodyParser::<NestedParser, Self::QualifiedRule, Self::Error>::new(parser, &mut nested_parser);
 
@@ -81,7 +92,7 @@ impl<'i, const TOP_LEVEL: bool> cssparser::QualifiedRuleParser<'i> for RulesPars
                     ParseResult::PropertyDefinition(definition) => {
                         add_property_definition(&Arc::new(definition));
                     },
-                    ParseResult::Import(_) => return parse_error(parser, ParseErrorKind::UnsupportedAtRule, String::from("@import can only be used at top level")),
+                    ParseResult::Import(_) => return parse_error(parser, ParseErrorKind::UnsupportedAtRule, "@import can only be used at top level"),
                 }
             } else {
                 return Err(entry.unwrap_err().0)
@@ -160,7 +171,12 @@ impl<'i, const TOP_LEVEL: bool> cssparser::DeclarationParser<'i> for RulesParser
     type Error = ParseError;
 
     fn parse_value<'t>(&mut self, name: CowRcStr<'i>, input: &mut cssparser::Parser<'i, 't>, _state: &cssparser::ParserState) -> Result<Self::Declaration, cssparser::ParseError<'i, Self::Error>> {
-        let definition = property_definition(name.to_string().as_str());
+        let definition = property_definition(&name);
+        count(|statistics| {
+            statistics.registry_lookups += 1;
+            statistics.registry_hits += definition.is_some() as usize;
+        });
+
         if definition.is_none() {
             if !name.starts_with("--") {
                 return parse_error(input, ParseErrorKind::UnknownProperty, format!("No definition for property {}", name));
@@ -169,12 +185,7 @@ impl<'i, const TOP_LEVEL: bool> cssparser::DeclarationParser<'i> for RulesParser
             let values_result = parse_values(&ParsedPropertySyntax::Universal, input);
             match values_result {
                 Ok(values) => {
-                    return Ok(ParseResult::PropertyDefinition(PropertyDefinition {
-                        name: name.to_string(),
-                        syntax: ParsedPropertySyntax::Universal,
-                        inherit: false,
-                        initial: values,
-                    }));
+                    return Ok(ParseResult::PropertyDefinition(PropertyDefinition::new(name.to_string(), ParsedPropertySyntax::Universal, false, values)));
                 }
                 Err(error) => {
                     return parse_error(input, ParseErrorKind::InvalidPropertyValue, format!("Parsing values for property {} failed: {}", name, error));
@@ -183,11 +194,12 @@ impl<'i, const TOP_LEVEL: bool> cssparser::DeclarationParser<'i> for RulesParser
         }
 
         let pd = definition.unwrap();
-        let values_result = parse_values(&pd.syntax, input);
+        let values_result = timed(Phase::Values, || parse_values_matching(pd.matcher(), input));
         match values_result {
             Ok(values) => {
+                count(|statistics| statistics.declarations += 1);
                 Ok(ParseResult::Property(Property {
-                    name: name.to_string(),
+                    name: Atom::from(name.as_ref()),
                     definition: pd,
                     values,
                 }))
@@ -2,11 +2,11 @@
 // SPDX-FileCopyrightText: 2025 Arjen Hiemstra <ahiemstra@heimr.nl>
 
 use crate::parseerror::ParseError;
-use crate::selector::{AttributeOperator, Selector, SelectorKind, SelectorPart, SelectorValue};
+use crate::selector::{AttributeOperator, Selector, SelectorKind, SelectorPart};
 use crate::value::Value;
 
-use crate::details::parse_error_from_cssparser_error;
-use crate::details::identifier::Identifier;
+use crate::details::{parse_error_from_cssparser_error, source_file};
+use crate::details::identifier::{AttributeValue, Identifier};
 
 use selectors::SelectorList;
 
@@ -62,7 +62,7 @@ impl ::selectors::SelectorImpl for SelectorImpl {
     type NonTSPseudoClass = PseudoClass;
 
     type Identifier = Identifier;
-    type AttrValue = Identifier;
+    type AttrValue = AttributeValue;
     type LocalName = Identifier;
     type NamespacePrefix = Identifier;
     type NamespaceUrl = Identifier;
@@ -89,7 +89,7 @@ impl SelectorParser {
         let result = SelectorList::parse(self, parser, relative_selectors);
 
         if let Err(error) = result {
-            return Err(parser.new_custom_error(parse_error_from_cssparser_error(&error, parser.current_source_url().unwrap_or("").to_string())))
+            return Err(parser.new_custom_error(parse_error_from_cssparser_error(&error, source_file(parser))))
         }
 
         let mut selectors = Vec::new();
@@ -113,14 +113,7 @@ impl SelectorParser {
                     selectors::parser::Component::ExplicitUniversalType => parts.insert(0, SelectorPart::new_with_empty(SelectorKind::AnyElement)),
 
                     selectors::parser::Component::AttributeInNoNamespaceExists { local_name, local_name_lower: _ } => {
-                        parts.insert(0, SelectorPart {
-                            kind: SelectorKind::Attribute,
-                            value: SelectorValue::Attribute {
-                                name: local_name.to_string(),
-                                operator: AttributeOperator::Exists,
-                                value: Value::empty(),
-                            }
-                        })
+                        parts.insert(0, SelectorPart::new_with_attribute(local_name.to_string(), AttributeOperator::Exists, Value::empty()))
                     }
 
                     selectors::parser::Component::AttributeInNoNamespace { local_name, operator, value, case_sensitivity: _ } => {
@@ -132,14 +125,7 @@ impl SelectorParser {
                             selectors::attr::AttrSelectorOperator::Substring => AttributeOperator::Substring,
                             selectors::attr::AttrSelectorOperator::DashMatch => AttributeOperator::DashMatch,
                         };
-                        parts.insert(0, SelectorPart {
-                            kind: SelectorKind::Attribute,
-                            value: SelectorValue::Attribute {
-                                name: local_name.to_string(),
-                                operator: attribute_operator,
-                                value: Value::from(value),
-                            }
-                        });
+                        parts.insert(0, SelectorPart::new_with_attribute(local_name.to_string(), attribute_operator, Value::from(value.as_str())));
                     },
 
                     selectors::parser::Component::Combinator(combinator) => {
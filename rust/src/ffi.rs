@@ -1,15 +1,18 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 // SPDX-FileCopyrightText: 2025 Arjen Hiemstra <ahiemstra@heimr.nl>
 
-use std::path::PathBuf;
+use std::path::{Path, PathBuf};
 
 use ffi::ValueConversionError;
 
+use crate::atom::Atom;
+use crate::fragment::{FragmentBatch, FragmentParser};
 use crate::selector::{Selector, SelectorPart, SelectorKind, SelectorValue};
-use crate::parseerror::ParseError;
-use crate::property::Property;
+use crate::parseerror::{ParseError, ParseErrorKind, SourceLocation};
+use crate::property::{Property, PropertyRegistry};
+use crate::stylematcher::{Element, StyleMatcher};
 use crate::stylerule::StyleRule;
-use crate::stylesheet::StyleSheet;
+use crate::stylesheet::{Cancellation, Checkpoint, ParseOptions, ReloadedRules, StyleSheet};
 use crate::value;
 
 use crate::value::Value;
@@ -126,6 +129,19 @@ mod ffi {
         message: String,
     }
 
+    pub struct MatchAttribute {
+        name: String,
+        value: String,
+    }
+
+    pub struct MatchElement {
+        type_name: String,
+        id: String,
+        classes: Vec<String>,
+        pseudo_classes: Vec<String>,
+        attributes: Vec<MatchAttribute>,
+    }
+
     pub struct StyleSheetError {
         file: String,
         line: u32,
@@ -133,6 +149,69 @@ mod ffi {
         message: String,
     }
 
+    #[derive(Debug, Clone, Copy)]
+    pub struct Specificity {
+        ids: u32,
+        classes: u32,
+        types: u32,
+    }
+
+    pub struct ReloadedRules {
+        start: usize,
+        removed: usize,
+        added: usize,
+    }
+
+    pub enum FragmentKind {
+        Rules,
+        Declarations,
+    }
+
+    // The ranges of the lists of a FragmentBatch that belong to a single
+    // fragment.
+    pub struct FragmentRanges {
+        rules_start: usize,
+        rules_end: usize,
+        properties_start: usize,
+        properties_end: usize,
+        errors_start: usize,
+        errors_end: usize,
+    }
+
+    // Times are in nanoseconds.
+    pub struct FileStatistics {
+        path: String,
+        bytes: usize,
+        read: u64,
+        parse: u64,
+        selectors: u64,
+        values: u64,
+        flatten: u64,
+        rules: usize,
+        declarations: usize,
+        selector_parts: usize,
+        registry_lookups: usize,
+        registry_hits: usize,
+    }
+
+    // Limits are usize::MAX if unlimited.
+    pub struct ParseOptions {
+        max_errors: usize,
+        max_rules: usize,
+        max_nesting_depth: usize,
+        max_input_size: usize,
+        stop_at_first_error: bool,
+        canonicalize_units: bool,
+    }
+
+    unsafe extern "C++" {
+        include!("RuleVisitorAdapter.h");
+
+        #[namespace = "cssparser"]
+        type RuleVisitorAdapter;
+        fn visit_rule(self: &RuleVisitorAdapter, rule: &StyleRule) -> Result<()>;
+    }
+
     extern "Rust" {
         fn to_string(self: &Dimension) -> String;
 
@@ -149,6 +228,9 @@ mod ffi {
         fn to_rgba(self: &Color) -> Result<Rgba>;
         fn to_custom(self: &Color) -> Result<CustomColor>;
         fn to_modified(self: &Color) -> Result<ModifiedColor>;
+        fn resolve_rgba(self: &Color, rgba: &mut Rgba) -> bool;
+
+        fn apply_color_operation(color: Rgba, operation: ColorOperationType, other: Rgba, amount: f32, set: SetColorOperationValues) -> Rgba;
 
         type Value;
         fn value_type(self: &Value) -> ValueType;
@@ -158,34 +240,110 @@ mod ffi {
         fn to_image(self: &Value) -> Result<&str>;
         fn to_url(self: &Value) -> Result<&str>;
         fn to_integer(self: &Value) -> Result<i32>;
+        fn as_str(self: &Value) -> &str;
 
         type SelectorPart;
         fn kind(self: &SelectorPart) -> SelectorKind;
         fn value(self: &SelectorPart) -> &Value;
         fn attribute_name(self: &SelectorPart) -> String;
+        fn attribute_name_str(self: &SelectorPart) -> &str;
         fn attribute_operator(self: &SelectorPart) -> AttributeOperator;
         fn attribute_value(self: &SelectorPart) -> &Value;
+        fn value_atom(self: &SelectorPart) -> u32;
 
         type Selector;
         fn parts(self: &Selector) -> Vec<SelectorPart>;
+        fn part_count(self: &Selector) -> usize;
+        fn part_at(self: &Selector, index: usize) -> &SelectorPart;
 
         type Property;
         fn name(self: &Property) -> String;
+        fn name_str(self: &Property) -> &str;
+        fn name_atom(self: &Property) -> u32;
         fn values(self: &Property) -> Vec<Value>;
+        fn value_count(self: &Property) -> usize;
+        fn value_at(self: &Property, index: usize) -> &Value;
 
         type StyleRule;
         fn selector(self: &StyleRule) -> &Selector;
         fn properties(self: &StyleRule) -> Vec<Property>;
+        fn block_id(self: &StyleRule) -> u64;
+        fn property_count(self: &StyleRule) -> usize;
+        fn property_at(self: &StyleRule, index: usize) -> &Property;
+        fn specificity(self: &StyleRule) -> Specificity;
+        fn source_order(self: &StyleRule) -> usize;
 
         type StyleSheet;
         fn rules(self: &StyleSheet) -> Vec<StyleRule>;
+        fn rule_count(self: &StyleSheet) -> usize;
+        fn rule_at(self: &StyleSheet, index: usize) -> &StyleRule;
+        fn visit_rules_from(self: &StyleSheet, start: usize, visitor: &RuleVisitorAdapter) -> Result<()>;
+        fn cascade_order(self: &StyleSheet) -> Vec<usize>;
         fn errors(self: &StyleSheet) -> Vec<StyleSheetError>;
         fn paths(self: &StyleSheet) -> Vec<String>;
+        fn current_checkpoint(self: &StyleSheet) -> usize;
+        fn errors_since_checkpoint(self: &StyleSheet, checkpoint: usize) -> Vec<StyleSheetError>;
+        fn errors_between_checkpoints(self: &StyleSheet, start: usize, end: usize) -> Vec<StyleSheetError>;
+        fn error_count_since_checkpoint(self: &StyleSheet, checkpoint: usize) -> usize;
         fn parse(self: &mut StyleSheet) -> Result<()>;
         fn parse_string(self: &mut StyleSheet, data: &str) -> Result<()>;
         fn import_file(self: &mut StyleSheet, path: &str) -> Result<()>;
+        fn parse_with_cache(self: &mut StyleSheet, cache_dir: &str) -> Result<()>;
+        fn set_parallel_imports(self: &mut StyleSheet, enabled: bool);
+        fn set_parse_threads(self: &mut StyleSheet, threads: usize);
+        fn set_options(self: &mut StyleSheet, options: ParseOptions);
+        fn set_cancellation(self: &mut StyleSheet, cancellation: &Cancellation);
+        fn create_empty_copy(self: &StyleSheet) -> Box<StyleSheet>;
+        fn append_sheet(self: &mut StyleSheet, other: Box<StyleSheet>);
+        fn set_collect_statistics(self: &mut StyleSheet, enabled: bool);
+        fn file_statistics(self: &StyleSheet) -> Vec<FileStatistics>;
+        fn modified_paths(self: &StyleSheet) -> Vec<String>;
+        fn reload_file(self: &mut StyleSheet, path: &str) -> Result<Vec<ReloadedRules>>;
+        fn reload_modified_files(self: &mut StyleSheet) -> Result<Vec<ReloadedRules>>;
+        fn parse_visit(self: &mut StyleSheet, visitor: &RuleVisitorAdapter) -> Result<()>;
+        fn parse_string_visit(self: &mut StyleSheet, data: &str, visitor: &RuleVisitorAdapter) -> Result<()>;
+        fn custom_colors(self: &StyleSheet) -> Vec<CustomColor>;
+
+        type Cancellation;
+        fn cancel(self: &Cancellation);
+        fn is_cancelled(self: &Cancellation) -> bool;
+
+        fn create_cancellation() -> Box<Cancellation>;
 
         fn create_stylesheet(path: &str) -> Box<StyleSheet>;
+        fn create_stylesheet_with_registry(path: &str, registry: &PropertyRegistry) -> Box<StyleSheet>;
+
+        type FragmentParser;
+        fn set_origin(self: &mut FragmentParser, path: &str);
+        fn parse_fragments(self: &FragmentParser, data: &[u8], ends: &[usize]) -> Box<FragmentBatch>;
+
+        fn create_fragment_parser(kind: FragmentKind, registry: &PropertyRegistry) -> Box<FragmentParser>;
+
+        type FragmentBatch;
+        fn fragment_count(self: &FragmentBatch) -> usize;
+        fn fragment_ranges(self: &FragmentBatch, index: usize) -> FragmentRanges;
+        fn rule_at(self: &FragmentBatch, index: usize) -> &StyleRule;
+        fn property_at(self: &FragmentBatch, index: usize) -> &Property;
+        fn all_errors(self: &FragmentBatch) -> Vec<StyleSheetError>;
+
+        type StyleMatcher;
+        fn rule_count(self: &StyleMatcher) -> usize;
+        fn match_elements(self: &StyleMatcher, elements: &[MatchElement]) -> Vec<usize>;
+
+        fn create_style_matcher(stylesheet: &StyleSheet) -> Box<StyleMatcher>;
+
+        fn intern_atom(name: &str) -> u32;
+        fn lookup_atom(name: &str, id: &mut u32) -> bool;
+        fn atom_str(id: u32) -> &'static str;
+
+        type PropertyRegistry;
+        fn contains(self: &PropertyRegistry, name: &str) -> bool;
+        fn is_same(self: &PropertyRegistry, other: &PropertyRegistry) -> bool;
+
+        fn create_property_registry() -> Box<PropertyRegistry>;
+        fn create_property_registry_with_parent(parent: &PropertyRegistry) -> Box<PropertyRegistry>;
+        fn global_property_registry() -> Box<PropertyRegistry>;
+        fn clone_property_registry(registry: &PropertyRegistry) -> Box<PropertyRegistry>;
     }
 }
 
@@ -322,17 +480,67 @@ impl ffi::ModifiedColor {
     }
 }
 
+// Apply a single color operation to `color`. This allows C++ to evaluate
+// modified colors that depend on custom colors once those are known, using
+// the same evaluation as ColorResolver.
+fn apply_color_operation(color: ffi::Rgba, operation: ffi::ColorOperationType, other: ffi::Rgba, amount: f32, set: ffi::SetColorOperationValues) -> ffi::Rgba {
+    let other = Box::new(Color::rgba(other.r, other.g, other.b, other.a));
+    let channel = |value: i16| u8::try_from(value).ok();
+    let operation = match operation {
+        ffi::ColorOperationType::Set => ColorOperation::set(channel(set.r), channel(set.g), channel(set.b), channel(set.a)),
+        ffi::ColorOperationType::Add => ColorOperation::Add { other },
+        ffi::ColorOperationType::Subtract => ColorOperation::Subtract { other },
+        ffi::ColorOperationType::Multiply => ColorOperation::Multiply { other },
+        ffi::ColorOperationType::Mix => ColorOperation::Mix { other, amount },
+        _ => return color,
+    };
+
+    match value::apply_operation((color.r, color.g, color.b, color.a), &operation).and_then(|result| result.as_rgba()) {
+        Some((r, g, b, a)) => ffi::Rgba { r, g, b, a },
+        None => color,
+    }
+}
+
+impl From<ReloadedRules> for ffi::ReloadedRules {
+    fn from(value: ReloadedRules) -> Self {
+        ffi::ReloadedRules { start: value.start, removed: value.removed, added: value.added }
+    }
+}
+
+impl From<ffi::ParseOptions> for ParseOptions {
+    fn from(value: ffi::ParseOptions) -> Self {
+        let limit = |value: usize| if value == usize::MAX { None } else { Some(value) };
+        ParseOptions {
+            max_errors: limit(value.max_errors),
+            max_rules: limit(value.max_rules),
+            max_nesting_depth: limit(value.max_nesting_depth),
+            max_input_size: limit(value.max_input_size),
+            stop_at_first_error: value.stop_at_first_error,
+            cancellation: None,
+            collect_statistics: false,
+            canonicalize_units: value.canonicalize_units,
+        }
+    }
+}
+
 impl ffi::StyleSheetError {
     fn from_parse_error(error: &ParseError) -> ffi::StyleSheetError {
         ffi::StyleSheetError{
             file: error.location.file.clone(),
             line: error.location.line,
             column: error.location.column,
-            message: error.message.clone(),
+            message: error.message.to_string(),
         }
     }
 }
 
+// The number of modified colors the resolver shared by resolve_rgba() keeps
+// before it starts over. It lives as long as the thread, so without a limit
+// it would keep every color that was ever converted on that thread. A theme
+// has far fewer distinct modified colors than this, so converting one never
+// loses the memoized results.
+const MAX_SHARED_RESOLVED_COLORS: usize = 4096;
+
 impl value::Color {
     fn color_type(&self) -> ffi::ColorType {
         self.data.clone().into()
@@ -370,6 +578,31 @@ impl value::Color {
             Err(ValueConversionError{ message: String::from("Not a Modified color") })
         }
     }
+
+    // Evaluate this color and store the result in `rgba`. Returns false if
+    // the color does not evaluate to an RGBA color.
+    fn resolve_rgba(&self, rgba: &mut ffi::Rgba) -> bool {
+        // Converting a StyleSheet converts each color separately, sharing
+        // the resolver between them means colors that are derived from the
+        // same colors are only evaluated once.
+        thread_local! {
+            static RESOLVER: std::cell::RefCell<value::ColorResolver> = std::cell::RefCell::new(value::ColorResolver::new());
+        }
+
+        let resolved = RESOLVER.with_borrow_mut(|resolver| {
+            if resolver.len() > MAX_SHARED_RESOLVED_COLORS {
+                resolver.clear();
+            }
+            resolver.resolve(self)
+        });
+
+        let Some((r, g, b, a)) = resolved.as_rgba() else {
+            return false;
+        };
+
+        *rgba = ffi::Rgba { r, g, b, a };
+        true
+    }
 }
 
 impl value::Value {
@@ -412,6 +645,17 @@ impl value::Value {
             Err(ffi::ValueConversionError{ message: String::from("Not a URL") })
         }
     }
+
+    // Borrowed version of the string contents of String, Image and Url
+    // values. Returns an empty string for other types.
+    fn as_str(&self) -> &str {
+        match &self.data {
+            value::ValueData::String(string) => string.as_str(),
+            value::ValueData::Image(image) => image.as_str(),
+            value::ValueData::Url(url) => url.as_str(),
+            _ => "",
+        }
+    }
 }
 
 impl SelectorPart {
@@ -435,6 +679,14 @@ impl SelectorPart {
         }
     }
 
+    fn attribute_name_str(&self) -> &str {
+        if let SelectorValue::Attribute { name, operator: _, value: _ } = &self.value {
+            name.as_str()
+        } else {
+            ""
+        }
+    }
+
     fn attribute_operator(&self) -> ffi::AttributeOperator {
         if let SelectorValue::Attribute { name: _, operator, value: _ } = self.value {
             ffi::AttributeOperator::from(operator)
@@ -450,22 +702,52 @@ impl SelectorPart {
             Value::empty_ref()
         }
     }
+
+    // The interned name for type, class, id and pseudo-class parts. Returns
+    // the empty atom for other parts.
+    fn value_atom(&self) -> u32 {
+        self.atom().id()
+    }
 }
 
 impl Selector {
     fn parts(&self) -> Vec<SelectorPart> {
         self.parts.clone()
     }
+
+    fn part_count(&self) -> usize {
+        self.parts.len()
+    }
+
+    fn part_at(&self, index: usize) -> &SelectorPart {
+        &self.parts[index]
+    }
 }
 
 impl Property {
     fn name(&self) -> String {
-        self.name.clone()
+        self.name.to_string()
+    }
+
+    fn name_str(&self) -> &str {
+        self.name.as_str()
+    }
+
+    fn name_atom(&self) -> u32 {
+        self.name.id()
     }
 
     fn values(&self) -> Vec<value::Value> {
         self.values.clone()
     }
+
+    fn value_count(&self) -> usize {
+        self.values.len()
+    }
+
+    fn value_at(&self, index: usize) -> &value::Value {
+        &self.values[index]
+    }
 }
 
 impl StyleRule {
@@ -474,7 +756,31 @@ impl StyleRule {
     }
 
     fn properties(&self) -> Vec<Property> {
-        self.properties.clone()
+        self.properties.to_vec()
+    }
+
+    fn block_id(&self) -> u64 {
+        self.properties.id()
+    }
+
+    fn property_count(&self) -> usize {
+        self.properties.len()
+    }
+
+    fn property_at(&self, index: usize) -> &Property {
+        &self.properties[index]
+    }
+
+    fn specificity(&self) -> ffi::Specificity {
+        ffi::Specificity {
+            ids: self.specificity.ids,
+            classes: self.specificity.classes,
+            types: self.specificity.types,
+        }
+    }
+
+    fn source_order(&self) -> usize {
+        self.source_order
     }
 }
 
@@ -483,6 +789,19 @@ impl StyleSheet {
         self.all_rules()
     }
 
+    fn rule_at(&self, index: usize) -> &StyleRule {
+        self.rule(index).expect("Rule index out of range")
+    }
+
+    // Pass the rules from position `start` on to `visitor`, for converting a
+    // range of rules without looking up every one of them with rule_at().
+    fn visit_rules_from(&self, start: usize, visitor: &ffi::RuleVisitorAdapter) -> Result<(), cxx::Exception> {
+        for rule in self.rules_from(start) {
+            visitor.visit_rule(rule)?;
+        }
+        Ok(())
+    }
+
     fn errors(&self) -> Vec<ffi::StyleSheetError> {
         self.all_errors().iter().map(|error| ffi::StyleSheetError::from_parse_error(error)).collect()
     }
@@ -491,15 +810,264 @@ impl StyleSheet {
         self.all_paths().iter().map(|path| path.to_string_lossy().to_string()).collect()
     }
 
+    fn current_checkpoint(&self) -> usize {
+        self.checkpoint().into()
+    }
+
+    fn errors_since_checkpoint(&self, checkpoint: usize) -> Vec<ffi::StyleSheetError> {
+        self.errors_since(checkpoint.into()).iter().map(|error| ffi::StyleSheetError::from_parse_error(error)).collect()
+    }
+
+    fn errors_between_checkpoints(&self, start: usize, end: usize) -> Vec<ffi::StyleSheetError> {
+        self.errors_between(start.into(), end.into()).iter().map(|error| ffi::StyleSheetError::from_parse_error(error)).collect()
+    }
+
+    fn error_count_since_checkpoint(&self, checkpoint: usize) -> usize {
+        self.error_count_since(checkpoint.into())
+    }
+
+    fn set_options(&mut self, options: ffi::ParseOptions) {
+        // The cancellation and statistics are set separately, keep them.
+        let cancellation = self.parse_options().cancellation.clone();
+        let collect_statistics = self.parse_options().collect_statistics;
+        self.set_parse_options(ParseOptions { cancellation, collect_statistics, ..options.into() });
+    }
+
+    fn set_cancellation(&mut self, cancellation: &Cancellation) {
+        let options = ParseOptions { cancellation: Some(cancellation.clone()), ..self.parse_options().clone() };
+        self.set_parse_options(options);
+    }
+
+    fn create_empty_copy(&self) -> Box<StyleSheet> {
+        Box::new(self.empty_copy())
+    }
+
+    fn append_sheet(&mut self, other: Box<StyleSheet>) {
+        self.append(*other);
+    }
+
+    fn set_collect_statistics(&mut self, enabled: bool) {
+        let options = ParseOptions { collect_statistics: enabled, ..self.parse_options().clone() };
+        self.set_parse_options(options);
+    }
+
+    fn file_statistics(&self) -> Vec<ffi::FileStatistics> {
+        let nanoseconds = |duration: std::time::Duration| duration.as_nanos() as u64;
+        self.statistics().into_iter().map(|statistics| ffi::FileStatistics {
+            path: statistics.path.to_string_lossy().to_string(),
+            bytes: statistics.bytes,
+            read: nanoseconds(statistics.read),
+            parse: nanoseconds(statistics.parse),
+            selectors: nanoseconds(statistics.selectors),
+            values: nanoseconds(statistics.values),
+            flatten: nanoseconds(statistics.flatten),
+            rules: statistics.rules,
+            declarations: statistics.declarations,
+            selector_parts: statistics.selector_parts,
+            registry_lookups: statistics.registry_lookups,
+            registry_hits: statistics.registry_hits,
+        }).collect()
+    }
+
+    fn modified_paths(&self) -> Vec<String> {
+        self.all_modified_paths().iter().map(|path| path.to_string_lossy().to_string()).collect()
+    }
+
+    fn reload_file(&mut self, path: &str) -> Result<Vec<ffi::ReloadedRules>, ParseError> {
+        Ok(self.reload(Path::new(path))?.into_iter().map(ffi::ReloadedRules::from).collect())
+    }
+
+    fn reload_modified_files(&mut self) -> Result<Vec<ffi::ReloadedRules>, ParseError> {
+        Ok(self.reload_modified()?.into_iter().map(ffi::ReloadedRules::from).collect())
+    }
+
     fn import_file(&mut self, path: &str) -> Result<(), ParseError> {
         self.import(PathBuf::from(path))
     }
+
+    fn parse_with_cache(&mut self, cache_dir: &str) -> Result<(), ParseError> {
+        self.parse_cached(Path::new(cache_dir))
+    }
+
+    fn parse_visit(&mut self, visitor: &ffi::RuleVisitorAdapter) -> Result<(), ParseError> {
+        let file = self.path.to_string_lossy().to_string();
+        visit_rules(visitor, file, |callback| self.parse_with_visitor(callback))
+    }
+
+    fn parse_string_visit(&mut self, data: &str, visitor: &ffi::RuleVisitorAdapter) -> Result<(), ParseError> {
+        let file = self.path.to_string_lossy().to_string();
+        visit_rules(visitor, file, |callback| self.parse_string_with_visitor(data, callback))
+    }
+
+    fn custom_colors(&self) -> Vec<ffi::CustomColor> {
+        self.custom_colors().into_iter().map(|(source, arguments)| ffi::CustomColor { source, arguments }).collect()
+    }
+}
+
+// Run `parse`, passing every rule it produces to `visitor`. An exception
+// thrown by the visitor cannot unwind through the parser, so the visitor is
+// not called again after one and it is returned as error once parsing is done.
+fn visit_rules(visitor: &ffi::RuleVisitorAdapter, file: String, parse: impl FnOnce(&mut dyn FnMut(&StyleRule)) -> Result<(), ParseError>) -> Result<(), ParseError> {
+    let mut exception: Option<cxx::Exception> = None;
+    parse(&mut |rule| {
+        if exception.is_none() {
+            exception = visitor.visit_rule(rule).err();
+        }
+    })?;
+
+    match exception {
+        Some(exception) => Err(ParseError {
+            kind: ParseErrorKind::Unspecified,
+            message: exception.what().to_string().into(),
+            location: SourceLocation { file, line: 0, column: 0 },
+        }),
+        None => Ok(()),
+    }
+}
+
+fn create_cancellation() -> Box<Cancellation> {
+    Box::new(Cancellation::new())
 }
 
 fn create_stylesheet(path: &str) -> Box<StyleSheet> {
     Box::new(StyleSheet::new(PathBuf::from(path)))
 }
 
+fn create_stylesheet_with_registry(path: &str, registry: &PropertyRegistry) -> Box<StyleSheet> {
+    Box::new(StyleSheet::new_with_registry(PathBuf::from(path), registry))
+}
+
+impl Element for ffi::MatchElement {
+    fn type_name(&self) -> &str {
+        &self.type_name
+    }
+
+    fn id(&self) -> &str {
+        &self.id
+    }
+
+    fn classes(&self) -> &[String] {
+        &self.classes
+    }
+
+    fn pseudo_classes(&self) -> &[String] {
+        &self.pseudo_classes
+    }
+
+    fn attribute(&self, name: &str) -> Option<&str> {
+        self.attributes.iter().find(|attribute| attribute.name == name).map(|attribute| attribute.value.as_str())
+    }
+}
+
+impl StyleMatcher {
+    fn match_elements(&self, elements: &[ffi::MatchElement]) -> Vec<usize> {
+        self.matching_rules(elements)
+    }
+}
+
+impl FragmentParser {
+    fn set_origin(&mut self, path: &str) {
+        self.set_path(PathBuf::from(path));
+    }
+
+    // C++ passes all fragments as a single buffer, `ends` contains the
+    // position in `data` where each fragment ends. The buffer is not
+    // validated as a whole, as that would fail every fragment if a single one
+    // is not valid UTF-8. parse_bytes() validates each fragment instead.
+    fn parse_fragments(&self, data: &[u8], ends: &[usize]) -> Box<FragmentBatch> {
+        let mut start = 0;
+        let fragments: Vec<&[u8]> = ends.iter().map(|end| {
+            let fragment = data.get(start..*end).unwrap_or_default();
+            start = *end;
+            fragment
+        }).collect();
+
+        Box::new(self.parse_bytes(&fragments))
+    }
+}
+
+fn create_fragment_parser(kind: ffi::FragmentKind, registry: &PropertyRegistry) -> Box<FragmentParser> {
+    let kind = match kind {
+        ffi::FragmentKind::Declarations => crate::fragment::FragmentKind::Declarations,
+        _ => crate::fragment::FragmentKind::Rules,
+    };
+    Box::new(FragmentParser::new_with_registry(kind, registry))
+}
+
+impl FragmentBatch {
+    fn fragment_count(&self) -> usize {
+        self.fragments.len()
+    }
+
+    fn fragment_ranges(&self, index: usize) -> ffi::FragmentRanges {
+        let fragment = &self.fragments[index];
+        ffi::FragmentRanges {
+            rules_start: fragment.rules.start,
+            rules_end: fragment.rules.end,
+            properties_start: fragment.properties.start,
+            properties_end: fragment.properties.end,
+            errors_start: fragment.errors.start,
+            errors_end: fragment.errors.end,
+        }
+    }
+
+    fn rule_at(&self, index: usize) -> &StyleRule {
+        &self.rules[index]
+    }
+
+    fn property_at(&self, index: usize) -> &Property {
+        &self.properties[index]
+    }
+
+    fn all_errors(&self) -> Vec<ffi::StyleSheetError> {
+        self.errors.iter().map(|error| ffi::StyleSheetError::from_parse_error(error)).collect()
+    }
+}
+
+fn create_style_matcher(stylesheet: &StyleSheet) -> Box<StyleMatcher> {
+    Box::new(StyleMatcher::new(stylesheet))
+}
+
+impl PropertyRegistry {
+    fn contains(&self, name: &str) -> bool {
+        self.get(name).is_some()
+    }
+}
+
+fn intern_atom(name: &str) -> u32 {
+    Atom::new(name).id()
+}
+
+fn lookup_atom(name: &str, id: &mut u32) -> bool {
+    match Atom::lookup(name) {
+        Some(atom) => {
+            *id = atom.id();
+            true
+        },
+        None => false,
+    }
+}
+
+fn atom_str(id: u32) -> &'static str {
+    Atom::from_id(id).unwrap_or_default().as_str()
+}
+
+fn create_property_registry() -> Box<PropertyRegistry> {
+    Box::new(PropertyRegistry::new())
+}
+
+fn create_property_registry_with_parent(parent: &PropertyRegistry) -> Box<PropertyRegistry> {
+    Box::new(PropertyRegistry::new_with_parent(parent))
+}
+
+fn global_property_registry() -> Box<PropertyRegistry> {
+    Box::new(PropertyRegistry::global().clone())
+}
+
+fn clone_property_registry(registry: &PropertyRegistry) -> Box<PropertyRegistry> {
+    Box::new(registry.clone())
+}
+
 impl std::fmt::Display for ValueConversionError {
     fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
         write!(f, "Value could not be converted: {}", self.message)
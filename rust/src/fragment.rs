@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+// Parsing of many small pieces of CSS, like the inline styles of widgets.
+//
+// Parsing each of them as a separate StyleSheet has a lot of overhead for
+// inputs that only contain a few properties. FragmentParser instead parses a
+// whole batch at once using a single parse context, and stores the results of
+// all fragments in shared lists that each fragment refers to by range.
+
+use std::ops::Range;
+use std::path::PathBuf;
+use std::str::Utf8Error;
+use std::sync::Arc;
+
+use cssparser::RuleBodyParser;
+
+use crate::details::parse_error_from_cssparser_error;
+use crate::details::parsecontext::{enter_parse_context, take_defined};
+use crate::details::rulesparser::{NestedParser, ParseResult, TopLevelParser};
+use crate::parseerror::{ParseError, ParseErrorKind, SourceLocation};
+use crate::property::{add_property_definition, Property, PropertyRegistry};
+use crate::stylerule::{resolve_urls, StyleRule};
+use crate::stylesheet::ParseOptions;
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum FragmentKind {
+    // Fragments contain rules, like a StyleSheet.
+    Rules,
+    // Fragments contain a list of declarations without selector, like the
+    // contents of a style attribute.
+    Declarations,
+}
+
+// The results of a single fragment, as ranges of the lists of a
+// FragmentBatch.
+#[derive(Debug, Default, Clone, PartialEq)]
+pub struct Fragment {
+    pub rules: Range<usize>,
+    pub properties: Range<usize>,
+    pub errors: Range<usize>,
+}
+
+#[derive(Debug, Default)]
+pub struct FragmentBatch {
+    pub fragments: Vec<Fragment>,
+    // The rules of all fragments, only used for FragmentKind::Rules. The
+    // source order of each rule is its position within its fragment.
+    pub rules: Vec<StyleRule>,
+    // The properties of all fragments, only used for
+    // FragmentKind::Declarations.
+    pub properties: Vec<Property>,
+    pub errors: Vec<ParseError>,
+}
+
+impl FragmentBatch {
+    pub fn rules(&self, index: usize) -> &[StyleRule] {
+        &self.rules[self.fragments[index].rules.clone()]
+    }
+
+    pub fn properties(&self, index: usize) -> &[Property] {
+        &self.properties[self.fragments[index].properties.clone()]
+    }
+
+    pub fn errors(&self, index: usize) -> &[ParseError] {
+        &self.errors[self.fragments[index].errors.clone()]
+    }
+}
+
+#[derive(Debug)]
+pub struct FragmentParser {
+    kind: FragmentKind,
+    registry: PropertyRegistry,
+    path: PathBuf,
+}
+
+impl FragmentParser {
+    // Create a FragmentParser that uses the global property registry.
+    pub fn new(kind: FragmentKind) -> FragmentParser {
+        FragmentParser::new_with_registry(kind, PropertyRegistry::global())
+    }
+
+    pub fn new_with_registry(kind: FragmentKind, registry: &PropertyRegistry) -> FragmentParser {
+        FragmentParser { kind, registry: registry.clone(), path: PathBuf::new() }
+    }
+
+    // Set the path that errors are reported from and relative URLs are
+    // resolved against.
+    pub fn set_path(&mut self, path: PathBuf) {
+        self.path = path;
+    }
+
+    // Parse every entry of `fragments` separately. Property definitions from
+    // custom properties or @property rules are added to the registry and are
+    // available to the fragments that follow. @import is not supported.
+    pub fn parse(&self, fragments: &[&str]) -> FragmentBatch {
+        self.parse_inputs(fragments.len(), fragments.iter().map(|fragment| Ok(*fragment)))
+    }
+
+    // Parse every entry of `fragments` separately, like parse(). A fragment
+    // that is not valid UTF-8 is not parsed, it only gets an error. The other
+    // fragments are not affected by it.
+    pub fn parse_bytes(&self, fragments: &[&[u8]]) -> FragmentBatch {
+        self.parse_inputs(fragments.len(), fragments.iter().map(|fragment| std::str::from_utf8(fragment)))
+    }
+
+    fn parse_inputs<'a>(&self, count: usize, fragments: impl Iterator<Item = Result<&'a str, Utf8Error>>) -> FragmentBatch {
+        let file = self.path.to_string_lossy().to_string();
+        let _context = enter_parse_context(&self.registry, &file, &ParseOptions::default());
+
+        let mut batch = FragmentBatch::default();
+        batch.fragments.reserve(count);
+
+        for fragment in fragments {
+            let rules_start = batch.rules.len();
+            let properties_start = batch.properties.len();
+            let errors_start = batch.errors.len();
+
+            match (fragment, self.kind) {
+                (Ok(fragment), FragmentKind::Rules) => self.parse_rules(fragment, &file, &mut batch),
+                (Ok(fragment), FragmentKind::Declarations) => self.parse_declarations(fragment, &file, &mut batch),
+                (Err(error), _) => {
+                    let message = format!("Fragment is not valid UTF-8: {}", error);
+                    batch.errors.push(ParseError { kind: ParseErrorKind::Unspecified, message: message.into(), location: SourceLocation::from_file(&file) });
+                },
+            }
+
+            for (index, rule) in batch.rules[rules_start..].iter_mut().enumerate() {
+                rule.source_order = index;
+            }
+
+            batch.fragments.push(Fragment {
+                rules: rules_start..batch.rules.len(),
+                properties: properties_start..batch.properties.len(),
+                errors: errors_start..batch.errors.len(),
+            });
+        }
+
+        // Definitions are tracked for StyleSheet::defined_properties(), which
+        // fragments do not have.
+        take_defined();
+
+        batch
+    }
+
+    fn parse_rules(&self, fragment: &str, file: &str, batch: &mut FragmentBatch) {
+        // Lines are reported starting at 1.
+        let mut parser_input = cssparser::ParserInput::new_with_line_number_offset(fragment, 1);
+        let mut parser = cssparser::Parser::new(&mut parser_input);
+        let mut rules_parser = TopLevelParser{};
+        let mut style_sheet_parser = cssparser::StyleSheetParser::new(&mut parser, &mut rules_parser);
+
+        while let Some(entry) = style_sheet_parser.next() {
+            match entry {
+                Ok(ParseResult::Rule(rule)) => StyleRule::from_parsed_rule_into(&rule, &self.path, &mut batch.rules),
+                Ok(ParseResult::PropertyDefinition(definition)) => {
+                    add_property_definition(&Arc::new(definition));
+                },
+                Ok(ParseResult::Import(_)) => {
+                    let location = SourceLocation::from_file_location(file.to_string(), style_sheet_parser.input.current_source_location());
+                    batch.errors.push(ParseError { kind: ParseErrorKind::UnsupportedAtRule, message: "@import is not supported in fragments".into(), location });
+                },
+                Ok(ParseResult::Property(_)) => {
+                    panic!("Received property at toplevel!");
+                },
+                Err(error) => batch.errors.push(parse_error_from_cssparser_error(&error.0, file.to_string())),
+            }
+        }
+    }
+
+    fn parse_declarations(&self, fragment: &str, file: &str, batch: &mut FragmentBatch) {
+        let mut parser_input = cssparser::ParserInput::new_with_line_number_offset(fragment, 1);
+        let mut parser = cssparser::Parser::new(&mut parser_input);
+        let mut nested_parser = NestedParser{};
+        let mut body_parser = RuleBodyParser::<NestedParser, ParseResult, ParseError>::new(&mut parser, &mut nested_parser);
+
+        let mut properties = Vec::new();
+        while let Some(entry) = body_parser.next() {
+            match entry {
+                Ok(ParseResult::Property(property)) => properties.push(property),
+                Ok(ParseResult::PropertyDefinition(definition)) => {
+                    add_property_definition(&Arc::new(definition));
+                },
+                Ok(_) => {
+                    let location = SourceLocation::from_file_location(file.to_string(), body_parser.input.current_source_location());
+                    batch.errors.push(ParseError { kind: ParseErrorKind::InvalidQualifiedRule, message: "Only declarations are allowed in a declaration list".into(), location });
+                },
+                Err(error) => batch.errors.push(parse_error_from_cssparser_error(&error.0, file.to_string())),
+            }
+        }
+
+        batch.properties.extend(resolve_urls(&properties, &self.path));
+    }
+}
@@ -3,12 +3,16 @@
 
 mod details;
 
+pub mod atom;
 pub mod value;
 pub mod selector;
 pub mod parseerror;
 pub mod property;
 pub mod stylerule;
+pub mod stylematcher;
 pub mod stylesheet;
+pub mod fragment;
+pub mod statistics;
 
 pub mod ffi;
 
@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 // SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
 
+use std::borrow::Cow;
+
 #[derive(Debug, Clone, PartialEq)]
 pub enum ParseErrorKind {
     Unspecified,
@@ -20,6 +22,8 @@ pub enum ParseErrorKind {
     InvalidQualifiedRule,
     FileError,
     StyleSheetParseError,
+    LimitExceeded,
+    Cancelled,
 }
 
 #[derive(Debug, Clone, PartialEq)]
@@ -42,7 +46,8 @@ impl SourceLocation {
 #[derive(Debug, Clone, PartialEq)]
 pub struct ParseError {
     pub kind: ParseErrorKind,
-    pub message: String,
+    // Fixed messages are not copied, see details::parse_error().
+    pub message: Cow<'static, str>,
     pub location: SourceLocation,
 }
 
@@ -70,6 +75,8 @@ impl std::fmt::Display for ParseError {
             ParseErrorKind::InvalidQualifiedRule => write!(f, "Invalid qualified rule"),
             ParseErrorKind::FileError => write!(f, "IO Error: {}", self.message),
             ParseErrorKind::StyleSheetParseError => write!(f, "Stylesheet failed to parse: {}", self.message),
+            ParseErrorKind::LimitExceeded => write!(f, "Limit exceeded: {}", self.message),
+            ParseErrorKind::Cancelled => write!(f, "Parsing was cancelled"),
         }
     }
 }
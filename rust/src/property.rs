@@ -1,10 +1,16 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 // SPDX-FileCopyrightText: 2025 Arjen Hiemstra <ahiemstra@heimr.nl>
 
+use std::collections::hash_map::{DefaultHasher, Entry, HashMap};
+use std::hash::{Hash, Hasher};
+use std::ops::Deref;
 use std::sync::{Arc, RwLock, OnceLock};
+use std::sync::atomic::{AtomicU64, Ordering};
 
 use crate::{
-    details::property::syntax::{parse_syntax, ParsedPropertySyntax},
+    atom::Atom,
+    details::parsecontext::{add_definition, record_missed_lookup, with_current_registry},
+    details::property::syntax::{parse_syntax, ParsedPropertySyntax, SyntaxMatcher},
     parseerror::{ParseError, SourceLocation},
     value::Value
 };
@@ -12,64 +18,149 @@ use crate::{
 #[derive(Debug, Default, PartialEq, Clone)]
 pub struct PropertyDefinition {
     pub name: String,
+    // Use set_syntax() to change the syntax, so the compiled matcher stays in
+    // sync with it.
     pub syntax: ParsedPropertySyntax,
     pub inherit: bool,
     pub initial: Vec<Value>,
+    // `syntax`, compiled for validating values.
+    matcher: SyntaxMatcher,
 }
 
-fn property_definitions() -> &'static RwLock<Vec<Arc<PropertyDefinition>>> {
-    static DEFINITIONS: OnceLock<RwLock<Vec<Arc<PropertyDefinition>>>> = OnceLock::new();
-    DEFINITIONS.get_or_init(|| RwLock::new(Vec::new()))
+#[derive(Debug, Default)]
+struct RegistryData {
+    definitions: RwLock<HashMap<String, Arc<PropertyDefinition>>>,
+    parent: Option<PropertyRegistry>,
 }
 
-pub fn property_definition(name: &str) -> Option<Arc<PropertyDefinition>> {
-    if let Ok(definitions) = property_definitions().read() {
-        let def = definitions.iter().find(|&definition| definition.name == name);
-        if let Some(definition) = def {
-            return Some(definition.clone());
+// A collection of property definitions.
+//
+// A PropertyRegistry is a cheap handle, clones refer to the same set of
+// definitions. Registries can be chained to a parent registry, lookups that
+// fail in a registry continue in its parent while new definitions are only
+// ever added to the registry itself. The registry is freed when the last
+// handle to it is dropped.
+#[derive(Debug, Default, Clone)]
+pub struct PropertyRegistry {
+    data: Arc<RegistryData>,
+}
+
+impl PropertyRegistry {
+    pub fn new() -> PropertyRegistry {
+        PropertyRegistry::default()
+    }
+
+    pub fn new_with_parent(parent: &PropertyRegistry) -> PropertyRegistry {
+        PropertyRegistry {
+            data: Arc::new(RegistryData {
+                definitions: RwLock::new(HashMap::new()),
+                parent: Some(parent.clone()),
+            })
         }
     }
 
-    None{}
-}
+    // The process-wide registry, used by StyleSheets that were not given a
+    // registry of their own.
+    pub fn global() -> &'static PropertyRegistry {
+        static GLOBAL: OnceLock<PropertyRegistry> = OnceLock::new();
+        GLOBAL.get_or_init(PropertyRegistry::new)
+    }
 
-pub fn add_property_definition(definition: &Arc<PropertyDefinition>) -> bool {
-    let defs = property_definitions().write();
-    if let Ok(mut definitions) = defs {
-        if definitions.iter().find(|&def| def.name == definition.name).is_some() {
+    pub fn parent(&self) -> Option<&PropertyRegistry> {
+        self.data.parent.as_ref()
+    }
+
+    pub fn get(&self, name: &str) -> Option<Arc<PropertyDefinition>> {
+        if let Ok(definitions) = self.data.definitions.read() {
+            if let Some(definition) = definitions.get(name) {
+                return Some(definition.clone());
+            }
+        }
+
+        self.parent().and_then(|parent| parent.get(name))
+    }
+
+    // Add a definition to this registry. Returns false if a definition with
+    // the same name already exists in this registry or any of its parents.
+    pub fn add(&self, definition: &Arc<PropertyDefinition>) -> bool {
+        if self.parent().is_some_and(|parent| parent.get(&definition.name).is_some()) {
             return false;
         }
 
-        definitions.push(definition.clone());
+        if let Ok(mut definitions) = self.data.definitions.write() {
+            match definitions.entry(definition.name.clone()) {
+                Entry::Occupied(_) => return false,
+                Entry::Vacant(entry) => {
+                    entry.insert(definition.clone());
+                }
+            }
+        }
+
+        true
     }
 
-    true
+    // Remove `definition` from this registry, if it is the definition that is
+    // registered under its name. Parents are not changed.
+    pub(crate) fn remove(&self, definition: &Arc<PropertyDefinition>) {
+        if let Ok(mut definitions) = self.data.definitions.write() {
+            if let Entry::Occupied(entry) = definitions.entry(definition.name.clone()) {
+                if Arc::ptr_eq(entry.get(), definition) {
+                    entry.remove();
+                }
+            }
+        }
+    }
+
+    // The definitions in this registry, excluding those of its parents.
+    pub(crate) fn own_definitions(&self) -> Vec<Arc<PropertyDefinition>> {
+        self.data.definitions.read().map(|definitions| definitions.values().cloned().collect()).unwrap_or_default()
+    }
+
+    // The definitions visible through this registry, including those of its
+    // parents.
+    pub(crate) fn all_definitions(&self) -> Vec<Arc<PropertyDefinition>> {
+        let mut definitions = self.own_definitions();
+        if let Some(parent) = self.parent() {
+            definitions.extend(parent.all_definitions());
+        }
+        definitions
+    }
+
+    // Returns true if both handles refer to the same registry.
+    pub fn is_same(&self, other: &PropertyRegistry) -> bool {
+        Arc::ptr_eq(&self.data, &other.data)
+    }
+}
+
+// Look up a definition in the registry of the StyleSheet that is currently
+// being parsed on this thread, or in the global registry if there is none.
+pub fn property_definition(name: &str) -> Option<Arc<PropertyDefinition>> {
+    let definition = with_current_registry(|registry| registry.get(name));
+    if definition.is_none() {
+        record_missed_lookup(name);
+    }
+    definition
+}
+
+// Add a definition to the registry of the StyleSheet that is currently being
+// parsed on this thread, or to the global registry if there is none.
+pub fn add_property_definition(definition: &Arc<PropertyDefinition>) -> bool {
+    add_definition(definition)
 }
 
 impl PropertyDefinition {
     pub fn empty() -> PropertyDefinition {
-        PropertyDefinition {
-            name: String::new(),
-            syntax: ParsedPropertySyntax::Empty,
-            inherit: false,
-            initial: Vec::new(),
-        }
+        PropertyDefinition::new(String::new(), ParsedPropertySyntax::Empty, false, Vec::new())
+    }
+
+    pub fn new(name: String, syntax: ParsedPropertySyntax, inherit: bool, initial: Vec<Value>) -> PropertyDefinition {
+        let matcher = SyntaxMatcher::new(&syntax);
+        PropertyDefinition { name, syntax, inherit, initial, matcher }
     }
 
     pub fn from_name_syntax(name: &str, syntax: &str, file: &str, line: u32, column: u32) -> Result<PropertyDefinition, ParseError> {
-        let result = parse_syntax(syntax, SourceLocation { file: file.to_string(), line, column });
-        if let Ok(parsed_syntax) = result {
-            Ok(
-                PropertyDefinition {
-                    name: String::from(name),
-                    syntax: parsed_syntax,
-                    inherit: false,
-                    initial: Vec::new(),
-                }
-            )
-        } else {
-            Err(result.err().unwrap())
-        }
+        let parsed_syntax = parse_syntax(syntax, SourceLocation { file: file.to_string(), line, column })?;
+        Ok(PropertyDefinition::new(String::from(name), parsed_syntax, false, Vec::new()))
     }
 
     pub fn from_name_syntax_initial(name: &str, syntax: &str, initial: &[Value], file: &str, line: u32, column: u32) -> Result<PropertyDefinition, ParseError> {
@@ -77,11 +168,118 @@ impl PropertyDefinition {
         pd.initial = Vec::from(initial);
         Ok(pd)
     }
+
+    pub fn set_syntax(&mut self, syntax: ParsedPropertySyntax) {
+        self.matcher = SyntaxMatcher::new(&syntax);
+        self.syntax = syntax;
+    }
+
+    pub(crate) fn matcher(&self) -> &SyntaxMatcher {
+        &self.matcher
+    }
 }
 
 #[derive(Debug, Clone, Default, PartialEq)]
 pub struct Property {
-    pub name: String,
+    pub name: Atom,
     pub definition: Arc<PropertyDefinition>,
     pub values: Vec<Value>,
 }
+
+// The definition is not part of the hash, it is the definition of `name` in
+// practice and comparing it is expensive.
+impl Hash for Property {
+    fn hash<H: Hasher>(&self, state: &mut H) {
+        self.name.as_str().hash(state);
+        self.values.hash(state);
+    }
+}
+
+// The properties of a rule.
+//
+// Rules with the same properties share a single block, both rules created
+// from the selectors of a single parsed rule and rules that happen to
+// declare the same properties. Cloning a block is cheap.
+#[derive(Debug, Clone)]
+pub struct PropertyBlock {
+    properties: Arc<[Property]>,
+    // Unique for every block that is created. Clones of a block, which
+    // includes the blocks shared by BlockInterner, have the same id.
+    id: u64,
+    // A hash of the properties, which BlockInterner uses to find equal
+    // blocks. Different blocks can have the same hash.
+    hash: u64,
+}
+
+impl PropertyBlock {
+    pub fn new(properties: Vec<Property>) -> PropertyBlock {
+        // 0 is left for blocks that were not created here, like the C++
+        // Rules that are not created by parsing.
+        static NEXT_ID: AtomicU64 = AtomicU64::new(1);
+
+        let mut hasher = DefaultHasher::new();
+        properties.hash(&mut hasher);
+        PropertyBlock { properties: properties.into(), id: NEXT_ID.fetch_add(1, Ordering::Relaxed), hash: hasher.finish() }
+    }
+
+    // An id that only this block and its clones have, so it can be used to
+    // cache anything that is computed from the properties. Rules that share
+    // a block have the same id, equal blocks that are not shared have
+    // different ids. Ids are assigned in the order blocks are created, so
+    // they differ between runs and should not be stored.
+    pub fn id(&self) -> u64 {
+        self.id
+    }
+
+    // Whether both blocks are the same shared block, rather than only equal.
+    // This is the same as comparing their ids.
+    pub fn ptr_eq(&self, other: &PropertyBlock) -> bool {
+        Arc::ptr_eq(&self.properties, &other.properties)
+    }
+}
+
+impl Default for PropertyBlock {
+    fn default() -> Self {
+        PropertyBlock::new(Vec::new())
+    }
+}
+
+impl Deref for PropertyBlock {
+    type Target = [Property];
+
+    fn deref(&self) -> &Self::Target {
+        &self.properties
+    }
+}
+
+impl From<Vec<Property>> for PropertyBlock {
+    fn from(properties: Vec<Property>) -> Self {
+        PropertyBlock::new(properties)
+    }
+}
+
+impl PartialEq for PropertyBlock {
+    fn eq(&self, other: &Self) -> bool {
+        self.ptr_eq(other) || (self.hash == other.hash && self.properties == other.properties)
+    }
+}
+
+// Keeps one instance of every distinct PropertyBlock.
+#[derive(Debug, Default)]
+pub(crate) struct BlockInterner {
+    blocks: HashMap<u64, Vec<PropertyBlock>>,
+}
+
+impl BlockInterner {
+    // Returns the block that is equal to `block` if there is one, otherwise
+    // `block` itself is kept and returned.
+    pub fn intern(&mut self, block: &PropertyBlock) -> PropertyBlock {
+        let candidates = self.blocks.entry(block.hash).or_default();
+        if let Some(existing) = candidates.iter().find(|candidate| *candidate == block) {
+            return existing.clone();
+        }
+
+        candidates.push(block.clone());
+        block.clone()
+    }
+}
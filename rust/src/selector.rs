@@ -1,7 +1,8 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 // SPDX-FileCopyrightText: 2025 Arjen Hiemstra <ahiemstra@heimr.nl>
 
-use crate::value::Value;
+use crate::atom::Atom;
+use crate::value::{Value, ValueData};
 
 #[derive(Debug, Clone, Copy, PartialEq)]
 pub enum AttributeOperator {
@@ -41,16 +42,48 @@ pub enum SelectorValue {
 pub struct SelectorPart {
     pub kind: SelectorKind,
     pub value: SelectorValue,
+    // The interned name of type, class, id and pseudo-class parts, see atom().
+    atom: Atom,
 }
 
 impl SelectorPart {
+    pub fn new(kind: SelectorKind, value: SelectorValue) -> SelectorPart {
+        let atom = match (kind, &value) {
+            (SelectorKind::Type | SelectorKind::Class | SelectorKind::Id | SelectorKind::PseudoClass, SelectorValue::Value(Value { data: ValueData::String(name) })) => Atom::new(name),
+            _ => Atom::default(),
+        };
+        SelectorPart { kind, value, atom }
+    }
+
     pub fn new_with_empty(kind: SelectorKind) -> SelectorPart {
-        SelectorPart { kind, value: SelectorValue::Empty }
+        SelectorPart::new(kind, SelectorValue::Empty)
     }
 
     pub fn new_with_value(kind: SelectorKind, value: Value) -> SelectorPart {
-        SelectorPart { kind, value: SelectorValue::Value(value) }
+        SelectorPart::new(kind, SelectorValue::Value(value))
     }
+
+    pub fn new_with_attribute(name: String, operator: AttributeOperator, value: Value) -> SelectorPart {
+        SelectorPart::new(SelectorKind::Attribute, SelectorValue::Attribute { name, operator, value })
+    }
+
+    // The name of a type, class, id or pseudo-class part, interned when the
+    // part was created so matching does not need to look it up again. The
+    // empty atom for all other parts.
+    pub fn atom(&self) -> Atom {
+        self.atom
+    }
+}
+
+// The specificity of a selector, as (ids, classes, types).
+//
+// Classes includes pseudo-classes, :root and attribute selectors. Specificities
+// compare component-wise, starting with ids.
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash)]
+pub struct Specificity {
+    pub ids: u32,
+    pub classes: u32,
+    pub types: u32,
 }
 
 #[derive(Debug, Clone, PartialEq)]
@@ -70,30 +103,24 @@ impl Selector {
     }
 
     pub fn combine(first: &Selector, second: &Selector) -> Selector {
-        let mut parts = first.parts.clone();
+        if second.parts.is_empty() {
+            return first.clone();
+        }
 
-        if !second.parts.is_empty() {
-            // Find all the indices of RelativeParent so we can replace them
-            // later on.
-            let mut relative_indices = Vec::new();
-            for (index, part) in parts.iter().enumerate() {
-                if part.kind == SelectorKind::RelativeParent {
-                    relative_indices.push(index);
-                }
-            }
+        let relative_count = first.parts.iter().filter(|part| part.kind == SelectorKind::RelativeParent).count();
 
-            if relative_indices.is_empty() {
-                parts.extend(second.parts.clone())
-            } else {
-                // Since we modify the list and introduce potentially multiple
-                // new items, our indices may shift. We need to keep track of
-                // that otherwise the insertion point becomes incorrect.
-                let mut offset = 0;
-                for index in relative_indices {
-                    let i = index + offset;
-                    parts.remove(i);
-                    parts.splice(i..i, second.parts.clone());
-                    offset = offset + second.parts.len() - 1;
+        // Build the result in one pass, replacing each RelativeParent with
+        // the parts of `second`, or appending them if there is none.
+        let mut parts = Vec::with_capacity(first.parts.len() - relative_count + second.parts.len() * relative_count.max(1));
+        if relative_count == 0 {
+            parts.extend_from_slice(&first.parts);
+            parts.extend_from_slice(&second.parts);
+        } else {
+            for part in &first.parts {
+                if part.kind == SelectorKind::RelativeParent {
+                    parts.extend_from_slice(&second.parts);
+                } else {
+                    parts.push(part.clone());
                 }
             }
         }
@@ -101,6 +128,19 @@ impl Selector {
         Selector { parts }
     }
 
+    pub fn specificity(&self) -> Specificity {
+        let mut result = Specificity::default();
+        for part in &self.parts {
+            match part.kind {
+                SelectorKind::Id => result.ids += 1,
+                SelectorKind::Class | SelectorKind::PseudoClass | SelectorKind::DocumentRoot | SelectorKind::Attribute => result.classes += 1,
+                SelectorKind::Type => result.types += 1,
+                _ => {},
+            }
+        }
+        result
+    }
+
     pub fn push_with_empty(&mut self, kind: SelectorKind) {
         self.parts.push(SelectorPart::new_with_empty(kind))
     }
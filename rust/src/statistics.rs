@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+// Statistics about parsing a StyleSheet, to find out where the time of a slow
+// parse goes.
+//
+// Statistics are only collected if ParseOptions::collect_statistics is set.
+// Otherwise the only cost is checking a thread local flag in a few places.
+
+use std::path::PathBuf;
+use std::time::Duration;
+
+// What was parsed for a single file and how long the parts of that took.
+//
+// `parse` is the time spent parsing the file, including `selectors`,
+// `values` and `flatten`. What remains of it was mostly spent tokenizing.
+// Time spent on files that are imported is not included.
+#[derive(Debug, Default, Clone, PartialEq)]
+pub struct FileStatistics {
+    pub path: PathBuf,
+    pub bytes: usize,
+
+    pub read: Duration,
+    pub parse: Duration,
+    pub selectors: Duration,
+    pub values: Duration,
+    pub flatten: Duration,
+
+    pub rules: usize,
+    pub declarations: usize,
+    pub selector_parts: usize,
+    // Lookups of property definitions in the registry and how many of them
+    // found a definition.
+    pub registry_lookups: usize,
+    pub registry_hits: usize,
+}
+
+impl FileStatistics {
+    pub fn new(path: PathBuf) -> FileStatistics {
+        FileStatistics { path, ..Default::default() }
+    }
+
+    // Add the statistics of `other` to these.
+    pub fn merge(&mut self, other: &FileStatistics) {
+        self.bytes += other.bytes;
+        self.read += other.read;
+        self.parse += other.parse;
+        self.selectors += other.selectors;
+        self.values += other.values;
+        self.flatten += other.flatten;
+        self.rules += other.rules;
+        self.declarations += other.declarations;
+        self.selector_parts += other.selector_parts;
+        self.registry_lookups += other.registry_lookups;
+        self.registry_hits += other.registry_hits;
+    }
+
+    // The fraction of registry lookups that found a definition.
+    pub fn registry_hit_rate(&self) -> f64 {
+        if self.registry_lookups == 0 {
+            return 0.0;
+        }
+
+        self.registry_hits as f64 / self.registry_lookups as f64
+    }
+}
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub(crate) enum Phase {
+    Selectors,
+    Values,
+    Flatten,
+}
@@ -0,0 +1,467 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+// Matching of StyleSheet rules against elements.
+//
+// Rules are indexed by the rightmost compound selector of their selector, the
+// same way browsers do: a rule that requires a certain id, class, type or
+// pseudo-class on the element it applies to is stored in a bucket for that
+// value. Matching an element then only needs to check the rules in the
+// buckets for the element's own id, classes, type and pseudo-classes, plus
+// the rules that could not be put in a bucket.
+//
+// Names are stored as atoms, the names of an element are converted once per
+// call to matching_rules() so the rules themselves only compare atoms.
+//
+// Selectors are compiled to a flat list of operations that is shared by all
+// rules, each rule refers to a range of it. Every rule also stores the hashes
+// of a few ids, classes and types that its ancestors need to have. Before
+// matching a rule against the ancestors of an element, those hashes are
+// checked against a bloom filter of the names of the ancestors, which rejects
+// most rules with a descendant or child combinator without walking the
+// ancestors at all. This is the same approach as the ancestor filter of the
+// selectors crate, whose bloom filter is used here.
+
+use std::collections::HashMap;
+use std::ops::Range;
+
+use selectors::bloom::BloomFilter;
+
+use crate::atom::Atom;
+use crate::selector::{AttributeOperator, SelectorKind, SelectorPart, SelectorValue, Specificity};
+use crate::stylesheet::StyleSheet;
+use crate::value::{Value, ValueData};
+
+// An element that rules can be matched against.
+pub trait Element {
+    fn type_name(&self) -> &str;
+    fn id(&self) -> &str;
+    fn classes(&self) -> &[String];
+    fn pseudo_classes(&self) -> &[String];
+    fn attribute(&self, name: &str) -> Option<&str>;
+}
+
+// A simple description of an element that implements Element.
+#[derive(Debug, Default, Clone, PartialEq)]
+pub struct ElementData {
+    pub type_name: String,
+    pub id: String,
+    pub classes: Vec<String>,
+    pub pseudo_classes: Vec<String>,
+    pub attributes: Vec<(String, String)>,
+}
+
+impl Element for ElementData {
+    fn type_name(&self) -> &str {
+        &self.type_name
+    }
+
+    fn id(&self) -> &str {
+        &self.id
+    }
+
+    fn classes(&self) -> &[String] {
+        &self.classes
+    }
+
+    fn pseudo_classes(&self) -> &[String] {
+        &self.pseudo_classes
+    }
+
+    fn attribute(&self, name: &str) -> Option<&str> {
+        self.attributes.iter().find(|(key, _)| key == name).map(|(_, value)| value.as_str())
+    }
+}
+
+// A compiled selector part, with names replaced by atoms so matching
+// compares integers instead of strings. Attribute selectors refer to an entry
+// of StyleMatcher::attributes, which keeps operations small and copyable.
+#[derive(Debug, Clone, Copy, PartialEq)]
+enum Op {
+    AnyElement,
+    Type(Atom),
+    Class(Atom),
+    Id(Atom),
+    PseudoClass(Atom),
+    Attribute(u32),
+    DocumentRoot,
+    DescendantCombinator,
+    ChildCombinator,
+    // Parts that can never match, like an unresolved relative parent.
+    Never,
+}
+
+impl Op {
+    fn is_combinator(&self) -> bool {
+        matches!(self, Op::DescendantCombinator | Op::ChildCombinator)
+    }
+}
+
+#[derive(Debug)]
+struct AttributeMatch {
+    name: String,
+    operator: AttributeOperator,
+    value: String,
+}
+
+// The maximum number of ancestor hashes stored for a rule. More hashes reject
+// more rules, but every hash needs to be checked for every candidate.
+const ANCESTOR_HASH_COUNT: usize = 4;
+
+#[derive(Debug)]
+struct IndexedRule {
+    // The operations of the selector of this rule in StyleMatcher::code.
+    code: Range<u32>,
+    specificity: Specificity,
+    // Hashes of names that some ancestor needs to have for the selector to
+    // match, only the first `ancestor_hash_count` are used.
+    ancestor_hashes: [u32; ANCESTOR_HASH_COUNT],
+    ancestor_hash_count: u8,
+}
+
+impl IndexedRule {
+    fn ancestor_hashes(&self) -> &[u32] {
+        &self.ancestor_hashes[..self.ancestor_hash_count as usize]
+    }
+}
+
+// The hash of `atom` used for the ancestor filter. Atoms are consecutive
+// indices, so they are mixed to spread them over the bits of the filter.
+fn ancestor_hash(atom: Atom) -> u32 {
+    atom.id().wrapping_mul(0x9e3779b1) >> 8
+}
+
+// The names of the ancestors of an element, for rejecting rules that require
+// an ancestor none of them can match.
+//
+// matching_rules() builds one of these from the ancestors it is given. When
+// matching every element of a tree, it is cheaper to keep a single filter,
+// push() an element before matching its children and pop() it afterwards,
+// then pass it to matching_rules_with_filter().
+pub struct AncestorFilter {
+    filter: Box<BloomFilter>,
+    // The hashes that were inserted for each pushed element, and where the
+    // hashes of each element start.
+    hashes: Vec<u32>,
+    starts: Vec<usize>,
+}
+
+impl AncestorFilter {
+    pub fn new() -> AncestorFilter {
+        AncestorFilter { filter: Box::new(BloomFilter::new()), hashes: Vec::new(), starts: Vec::new() }
+    }
+
+    // Add the names of `element` to the filter.
+    pub fn push(&mut self, element: &impl Element) {
+        self.push_atoms(&ElementAtoms::new(element));
+    }
+
+    fn push_atoms(&mut self, atoms: &ElementAtoms) {
+        self.starts.push(self.hashes.len());
+
+        for atom in atoms.type_name.iter().chain(atoms.id.iter()).chain(atoms.classes.iter()) {
+            let hash = ancestor_hash(*atom);
+            self.filter.insert_hash(hash);
+            self.hashes.push(hash);
+        }
+    }
+
+    // Remove the names of the element that was pushed last.
+    pub fn pop(&mut self) {
+        let Some(start) = self.starts.pop() else {
+            return;
+        };
+
+        for hash in self.hashes.drain(start..) {
+            self.filter.remove_hash(hash);
+        }
+    }
+
+    // The number of elements that were pushed.
+    pub fn len(&self) -> usize {
+        self.starts.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.starts.is_empty()
+    }
+
+    // Whether some ancestor might have all names of `rule`. False positives
+    // are possible, false negatives are not.
+    fn might_match(&self, rule: &IndexedRule) -> bool {
+        rule.ancestor_hashes().iter().all(|hash| self.filter.might_contain_hash(*hash))
+    }
+}
+
+impl Default for AncestorFilter {
+    fn default() -> Self {
+        AncestorFilter::new()
+    }
+}
+
+// The names of an element converted to atoms. Names that were never
+// interned cannot be used by any selector, so they are left out.
+struct ElementAtoms {
+    type_name: Option<Atom>,
+    id: Option<Atom>,
+    classes: Vec<Atom>,
+    pseudo_classes: Vec<Atom>,
+}
+
+impl ElementAtoms {
+    fn new(element: &impl Element) -> ElementAtoms {
+        ElementAtoms {
+            type_name: Atom::lookup(element.type_name()),
+            id: if element.id().is_empty() { None } else { Atom::lookup(element.id()) },
+            classes: element.classes().iter().filter_map(|class| Atom::lookup(class)).collect(),
+            pseudo_classes: element.pseudo_classes().iter().filter_map(|pseudo_class| Atom::lookup(pseudo_class)).collect(),
+        }
+    }
+}
+
+#[derive(Debug, Default)]
+pub struct StyleMatcher {
+    rules: Vec<IndexedRule>,
+    // The compiled selectors of all rules.
+    code: Vec<Op>,
+    attributes: Vec<AttributeMatch>,
+    ids: HashMap<Atom, Vec<usize>>,
+    classes: HashMap<Atom, Vec<usize>>,
+    types: HashMap<Atom, Vec<usize>>,
+    pseudo_classes: HashMap<Atom, Vec<usize>>,
+    universal: Vec<usize>,
+}
+
+fn value_str(value: &Value) -> &str {
+    match &value.data {
+        ValueData::String(string) => string.as_str(),
+        _ => "",
+    }
+}
+
+// The parts of the rightmost compound selector of `parts`.
+fn rightmost_compound(parts: &[Op]) -> &[Op] {
+    match parts.iter().rposition(|part| part.is_combinator()) {
+        Some(position) => &parts[position + 1..],
+        None => parts,
+    }
+}
+
+fn matches_attribute(element: &impl Element, name: &str, operator: AttributeOperator, expected: &str) -> bool {
+    let Some(actual) = element.attribute(name) else {
+        return false;
+    };
+
+    match operator {
+        AttributeOperator::None | AttributeOperator::Exists => true,
+        AttributeOperator::Equals => actual == expected,
+        AttributeOperator::Includes => actual.split_whitespace().any(|word| word == expected),
+        AttributeOperator::Prefixed => !expected.is_empty() && actual.starts_with(expected),
+        AttributeOperator::Suffixed => !expected.is_empty() && actual.ends_with(expected),
+        AttributeOperator::Substring => !expected.is_empty() && actual.contains(expected),
+        AttributeOperator::DashMatch => actual == expected || actual.strip_prefix(expected).is_some_and(|rest| rest.starts_with('-')),
+    }
+}
+
+// The hashes of names that ancestors need to have for `parts` to match. These
+// are the ids, classes and types of every compound selector except the
+// rightmost one, ids and classes first since they are rarer.
+fn ancestor_hashes(parts: &[Op]) -> ([u32; ANCESTOR_HASH_COUNT], u8) {
+    let mut hashes = [0; ANCESTOR_HASH_COUNT];
+    let mut count = 0;
+
+    let Some(position) = parts.iter().rposition(|part| part.is_combinator()) else {
+        return (hashes, 0);
+    };
+
+    let ancestors = &parts[..position];
+    let ids_and_classes = ancestors.iter().rev().filter_map(|part| match part {
+        Op::Id(atom) | Op::Class(atom) => Some(*atom),
+        _ => None,
+    });
+    let types = ancestors.iter().rev().filter_map(|part| if let Op::Type(atom) = part { Some(*atom) } else { None });
+
+    for hash in ids_and_classes.chain(types).map(ancestor_hash) {
+        if count == ANCESTOR_HASH_COUNT {
+            break;
+        }
+        if !hashes[..count].contains(&hash) {
+            hashes[count] = hash;
+            count += 1;
+        }
+    }
+
+    (hashes, count as u8)
+}
+
+impl StyleMatcher {
+    // Create a matcher for all rules of `sheet`. The indices returned by
+    // matching_rules() refer to rules in the order returned by
+    // StyleSheet::all_rules().
+    //
+    // The matcher keeps its own copy of the selectors, it does not need to be
+    // recreated unless the StyleSheet changes.
+    pub fn new(sheet: &StyleSheet) -> StyleMatcher {
+        let mut matcher = StyleMatcher::default();
+
+        for (index, rule) in sheet.all_rules_iter().enumerate() {
+            let start = matcher.code.len();
+            rule.selector.parts.iter().for_each(|part| matcher.compile_part(part));
+            let code = start as u32..matcher.code.len() as u32;
+
+            let parts = &matcher.code[start..];
+            let compound = rightmost_compound(parts);
+            let id = compound.iter().find_map(|part| if let Op::Id(atom) = part { Some(*atom) } else { None });
+            let class = compound.iter().find_map(|part| if let Op::Class(atom) = part { Some(*atom) } else { None });
+            let type_name = compound.iter().find_map(|part| if let Op::Type(atom) = part { Some(*atom) } else { None });
+            let pseudo_class = compound.iter().find_map(|part| if let Op::PseudoClass(atom) = part { Some(*atom) } else { None });
+            let (ancestor_hashes, ancestor_hash_count) = ancestor_hashes(parts);
+
+            if let Some(id) = id {
+                matcher.ids.entry(id).or_default().push(index);
+            } else if let Some(class) = class {
+                matcher.classes.entry(class).or_default().push(index);
+            } else if let Some(type_name) = type_name {
+                matcher.types.entry(type_name).or_default().push(index);
+            } else if let Some(pseudo_class) = pseudo_class {
+                matcher.pseudo_classes.entry(pseudo_class).or_default().push(index);
+            } else {
+                matcher.universal.push(index);
+            }
+
+            matcher.rules.push(IndexedRule {
+                code,
+                specificity: rule.specificity,
+                ancestor_hashes,
+                ancestor_hash_count,
+            });
+        }
+
+        matcher
+    }
+
+    pub fn rule_count(&self) -> usize {
+        self.rules.len()
+    }
+
+    // Returns the indices of all rules that match the first entry of
+    // `elements`. The remaining entries are the ancestors of that element,
+    // starting with its parent. The last entry is considered the document
+    // root.
+    //
+    // The result is sorted by specificity and then by source order, so
+    // applying the rules in the returned order gives the right cascade.
+    pub fn matching_rules(&self, elements: &[impl Element]) -> Vec<usize> {
+        let atoms: Vec<ElementAtoms> = elements.iter().map(ElementAtoms::new).collect();
+
+        let mut filter = AncestorFilter::new();
+        atoms.iter().skip(1).for_each(|ancestor| filter.push_atoms(ancestor));
+        self.matching_rules_for_atoms(elements, &atoms, &filter)
+    }
+
+    // Like matching_rules(), but uses `filter` instead of building a filter
+    // from the ancestors in `elements`. `filter` needs to contain at least
+    // those ancestors, it may contain more.
+    pub fn matching_rules_with_filter(&self, elements: &[impl Element], filter: &AncestorFilter) -> Vec<usize> {
+        let atoms: Vec<ElementAtoms> = elements.iter().map(ElementAtoms::new).collect();
+        self.matching_rules_for_atoms(elements, &atoms, filter)
+    }
+
+    fn matching_rules_for_atoms(&self, elements: &[impl Element], atoms: &[ElementAtoms], filter: &AncestorFilter) -> Vec<usize> {
+        let Some(element) = atoms.first() else {
+            return Vec::new();
+        };
+
+        let mut candidates: Vec<usize> = Vec::new();
+        let mut add_bucket = |bucket: Option<&Vec<usize>>| {
+            if let Some(bucket) = bucket {
+                candidates.extend_from_slice(bucket);
+            }
+        };
+
+        if let Some(id) = element.id {
+            add_bucket(self.ids.get(&id));
+        }
+        element.classes.iter().for_each(|class| add_bucket(self.classes.get(class)));
+        if let Some(type_name) = element.type_name {
+            add_bucket(self.types.get(&type_name));
+        }
+        element.pseudo_classes.iter().for_each(|pseudo_class| add_bucket(self.pseudo_classes.get(pseudo_class)));
+        add_bucket(Some(&self.universal));
+
+        // Rules are only ever in one bucket, but an element could list the
+        // same class twice.
+        candidates.sort_unstable();
+        candidates.dedup();
+        candidates.retain(|index| {
+            let rule = &self.rules[*index];
+            let code = &self.code[rule.code.start as usize..rule.code.end as usize];
+            filter.might_match(rule) && self.matches_selector(code, elements, atoms)
+        });
+        candidates.sort_by_key(|index| (self.rules[*index].specificity, *index));
+        candidates
+    }
+
+    fn matches_compound(&self, parts: &[Op], element: &impl Element, atoms: &ElementAtoms, is_root: bool) -> bool {
+        parts.iter().all(|part| {
+            match part {
+                Op::AnyElement => true,
+                Op::Type(type_name) => atoms.type_name == Some(*type_name),
+                Op::Class(class) => atoms.classes.contains(class),
+                Op::Id(id) => atoms.id == Some(*id),
+                Op::PseudoClass(pseudo_class) => atoms.pseudo_classes.contains(pseudo_class),
+                Op::Attribute(index) => {
+                    let attribute = &self.attributes[*index as usize];
+                    matches_attribute(element, &attribute.name, attribute.operator, &attribute.value)
+                },
+                Op::DocumentRoot => is_root,
+                _ => false,
+            }
+        })
+    }
+
+    // Match `parts` against `elements`, where the first entry of `elements`
+    // is the element and the remaining entries are its ancestors, closest
+    // first. `atoms` contains the converted names of each entry of
+    // `elements`.
+    fn matches_selector(&self, parts: &[Op], elements: &[impl Element], atoms: &[ElementAtoms]) -> bool {
+        let (Some(element), Some(element_atoms)) = (elements.first(), atoms.first()) else {
+            return false;
+        };
+
+        let is_root = elements.len() == 1;
+        let Some(position) = parts.iter().rposition(|part| part.is_combinator()) else {
+            return self.matches_compound(parts, element, element_atoms, is_root);
+        };
+
+        if !self.matches_compound(&parts[position + 1..], element, element_atoms, is_root) {
+            return false;
+        }
+
+        let remaining = &parts[..position];
+        match parts[position] {
+            Op::ChildCombinator => self.matches_selector(remaining, &elements[1..], &atoms[1..]),
+            _ => (1..elements.len()).any(|index| self.matches_selector(remaining, &elements[index..], &atoms[index..])),
+        }
+    }
+
+    // Compile `part` and append it to the code of this matcher.
+    fn compile_part(&mut self, part: &SelectorPart) {
+        let op = match (part.kind, &part.value) {
+            (SelectorKind::AnyElement, _) => Op::AnyElement,
+            (SelectorKind::Type, _) => Op::Type(part.atom()),
+            (SelectorKind::Class, _) => Op::Class(part.atom()),
+            (SelectorKind::Id, _) => Op::Id(part.atom()),
+            (SelectorKind::PseudoClass, _) => Op::PseudoClass(part.atom()),
+            (SelectorKind::Attribute, SelectorValue::Attribute { name, operator, value }) => {
+                self.attributes.push(AttributeMatch { name: name.clone(), operator: *operator, value: value_str(value).to_string() });
+                Op::Attribute(self.attributes.len() as u32 - 1)
+            },
+            (SelectorKind::DocumentRoot, _) => Op::DocumentRoot,
+            (SelectorKind::DescendantCombinator, _) => Op::DescendantCombinator,
+            (SelectorKind::ChildCombinator, _) => Op::ChildCombinator,
+            _ => Op::Never,
+        };
+        self.code.push(op);
+    }
+}
@@ -1,26 +1,37 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 // SPDX-FileCopyrightText: 2025 Arjen Hiemstra <ahiemstra@heimr.nl>
 
-use crate::property::Property;
-use crate::selector::Selector;
+use std::path::Path;
+
+use crate::property::{Property, PropertyBlock};
+use crate::selector::{Selector, Specificity};
 use crate::value::ValueData;
 
+use crate::details::parsecontext::intern_block;
 use crate::details::rulesparser::ParsedRule;
 use crate::stylesheet::StyleSheet;
 
 #[derive(Clone, Debug, PartialEq)]
 pub struct StyleRule {
     pub selector: Selector,
-    pub properties: Vec<Property>,
+    pub properties: PropertyBlock,
+    // The specificity of `selector`, computed once when the rule is created.
+    pub specificity: Specificity,
+    // The position of this rule in the cascade of the StyleSheet that was
+    // parsed. For a StyleSheet that is not imported by another, this is the
+    // same as the index of the rule in StyleSheet::all_rules().
+    pub source_order: usize,
 }
 
-fn resolve_urls(properties: &Vec<Property>, style_sheet: &StyleSheet) -> Vec<Property> {
-    let mut result = properties.clone();
+// Resolve relative URLs in `properties` against the directory of `path`.
+pub(crate) fn resolve_urls(properties: &[Property], path: &Path) -> Vec<Property> {
+    let mut result = properties.to_vec();
+    let directory = path.parent().unwrap_or(Path::new(""));
 
     for property in &mut result {
         for value in &mut property.values {
             if let ValueData::Url(url) = &mut value.data {
-                *url = style_sheet.path.parent().unwrap().join(url.clone()).to_string_lossy().to_string()
+                *url = directory.join(url.clone()).to_string_lossy().to_string()
             }
         }
     }
@@ -29,29 +40,60 @@ fn resolve_urls(properties: &Vec<Property>, style_sheet: &StyleSheet) -> Vec<Pro
 }
 
 impl StyleRule {
+    pub fn new(selector: Selector, properties: PropertyBlock, source_order: usize) -> StyleRule {
+        let specificity = selector.specificity();
+        StyleRule { selector, properties, specificity, source_order }
+    }
+
+    // Create rules for each selector of `parsed`, including its nested rules.
+    // Nested rules have their selector combined with the selector of their
+    // parent before computing specificity.
+    //
+    // The source order of the returned rules is left at 0, it is assigned by
+    // the StyleSheet once it knows where the rules end up.
     pub fn from_parsed_rule(parsed: &ParsedRule, style_sheet: &StyleSheet) -> Vec<StyleRule> {
         let mut result = Vec::new();
+        StyleRule::flatten(parsed, None, &style_sheet.path, &mut result);
+        result
+    }
+
+    // Like from_parsed_rule(), but appends the rules to `result` and resolves
+    // URLs relative to `path` instead of the path of a StyleSheet.
+    pub(crate) fn from_parsed_rule_into(parsed: &ParsedRule, path: &Path, result: &mut Vec<StyleRule>) {
+        StyleRule::flatten(parsed, None, path, result);
+    }
+
+    // Flatten `parsed` into `result`, combining its selectors with `parent`.
+    //
+    // Nesting is resolved from the outside in: each combined selector is
+    // built once and used as the parent of all nested rules below it, so the
+    // selector of a deeply nested rule is only built for the rules it ends up
+    // in. URLs are resolved once per parsed rule and the resulting block is
+    // shared by all of its selectors, as well as by any other rule with the
+    // same properties that is parsed in the same parse context.
+    //
+    // Since nested selectors always contain a RelativeParent, combining
+    // outside-in gives the same selectors as combining inside-out.
+    fn flatten(parsed: &ParsedRule, parent: Option<&Selector>, path: &Path, result: &mut Vec<StyleRule>) {
+        let properties = intern_block(&PropertyBlock::new(resolve_urls(&parsed.properties, path)));
+        let selectors = parsed.selectors.iter()
+            .filter(|selector| !(selector.parts.is_empty() && parsed.properties.is_empty()));
+
+        for selector in selectors {
+            let selector = match parent {
+                Some(parent) => Selector::combine(selector, parent),
+                None => selector.clone(),
+            };
 
-        for selector in &parsed.selectors {
-            if selector.parts.is_empty() && parsed.properties.is_empty() {
+            if parsed.nested_rules.is_empty() {
+                result.push(StyleRule::new(selector, properties.clone(), 0));
                 continue;
             }
 
-            result.push(StyleRule {
-                selector: selector.clone(),
-                properties: resolve_urls(&parsed.properties, style_sheet),
-            });
-
+            result.push(StyleRule::new(selector.clone(), properties.clone(), 0));
             for nested_rule in &parsed.nested_rules {
-                for nested_result in StyleRule::from_parsed_rule(nested_rule, style_sheet) {
-                    result.push(Self {
-                        selector: Selector::combine(&nested_result.selector, &selector),
-                        properties: nested_result.properties,
-                    });
-                }
+                StyleRule::flatten(nested_rule, Some(&selector), path, result);
             }
         }
-
-        result
     }
 }
@@ -1,17 +1,134 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 // SPDX-FileCopyrightText: 2025 Arjen Hiemstra <ahiemstra@heimr.nl>
 
+use std::collections::{HashMap, HashSet};
 use std::sync::Arc;
+use std::sync::atomic::{AtomicBool, Ordering};
 use std::fs::File;
 use std::io::Read;
-use std::path::PathBuf;
+use std::ops::Range;
+use std::path::{Path, PathBuf};
+use std::thread;
+use std::time::{Duration, Instant};
+
+use memmap2::Mmap;
 
 use crate::details::parse_error_from_cssparser_error;
+use crate::details::cache;
+use crate::details::parsecontext::{check_cancelled, count, count_error, count_input, count_rules, enter_parse_context, intern_block, parse_stopped, take_defined, take_statistics, timed};
+use crate::details::parallel::{parse_chunk, parse_chunks};
+use crate::details::prescan::{scan_imports, split_chunks, Chunk};
 use crate::details::rulesparser::*;
 use crate::parseerror::{ParseError, ParseErrorKind, SourceLocation};
 
-use crate::property::add_property_definition;
+use crate::property::{add_property_definition, Property, PropertyBlock, PropertyDefinition, PropertyRegistry};
+use crate::statistics::{FileStatistics, Phase};
 use crate::stylerule::*;
+use crate::value::{ColorData, ColorResolver, Value, ValueData};
+
+// The smallest chunk parse_string() splits input into for parsing it on
+// multiple threads. Below this, starting a thread costs more than it gains.
+const MIN_CHUNK_SIZE: usize = 16 * 1024;
+
+// Records what a single call to parse_string() or import() added to a
+// StyleSheet, in the order those calls happened. This is used to produce the
+// combined list of rules and errors and allows only retrieving what was added
+// after a certain point.
+#[derive(Debug, Clone, PartialEq)]
+pub(crate) enum Contribution {
+    Import(usize),
+    Parse { rules: Range<usize>, errors: Range<usize> },
+}
+
+// A point in the history of a StyleSheet, see StyleSheet::checkpoint().
+#[derive(Debug, Default, Clone, Copy, PartialEq)]
+pub struct Checkpoint(usize);
+
+impl Checkpoint {
+    pub fn start() -> Checkpoint {
+        Checkpoint(0)
+    }
+}
+
+impl From<usize> for Checkpoint {
+    fn from(value: usize) -> Self {
+        Checkpoint(value)
+    }
+}
+
+impl From<Checkpoint> for usize {
+    fn from(value: Checkpoint) -> Self {
+        value.0
+    }
+}
+
+// The rules that StyleSheet::reload() replaced. `start` is the position of
+// the first of them in all_rules(), `removed` rules were replaced by `added`
+// new ones.
+#[derive(Debug, Default, Clone, Copy, PartialEq)]
+pub struct ReloadedRules {
+    pub start: usize,
+    pub removed: usize,
+    pub added: usize,
+}
+
+// Allows cancelling a parse from another thread. Clones refer to the same
+// state, so cancelling one cancels all of them.
+#[derive(Debug, Default, Clone)]
+pub struct Cancellation(Arc<AtomicBool>);
+
+impl Cancellation {
+    pub fn new() -> Cancellation {
+        Cancellation::default()
+    }
+
+    pub fn cancel(&self) {
+        self.0.store(true, Ordering::Relaxed);
+    }
+
+    pub fn is_cancelled(&self) -> bool {
+        self.0.load(Ordering::Relaxed)
+    }
+}
+
+impl PartialEq for Cancellation {
+    fn eq(&self, other: &Self) -> bool {
+        Arc::ptr_eq(&self.0, &other.0)
+    }
+}
+
+// Options for parsing a StyleSheet.
+//
+// The limits avoid spending a lot of time and memory on untrusted or
+// unexpectedly large input, None means unlimited. They apply to everything a
+// single call to parse() or parse_string() parses, including imported files.
+// When a limit is exceeded, parsing stops and returns an error of kind
+// LimitExceeded. Anything parsed up to that point is kept.
+#[derive(Debug, Default, Clone, PartialEq)]
+pub struct ParseOptions {
+    // The number of errors that are recorded before parsing stops.
+    pub max_errors: Option<usize>,
+    // The number of rules after which parsing stops.
+    pub max_rules: Option<usize>,
+    // The maximum depth of nested rules, where a top-level rule has depth 1.
+    // Rules that are nested deeper are discarded with an error.
+    pub max_nesting_depth: Option<usize>,
+    // The number of bytes of input that are parsed, parsing stops before a
+    // file that would exceed it.
+    pub max_input_size: Option<usize>,
+    // Stop at the first error and return it instead of recording it.
+    pub stop_at_first_error: bool,
+    // When cancelled, parsing stops with an error of kind Cancelled before
+    // the next rule or file.
+    pub cancellation: Option<Cancellation>,
+    // Collect statistics about parsing, see StyleSheet::statistics().
+    pub collect_statistics: bool,
+    // Convert dimensions to canonical units while parsing: absolute lengths
+    // to px, angles to radians and times to milliseconds. Relative units are
+    // kept as they are. This also accepts the absolute lengths and angles
+    // that are otherwise unsupported, like cm and turn.
+    pub canonicalize_units: bool,
+}
 
 #[derive(Debug)]
 pub struct StyleSheet {
@@ -19,30 +136,376 @@ pub struct StyleSheet {
     pub rules: Vec<StyleRule>,
     pub errors: Vec<ParseError>,
     pub imported_sheets: Vec<StyleSheet>,
+    registry: PropertyRegistry,
+    pub(crate) contributions: Vec<Contribution>,
+    pub(crate) defined_properties: Vec<Arc<PropertyDefinition>>,
+    // The source order of the next rule that is added, either by parsing or
+    // by an imported StyleSheet.
+    pub(crate) next_source_order: usize,
+    parallel_imports: bool,
+    parse_threads: usize,
+    options: ParseOptions,
+    // Files read by prefetch_imports(), with their stamp from before they
+    // were read.
+    prefetched: HashMap<PathBuf, (Option<(u64, u64)>, Result<FileContents, ParseError>)>,
+    // The modification time and size of `path` when it was last read, used
+    // to detect modified files. None if it was never read.
+    pub(crate) file_stamp: Option<(u64, u64)>,
+    // Only collected if enabled by ParseOptions::collect_statistics.
+    statistics: Option<FileStatistics>,
+}
+
+fn file_error(path: &Path, error: impl std::fmt::Display) -> ParseError {
+    ParseError{ kind: ParseErrorKind::FileError, message: error.to_string().into(), location: SourceLocation{ file: path.to_string_lossy().to_string(), line: 0, column: 0 } }
+}
+
+// The contents of a file, memory mapped if possible.
+#[derive(Debug)]
+enum FileContents {
+    Mapped(Mmap),
+    Read(String),
+}
+
+impl FileContents {
+    fn as_str(&self, path: &Path) -> Result<&str, ParseError> {
+        match self {
+            FileContents::Mapped(map) => std::str::from_utf8(map).map_err(|error| file_error(path, error)),
+            FileContents::Read(data) => Ok(data.as_str()),
+        }
+    }
+}
+
+fn read_file(path: &Path) -> Result<FileContents, ParseError> {
+    let mut file = File::open(path).map_err(|error| file_error(path, error))?;
+
+    // Empty files cannot be mapped and neither can things like pipes, so only
+    // map non-empty regular files.
+    let mappable = file.metadata().is_ok_and(|metadata| metadata.is_file() && metadata.len() > 0);
+    if mappable {
+        // Safety: The map is only ever read from. If the file is truncated
+        // while mapped, reading it may fault, which is the same trade-off
+        // every mmap based reader makes.
+        if let Ok(map) = unsafe { Mmap::map(&file) } {
+            return Ok(FileContents::Mapped(map));
+        }
+    }
+
+    let mut data = String::new();
+    file.read_to_string(&mut data).map_err(|error| file_error(path, error))?;
+    Ok(FileContents::Read(data))
 }
 
 impl StyleSheet {
+    // Create a StyleSheet that uses the global property registry.
     pub fn new(path: PathBuf) -> StyleSheet {
+        StyleSheet::new_with_registry(path, PropertyRegistry::global())
+    }
+
+    // Create a StyleSheet that looks up and adds property definitions in
+    // `registry` instead of the global registry. Imported StyleSheets use the
+    // same registry.
+    pub fn new_with_registry(path: PathBuf, registry: &PropertyRegistry) -> StyleSheet {
         StyleSheet {
             path,
             rules: Vec::new(),
             errors: Vec::new(),
             imported_sheets: Vec::new(),
+            registry: registry.clone(),
+            contributions: Vec::new(),
+            defined_properties: Vec::new(),
+            next_source_order: 0,
+            parallel_imports: false,
+            parse_threads: 1,
+            options: ParseOptions::default(),
+            prefetched: HashMap::new(),
+            file_stamp: None,
+            statistics: None,
         }
     }
 
+    // When enabled, the files of all top-level @import rules are read
+    // concurrently before parsing. They are still parsed one after the other
+    // in the order they are imported, as later files may depend on
+    // @property definitions from earlier ones. Imported StyleSheets inherit
+    // this setting.
+    pub fn set_parallel_imports(&mut self, enabled: bool) {
+        self.parallel_imports = enabled;
+    }
+
+    // Parse large inputs using up to `threads` threads, or as many as there
+    // are cores if `threads` is 0. The default of 1 parses on the calling
+    // thread only. Imported StyleSheets inherit this setting.
+    //
+    // Input is split into chunks at line breaks between top-level rules,
+    // after the last @import or @property rule. Each chunk is parsed on a
+    // thread of its own and the results are combined in source order, so
+    // they are the same as when parsing on a single thread. Parsing uses a
+    // single thread if max_errors, max_rules or stop_at_first_error are set,
+    // as those depend on the order things are parsed in.
+    pub fn set_parse_threads(&mut self, threads: usize) {
+        self.parse_threads = threads;
+    }
+
+    // Set the limits used when parsing. Imported and reloaded StyleSheets
+    // use the same limits.
+    pub fn set_parse_options(&mut self, options: ParseOptions) {
+        self.options = options;
+    }
+
+    pub fn parse_options(&self) -> &ParseOptions {
+        &self.options
+    }
+
+    pub fn registry(&self) -> &PropertyRegistry {
+        &self.registry
+    }
+
+    // The property definitions that parsing this StyleSheet added to its
+    // registry, excluding those added by imported StyleSheets.
+    pub fn defined_properties(&self) -> &[Arc<PropertyDefinition>] {
+        &self.defined_properties
+    }
+
     pub fn all_rules(&self) -> Vec<StyleRule> {
-        let mut rules: Vec<_> = self.imported_sheets.iter().map(|sheet| sheet.all_rules()).flatten().collect();
-        rules.extend(self.rules.clone());
-        rules
+        self.rules_since(Checkpoint::start())
     }
 
     pub fn all_errors(&self) -> Vec<ParseError> {
-        let mut errors: Vec<_> = self.imported_sheets.iter().map(|sheet| sheet.all_errors()).flatten().collect();
-        errors.extend(self.errors.clone());
+        self.errors_since(Checkpoint::start())
+    }
+
+    // Returns a checkpoint that can be passed to rules_since() and
+    // errors_since() to only retrieve what was added after this point.
+    pub fn checkpoint(&self) -> Checkpoint {
+        Checkpoint(self.contributions.len())
+    }
+
+    pub fn rules_since(&self, checkpoint: Checkpoint) -> Vec<StyleRule> {
+        let mut rules = Vec::new();
+        for contribution in self.contributions.iter().skip(checkpoint.0) {
+            match contribution {
+                Contribution::Import(index) => rules.extend(self.imported_sheets[*index].all_rules()),
+                Contribution::Parse { rules: range, errors: _ } => rules.extend_from_slice(&self.rules[range.clone()]),
+            }
+        }
+        rules
+    }
+
+    // Iterate over the rules of this StyleSheet, including rules from imported
+    // StyleSheets, in the same order as all_rules() without copying them.
+    pub fn all_rules_iter(&self) -> Box<dyn Iterator<Item = &StyleRule> + '_> {
+        Box::new(self.contributions.iter().flat_map(move |contribution| -> Box<dyn Iterator<Item = &StyleRule> + '_> {
+            match contribution {
+                Contribution::Import(index) => self.imported_sheets[*index].all_rules_iter(),
+                Contribution::Parse { rules, errors: _ } => Box::new(self.rules[rules.clone()].iter()),
+            }
+        }))
+    }
+
+    // Iterate over the rules of all_rules() starting at the position `start`.
+    // Imported StyleSheets and parses that only contain rules before `start`
+    // are skipped as a whole, so this is cheaper than calling rule() for
+    // every position.
+    pub fn rules_from(&self, start: usize) -> Box<dyn Iterator<Item = &StyleRule> + '_> {
+        let mut remaining = start;
+        Box::new(self.contributions.iter().flat_map(move |contribution| -> Box<dyn Iterator<Item = &StyleRule> + '_> {
+            match contribution {
+                Contribution::Import(index) => {
+                    let sheet = &self.imported_sheets[*index];
+                    if remaining == 0 {
+                        return sheet.all_rules_iter();
+                    }
+
+                    let count = sheet.rule_count();
+                    if remaining >= count {
+                        remaining -= count;
+                        return Box::new(std::iter::empty());
+                    }
+
+                    let skipped = std::mem::take(&mut remaining);
+                    sheet.rules_from(skipped)
+                },
+                Contribution::Parse { rules, errors: _ } => {
+                    let skipped = remaining.min(rules.len());
+                    remaining -= skipped;
+                    Box::new(self.rules[rules.start + skipped..rules.end].iter())
+                },
+            }
+        }))
+    }
+
+    // The number of rules in this StyleSheet, including rules from imported
+    // StyleSheets. This is the same as all_rules().len() without copying
+    // all rules.
+    pub fn rule_count(&self) -> usize {
+        self.contributions.iter().map(|contribution| match contribution {
+            Contribution::Import(index) => self.imported_sheets[*index].rule_count(),
+            Contribution::Parse { rules, errors: _ } => rules.len(),
+        }).sum()
+    }
+
+    // Returns a reference to the rule at the position `index` would have in
+    // all_rules().
+    pub fn rule(&self, index: usize) -> Option<&StyleRule> {
+        let mut remaining = index;
+        for contribution in &self.contributions {
+            match contribution {
+                Contribution::Import(sheet_index) => {
+                    let sheet = &self.imported_sheets[*sheet_index];
+                    let count = sheet.rule_count();
+                    if remaining < count {
+                        return sheet.rule(remaining);
+                    }
+                    remaining -= count;
+                },
+                Contribution::Parse { rules, errors: _ } => {
+                    if remaining < rules.len() {
+                        return self.rules.get(rules.start + remaining);
+                    }
+                    remaining -= rules.len();
+                },
+            }
+        }
+
+        None
+    }
+
+    // Returns the indices of all_rules() sorted by specificity and then by
+    // source order. Applying rules in this order gives the right cascade, so
+    // resolving the style of something only needs to filter this list
+    // instead of sorting the matching rules.
+    pub fn cascade_order(&self) -> Vec<usize> {
+        let mut keys: Vec<_> = self.all_rules_iter().enumerate().map(|(index, rule)| (rule.specificity, rule.source_order, index)).collect();
+        keys.sort_unstable();
+        keys.into_iter().map(|(_, _, index)| index).collect()
+    }
+
+    // Evaluate all modified colors of this StyleSheet and its imported
+    // StyleSheets, replacing those that only depend on constant colors by
+    // their RGBA result. See ColorResolver for details.
+    pub fn resolve_colors(&mut self) {
+        self.resolve_colors_with(&mut ColorResolver::new());
+    }
+
+    // Returns the source and arguments of every distinct custom color that is
+    // used by this StyleSheet or its imported StyleSheets, in the order they
+    // are first used. This includes custom colors that modified colors are
+    // derived from.
+    pub fn custom_colors(&self) -> Vec<(String, Vec<String>)> {
+        let mut seen = HashSet::new();
+        let mut result = Vec::new();
+
+        let values = self.all_rules_iter()
+            .flat_map(|rule| rule.properties.iter())
+            .flat_map(|property| property.values.iter());
+        for value in values {
+            if let ValueData::Color(color) = &value.data {
+                color.visit_custom_colors(&mut |source, arguments| {
+                    if seen.insert((source, arguments)) {
+                        result.push((source.to_string(), arguments.to_vec()));
+                    }
+                });
+            }
+        }
+
+        result
+    }
+
+    fn resolve_colors_with(&mut self, resolver: &mut ColorResolver) {
+        for sheet in &mut self.imported_sheets {
+            sheet.resolve_colors_with(resolver);
+        }
+
+        let is_modified = |value: &Value| matches!(&value.data, ValueData::Color(color) if matches!(color.data, ColorData::Modified { .. }));
+
+        // Blocks are shared by many rules, so each one is only resolved once.
+        // The original block is kept alongside the result so its address is
+        // not reused while it is used as key.
+        let mut resolved: HashMap<*const Property, (PropertyBlock, PropertyBlock)> = HashMap::new();
+        for rule in &mut self.rules {
+            if !rule.properties.iter().flat_map(|property| property.values.iter()).any(is_modified) {
+                continue;
+            }
+
+            let (_, block) = resolved.entry(rule.properties.as_ptr()).or_insert_with(|| {
+                let mut properties = rule.properties.to_vec();
+                for value in properties.iter_mut().flat_map(|property| property.values.iter_mut()) {
+                    if let ValueData::Color(color) = &mut value.data {
+                        if matches!(color.data, ColorData::Modified { .. }) {
+                            *color = resolver.resolve(color);
+                        }
+                    }
+                }
+                (rule.properties.clone(), PropertyBlock::new(properties))
+            });
+            rule.properties = block.clone();
+        }
+    }
+
+    pub fn errors_since(&self, checkpoint: Checkpoint) -> Vec<ParseError> {
+        self.errors_between(checkpoint, self.checkpoint())
+    }
+
+    // The errors that were added after `start` but before `end`.
+    pub fn errors_between(&self, start: Checkpoint, end: Checkpoint) -> Vec<ParseError> {
+        let mut errors = Vec::new();
+        for contribution in self.contributions.iter().take(end.0).skip(start.0) {
+            match contribution {
+                Contribution::Import(index) => errors.extend(self.imported_sheets[*index].all_errors()),
+                Contribution::Parse { rules: _, errors: range } => errors.extend_from_slice(&self.errors[range.clone()]),
+            }
+        }
         errors
     }
 
+    // The number of errors that were added after `checkpoint`. This is the
+    // same as errors_since().len() without copying the errors.
+    pub fn error_count_since(&self, checkpoint: Checkpoint) -> usize {
+        self.contributions.iter().skip(checkpoint.0).map(|contribution| match contribution {
+            Contribution::Import(index) => self.imported_sheets[*index].error_count_since(Checkpoint::start()),
+            Contribution::Parse { rules: _, errors } => errors.len(),
+        }).sum()
+    }
+
+    // An empty StyleSheet for the same file, with the same settings and
+    // registry as this one. It can be parsed without access to this
+    // StyleSheet and then be added to it using append().
+    pub fn empty_copy(&self) -> StyleSheet {
+        self.child_sheet(self.path.clone())
+    }
+
+    // Add everything that was parsed into `other` after what this StyleSheet
+    // contains, as if this StyleSheet parsed it. `other` should be created
+    // by empty_copy(). Its rules get the source orders that follow the rules
+    // of this StyleSheet.
+    pub fn append(&mut self, mut other: StyleSheet) {
+        other.renumber_source_order(self.next_source_order);
+
+        let rules_start = self.rules.len();
+        let errors_start = self.errors.len();
+        let imports_start = self.imported_sheets.len();
+        self.contributions.extend(other.contributions.iter().map(|contribution| match contribution {
+            Contribution::Import(index) => Contribution::Import(imports_start + index),
+            Contribution::Parse { rules, errors } => Contribution::Parse {
+                rules: rules_start + rules.start..rules_start + rules.end,
+                errors: errors_start + errors.start..errors_start + errors.end,
+            },
+        }));
+
+        self.rules.append(&mut other.rules);
+        self.errors.append(&mut other.errors);
+        self.imported_sheets.append(&mut other.imported_sheets);
+        self.defined_properties.append(&mut other.defined_properties);
+        self.next_source_order = other.next_source_order;
+
+        if other.file_stamp.is_some() {
+            self.file_stamp = other.file_stamp;
+        }
+        if let Some(statistics) = &other.statistics {
+            self.statistics_mut().merge(statistics);
+        }
+    }
+
     pub fn all_paths(&self) -> Vec<PathBuf> {
         let mut paths: Vec<_> = self.imported_sheets.iter().map(|sheet| sheet.all_paths()).flatten().collect();
         paths.push(self.path.clone());
@@ -50,43 +513,178 @@ impl StyleSheet {
     }
 
     pub fn parse(&mut self) -> Result<(), ParseError> {
-        let file = File::open(&self.path);
-        if let Err(error) = file {
-            return Err(ParseError{ kind: ParseErrorKind::FileError, message: format!("{}", error), location: SourceLocation{ file: self.path.to_string_lossy().to_string(), line: 0, column: 0 } });
+        self.parse_into(None)
+    }
+
+    // Parse this StyleSheet and pass every rule to `visitor` as soon as it
+    // is parsed, instead of storing it. This includes the rules of imported
+    // files. Errors, imported paths and property definitions are still
+    // recorded, so only the rules are missing from this StyleSheet afterwards.
+    pub fn parse_with_visitor(&mut self, visitor: &mut dyn FnMut(&StyleRule)) -> Result<(), ParseError> {
+        self.parse_into(Some(visitor))
+    }
+
+    fn parse_into(&mut self, visitor: Option<&mut dyn FnMut(&StyleRule)>) -> Result<(), ParseError> {
+        let start = self.options.collect_statistics.then(Instant::now);
+
+        // Stat before reading, so a change while reading is detected later.
+        self.file_stamp = cache::file_stamp(&self.path);
+        let contents = read_file(&self.path)?;
+
+        if let Some(start) = start {
+            self.statistics_mut().read += start.elapsed();
         }
 
-        let mut data = String::new();
-        let result = file.unwrap().read_to_string(&mut data);
-        if let Err(error) = result {
-            return Err(ParseError{ kind: ParseErrorKind::FileError, message: format!("{}", error), location: SourceLocation{ file: self.path.to_string_lossy().to_string(), line: 0, column: 0 } });
+        self.parse_string_into(contents.as_str(&self.path)?, visitor)
+    }
+
+    // Statistics about parsing this StyleSheet, with one entry for every file
+    // in the same order as all_paths(). Empty unless statistics were enabled
+    // using ParseOptions::collect_statistics.
+    pub fn statistics(&self) -> Vec<FileStatistics> {
+        let mut result: Vec<_> = self.imported_sheets.iter().flat_map(|sheet| sheet.statistics()).collect();
+        result.extend(self.statistics.clone());
+        result
+    }
+
+    fn statistics_mut(&mut self) -> &mut FileStatistics {
+        self.statistics.get_or_insert_with(|| FileStatistics::new(self.path.clone()))
+    }
+
+    // Parse this StyleSheet, using a cached copy of the parse result stored in
+    // `cache_dir` if none of the files that make up this StyleSheet changed
+    // since they were read for the cache and the registry contains the same
+    // definitions. Otherwise this behaves like parse() and writes a new cache
+    // file afterwards.
+    //
+    // The cache is only used for StyleSheets that have not parsed anything
+    // yet.
+    pub fn parse_cached(&mut self, cache_dir: &Path) -> Result<(), ParseError> {
+        if !self.contributions.is_empty() {
+            return self.parse();
+        }
+
+        let cache_path = cache::cache_file_path(&self.path, cache_dir);
+        if let Some(sheet) = cache::load(&cache_path, &self.path, &self.registry, &self.options) {
+            self.rules = sheet.rules;
+            self.errors = sheet.errors;
+            self.imported_sheets = sheet.imported_sheets;
+            self.contributions = sheet.contributions;
+            self.defined_properties = sheet.defined_properties;
+            self.next_source_order = sheet.next_source_order;
+            self.file_stamp = sheet.file_stamp;
+            return Ok(());
         }
 
-        self.parse_string(data.as_str())
+        self.parse()?;
+
+        // Failing to write the cache only means the next parse will be slow
+        // as well.
+        let _ = cache::store(&cache_path, self);
+        Ok(())
     }
 
     pub fn parse_string(&mut self, input: &str) -> Result<(), ParseError> {
-        let prefix_input = format!("/*# sourceURL={} */\n{}", self.path.to_string_lossy().to_string(), input);
-        let mut parser_input = cssparser::ParserInput::new(prefix_input.as_str());
+        self.parse_string_into(input, None)
+    }
+
+    // Parse `input` and pass every rule to `visitor` as soon as it is parsed,
+    // see parse_with_visitor().
+    pub fn parse_string_with_visitor(&mut self, input: &str, visitor: &mut dyn FnMut(&StyleRule)) -> Result<(), ParseError> {
+        self.parse_string_into(input, Some(visitor))
+    }
+
+    fn parse_string_into(&mut self, input: &str, mut visitor: Option<&mut dyn FnMut(&StyleRule)>) -> Result<(), ParseError> {
+        let _context = enter_parse_context(&self.registry, &self.path.to_string_lossy(), &self.options);
+        let start = self.options.collect_statistics.then(Instant::now);
+        // Time spent on imported files, which is not part of the time spent
+        // parsing this one.
+        let mut import_time = Duration::ZERO;
+
+        if let Some(error) = count_input(input.len()) {
+            return Err(error);
+        }
+        count(|statistics| statistics.bytes += input.len());
+
+        if self.parallel_imports {
+            self.prefetch_imports(input);
+        }
+
+        // Everything in front of the chunks that are parsed in parallel is
+        // parsed here, which is all of the input if it is not split.
+        let chunks = self.parallel_chunks(input);
+        let serial_end = chunks.first().map_or(input.len(), |chunk| chunk.range.end);
+
+        // Lines are reported starting at 1.
+        let mut parser_input = cssparser::ParserInput::new_with_line_number_offset(&input[..serial_end], 1);
         let mut parser = cssparser::Parser::new(&mut parser_input);
         let mut rules_parser = TopLevelParser{};
-        let style_sheet_parser = cssparser::StyleSheetParser::new(&mut parser, &mut rules_parser);
+        let mut style_sheet_parser = cssparser::StyleSheetParser::new(&mut parser, &mut rules_parser);
 
+        // The rules and errors parsed since the last @import. They are added
+        // to this StyleSheet at the next @import or once parsing is done.
         let mut rules: Vec<StyleRule> = Vec::new();
         let mut errors: Vec<ParseError> = Vec::new();
-        for entry in style_sheet_parser {
+        let rules_start = self.rules.len();
+        let errors_start = self.errors.len();
+        let contributions_start = self.contributions.len();
+        let source_order_start = self.next_source_order.saturating_sub(self.rule_count());
+        // The error that exceeded one of the limits of the parse options.
+        let mut stopped: Option<ParseError> = None;
+        // The error of an import that failed, the rules of this parse are
+        // discarded in that case.
+        let mut failed: Option<ParseError> = None;
+        while let Some(entry) = style_sheet_parser.next() {
+            if let Some(error) = check_cancelled() {
+                stopped = Some(error);
+                break;
+            }
+
             match entry {
                 Ok(entry_contents) => {
                     match entry_contents {
                         ParseResult::Rule(rule) => {
-                            let mut parsed_rules = StyleRule::from_parsed_rule(&rule, self);
-                            rules.append(&mut parsed_rules);
+                            let mut parsed_rules = timed(Phase::Flatten, || StyleRule::from_parsed_rule(&rule, self));
+                            count(|statistics| statistics.rules += parsed_rules.len());
+
+                            let location = SourceLocation::from_file_location(self.path.to_string_lossy().to_string(), style_sheet_parser.input.current_source_location());
+                            if let Some(error) = count_rules(parsed_rules.len(), &location) {
+                                stopped = Some(error);
+                                break;
+                            }
+
+                            self.assign_source_order(&mut parsed_rules);
+                            match visitor.as_mut() {
+                                Some(visitor) => parsed_rules.iter().for_each(|rule| visitor(rule)),
+                                None => rules.append(&mut parsed_rules),
+                            }
                         },
                         ParseResult::PropertyDefinition(definition) => {
                             let arc = Arc::new(definition);
                             add_property_definition(&arc);
                         },
                         ParseResult::Import(name) => {
-                            self.import(PathBuf::from(name))?
+                            // The imported rules follow what was parsed so
+                            // far, like they do when visiting the rules.
+                            self.push_parse(&mut rules, &mut errors);
+
+                            // Reborrowing through a cast shortens the lifetime of
+                            // the visitor, so it can still be used afterwards.
+                            let visitor = visitor.as_mut().map(|visitor| &mut **visitor as &mut dyn FnMut(&StyleRule));
+                            let import_start = start.map(|_| Instant::now());
+                            let result = self.import_into(PathBuf::from(name), visitor);
+                            if let Some(import_start) = import_start {
+                                import_time += import_start.elapsed();
+                            }
+
+                            if let Err(error) = result {
+                                if parse_stopped() {
+                                    stopped = Some(error);
+                                } else {
+                                    failed = Some(error);
+                                }
+                                break;
+                            }
                         }
                         ParseResult::Property(_) => {
                             panic!("Received property at toplevel!");
@@ -94,24 +692,396 @@ impl StyleSheet {
                     }
                 }
                 Err(error) => {
-                    errors.push(parse_error_from_cssparser_error(&error.0, self.path.to_string_lossy().to_string()));
+                    let error = parse_error_from_cssparser_error(&error.0, self.path.to_string_lossy().to_string());
+                    if let Some(error) = count_error(&error) {
+                        stopped = Some(error);
+                        break;
+                    }
+                    errors.push(error);
                 }
             }
         }
 
-        self.rules.extend(rules);
-        self.errors.extend(errors);
+        if stopped.is_none() && failed.is_none() && chunks.len() > 1 {
+            stopped = self.parse_chunks_into(input, &chunks[1..], &mut visitor, &mut rules, &mut errors);
+        }
 
-        Ok(())
+        // Anything left was not actually imported, for example because the
+        // @import rule turned out to be invalid.
+        self.prefetched.clear();
+
+        if let Some(error) = failed {
+            // Imports before the failed one are kept, but nothing this parse
+            // added itself.
+            self.rules.truncate(rules_start);
+            self.errors.truncate(errors_start);
+            let imports: Vec<_> = self.contributions.drain(contributions_start..).filter(|contribution| matches!(contribution, Contribution::Import(_))).collect();
+            self.contributions.extend(imports);
+            self.renumber_source_order(source_order_start);
+
+            // The definitions stay in the registry, so they are recorded
+            // even though the rules are not kept.
+            self.defined_properties.extend(take_defined());
+            return Err(error);
+        }
+
+        self.push_parse(&mut rules, &mut errors);
+
+        self.defined_properties.extend(take_defined());
+
+        if let (Some(start), Some(mut statistics)) = (start, take_statistics()) {
+            statistics.parse = start.elapsed().saturating_sub(import_time);
+            self.statistics_mut().merge(&statistics);
+        }
+
+        match stopped {
+            Some(error) => Err(error),
+            None => Ok(()),
+        }
     }
 
     pub fn import(&mut self, file: PathBuf) -> Result<(), ParseError> {
-        let path = if file.is_absolute() { file.clone() } else { self.path.parent().unwrap().join(file.clone()) };
-        let mut sheet = StyleSheet::new(path);
-        sheet.parse()?;
+        // Imported files share the limits of this StyleSheet.
+        let _context = enter_parse_context(&self.registry, &self.path.to_string_lossy(), &self.options);
+        self.import_into(file, None)
+    }
+
+    fn import_into(&mut self, file: PathBuf, visitor: Option<&mut dyn FnMut(&StyleRule)>) -> Result<(), ParseError> {
+        let path = self.import_path(file);
+        let mut sheet = self.child_sheet(path.clone());
+        sheet.next_source_order = self.next_source_order;
+
+        let result = match self.prefetched.remove(&path) {
+            Some((stamp, contents)) => {
+                sheet.file_stamp = stamp;
+                let contents = contents?;
+                sheet.parse_string_into(contents.as_str(&path)?, visitor)
+            },
+            None => sheet.parse_into(visitor),
+        };
 
+        // When the parse stopped because of a limit, what the imported file
+        // parsed up to that point is kept.
+        if result.is_err() && !parse_stopped() {
+            return result;
+        }
+
+        self.next_source_order = sheet.next_source_order;
         self.imported_sheets.push(sheet);
+        self.contributions.push(Contribution::Import(self.imported_sheets.len() - 1));
 
-        Ok(())
+        result
+    }
+
+    // The paths of the files that make up this StyleSheet that were modified
+    // since they were read, in the same order as all_paths().
+    pub fn all_modified_paths(&self) -> Vec<PathBuf> {
+        let mut paths: Vec<_> = self.imported_sheets.iter().map(|sheet| sheet.all_modified_paths()).flatten().collect();
+        if self.file_stamp.is_some() && cache::file_stamp(&self.path) != self.file_stamp {
+            paths.push(self.path.clone());
+        }
+        paths
+    }
+
+    // Parse the file at `path` again and replace the rules it contributed to
+    // this StyleSheet with the result. This includes the rules of anything
+    // it imports. The rules of all other files are kept as they are.
+    //
+    // If `path` is the path of this StyleSheet, everything is parsed again.
+    // Rules that were added by parse_string() are lost in that case.
+    //
+    // Returns the rules that were replaced, one entry for every time `path`
+    // is imported, or an empty list if `path` is not part of this
+    // StyleSheet. If parsing fails, this StyleSheet and its registry are left
+    // unchanged. Otherwise the property definitions of the file replace the
+    // ones that were read from it before.
+    pub fn reload(&mut self, path: &Path) -> Result<Vec<ReloadedRules>, ParseError> {
+        if path == self.path {
+            let removed = self.rule_count();
+            let mut sheets = self.parse_replacements(path, &[&*self])?;
+
+            *self = sheets.pop().unwrap();
+            return Ok(vec![ReloadedRules { start: 0, removed, added: self.rule_count() }]);
+        }
+
+        let mut imports = Vec::new();
+        self.find_imports(path, &mut imports);
+        if imports.is_empty() {
+            return Ok(Vec::new());
+        }
+
+        // Everything is parsed before anything is replaced, so a failure for
+        // any of the imports leaves this StyleSheet as it was.
+        let sheets = self.parse_replacements(path, &imports)?;
+
+        let mut reloaded = Vec::new();
+        self.replace_imports(path, 0, &mut sheets.into_iter(), &mut reloaded);
+        self.renumber_source_order(0);
+        Ok(reloaded)
+    }
+
+    // Reload all files returned by all_modified_paths().
+    pub fn reload_modified(&mut self) -> Result<Vec<ReloadedRules>, ParseError> {
+        let mut reloaded = Vec::new();
+
+        // Paths are ordered so that importing files come after the files they
+        // import. Reloading the last one first means files imported by it are
+        // reloaded along with it and no longer reported as modified.
+        for _ in 0..self.all_paths().len() {
+            let Some(path) = self.all_modified_paths().pop() else {
+                break;
+            };
+            reloaded.extend(self.reload(&path)?);
+        }
+
+        Ok(reloaded)
+    }
+
+    // The imported StyleSheets for `path` that reload() replaces, in the
+    // order they contribute rules.
+    fn find_imports<'a>(&'a self, path: &Path, imports: &mut Vec<&'a StyleSheet>) {
+        for contribution in &self.contributions {
+            if let Contribution::Import(index) = contribution {
+                let sheet = &self.imported_sheets[*index];
+                if sheet.path == path {
+                    imports.push(sheet);
+                } else {
+                    sheet.find_imports(path, imports);
+                }
+            }
+        }
+    }
+
+    // Parse `path` again for every StyleSheet in `previous`.
+    //
+    // The definitions of `previous` are removed from the registry first, so
+    // definitions that were changed or removed in the file take effect. New
+    // definitions are collected in a separate registry and only added to the
+    // registry of this StyleSheet once everything was parsed. If parsing
+    // fails, the registry is left as it was.
+    fn parse_replacements(&self, path: &Path, previous: &[&StyleSheet]) -> Result<Vec<StyleSheet>, ParseError> {
+        let replaced: Vec<_> = previous.iter().map(|sheet| sheet.all_defined_properties()).flatten().collect();
+        replaced.iter().for_each(|definition| self.registry.remove(definition));
+
+        let staging = PropertyRegistry::new_with_parent(&self.registry);
+        let mut sheets = Vec::new();
+        for _ in previous {
+            let mut sheet = self.child_sheet(path.to_path_buf());
+            sheet.registry = staging.clone();
+
+            if let Err(error) = sheet.parse() {
+                replaced.iter().for_each(|definition| { self.registry.add(definition); });
+                return Err(error);
+            }
+            sheets.push(sheet);
+        }
+
+        staging.own_definitions().iter().for_each(|definition| { self.registry.add(definition); });
+        sheets.iter_mut().for_each(|sheet| sheet.set_registry(&self.registry));
+        Ok(sheets)
+    }
+
+    // Replace every imported StyleSheet for `path` with the next entry of
+    // `sheets`. `start` is the position of the first rule of this StyleSheet
+    // in all_rules() of the StyleSheet that reload() was called on. Returns
+    // the position after the last rule of this StyleSheet.
+    fn replace_imports(&mut self, path: &Path, start: usize, sheets: &mut impl Iterator<Item = StyleSheet>, reloaded: &mut Vec<ReloadedRules>) -> usize {
+        let mut position = start;
+        for contribution in &self.contributions {
+            match contribution {
+                Contribution::Import(index) => {
+                    let sheet = &mut self.imported_sheets[*index];
+                    if sheet.path == path {
+                        let Some(new_sheet) = sheets.next() else {
+                            break;
+                        };
+
+                        reloaded.push(ReloadedRules { start: position, removed: sheet.rule_count(), added: new_sheet.rule_count() });
+                        *sheet = new_sheet;
+                        position += sheet.rule_count();
+                    } else {
+                        position = sheet.replace_imports(path, position, sheets, reloaded);
+                    }
+                },
+                Contribution::Parse { rules, errors: _ } => position += rules.len(),
+            }
+        }
+        position
+    }
+
+    // The property definitions added by parsing this StyleSheet and the
+    // StyleSheets it imports.
+    fn all_defined_properties(&self) -> Vec<Arc<PropertyDefinition>> {
+        let mut definitions: Vec<_> = self.imported_sheets.iter().map(|sheet| sheet.all_defined_properties()).flatten().collect();
+        definitions.extend(self.defined_properties.iter().cloned());
+        definitions
+    }
+
+    fn set_registry(&mut self, registry: &PropertyRegistry) {
+        self.registry = registry.clone();
+        self.imported_sheets.iter_mut().for_each(|sheet| sheet.set_registry(registry));
+    }
+
+    // Give `rules` the next source orders. Rules are numbered in the order
+    // they appear in, including the rules of imported files, whether they
+    // are kept or passed to a visitor.
+    fn assign_source_order(&mut self, rules: &mut [StyleRule]) {
+        for rule in rules {
+            rule.source_order = self.next_source_order;
+            self.next_source_order += 1;
+        }
+    }
+
+    // Add `rules` and `errors` to this StyleSheet, after everything that was
+    // added to it before.
+    fn push_parse(&mut self, rules: &mut Vec<StyleRule>, errors: &mut Vec<ParseError>) {
+        let rules_range = self.rules.len()..self.rules.len() + rules.len();
+        let errors_range = self.errors.len()..self.errors.len() + errors.len();
+        self.rules.append(rules);
+        self.errors.append(errors);
+
+        if !rules_range.is_empty() || !errors_range.is_empty() {
+            self.contributions.push(Contribution::Parse { rules: rules_range, errors: errors_range });
+        }
+    }
+
+    // Assign new source orders to all rules, starting at `next`, after the
+    // number of rules of an imported StyleSheet changed. Returns the source
+    // order of the next rule added after this StyleSheet.
+    fn renumber_source_order(&mut self, mut next: usize) -> usize {
+        for contribution in &self.contributions {
+            match contribution {
+                Contribution::Import(index) => next = self.imported_sheets[*index].renumber_source_order(next),
+                Contribution::Parse { rules, errors: _ } => {
+                    for rule in &mut self.rules[rules.clone()] {
+                        rule.source_order = next;
+                        next += 1;
+                    }
+                },
+            }
+        }
+
+        self.next_source_order = next;
+        next
+    }
+
+    // The chunks to split `input` into for parsing it on multiple threads, see
+    // set_parse_threads(). The first chunk is parsed on this thread before
+    // the others. Empty if all of `input` should be parsed on this thread.
+    fn parallel_chunks(&self, input: &str) -> Vec<Chunk> {
+        let threads = match self.parse_threads {
+            0 => thread::available_parallelism().map_or(1, |count| count.get()),
+            threads => threads,
+        };
+
+        let options = &self.options;
+        if threads < 2 || input.len() < 2 * MIN_CHUNK_SIZE || options.max_errors.is_some() || options.max_rules.is_some() || options.stop_at_first_error {
+            return Vec::new();
+        }
+
+        let chunks = split_chunks(input, threads, MIN_CHUNK_SIZE);
+        if chunks.len() < 3 {
+            return Vec::new();
+        }
+        chunks
+    }
+
+    // Parse `chunks` of `input` in parallel and add their results in order.
+    // Returns the error parsing stopped with, if it was cancelled.
+    //
+    // A chunk that looked up a property which a chunk in front of it defined
+    // would have found that definition when parsed after it, so such a chunk
+    // is parsed again on this thread once the definitions in front of it are
+    // in the registry.
+    fn parse_chunks_into(&mut self, input: &str, chunks: &[Chunk], visitor: &mut Option<&mut dyn FnMut(&StyleRule)>, rules: &mut Vec<StyleRule>, errors: &mut Vec<ParseError>) -> Option<ParseError> {
+        let results = parse_chunks(input, chunks, &self.path, &self.registry, &self.options);
+
+        // The names of the properties defined by the chunks added so far.
+        let mut defined: HashSet<String> = HashSet::new();
+        for (chunk, result) in chunks.iter().zip(results) {
+            let depends = result.missed.iter()
+                .chain(result.defined.iter().map(|definition| &definition.name))
+                .any(|name| defined.contains(name));
+
+            let result = if depends {
+                let result = parse_chunk(input, chunk, &self.path);
+                let added = take_defined();
+                defined.extend(added.iter().map(|definition| definition.name.clone()));
+                self.defined_properties.extend(added);
+                result
+            } else {
+                for definition in &result.defined {
+                    add_property_definition(definition);
+                    defined.insert(definition.name.clone());
+                }
+                if let Some(statistics) = &result.statistics {
+                    count(|current| current.merge(statistics));
+                }
+                result
+            };
+
+            errors.extend(result.errors);
+
+            // Every thread shares blocks only within its own chunk.
+            let mut chunk_rules = result.rules;
+            for rule in &mut chunk_rules {
+                rule.properties = intern_block(&rule.properties);
+            }
+
+            self.assign_source_order(&mut chunk_rules);
+            match visitor.as_mut() {
+                Some(visitor) => chunk_rules.iter().for_each(|rule| visitor(rule)),
+                None => rules.extend(chunk_rules),
+            }
+
+            if result.stopped.is_some() {
+                return result.stopped;
+            }
+        }
+
+        None
+    }
+
+    // An empty StyleSheet for `path` with the same settings as this one.
+    fn child_sheet(&self, path: PathBuf) -> StyleSheet {
+        let mut sheet = StyleSheet::new_with_registry(path, &self.registry);
+        sheet.parallel_imports = self.parallel_imports;
+        sheet.parse_threads = self.parse_threads;
+        sheet.options = self.options.clone();
+        sheet
+    }
+
+    fn import_path(&self, file: PathBuf) -> PathBuf {
+        if file.is_absolute() { file } else { self.path.parent().unwrap().join(file) }
+    }
+
+    // Read the files imported by `input` on separate threads, so import() can
+    // use their contents without waiting for the file to be read.
+    fn prefetch_imports(&mut self, input: &str) {
+        let paths: Vec<PathBuf> = scan_imports(input).into_iter()
+            .map(|file| self.import_path(PathBuf::from(file)))
+            .filter(|path| !self.prefetched.contains_key(path))
+            .collect();
+
+        // Reading a single file on another thread gains nothing.
+        if paths.len() < 2 {
+            return;
+        }
+
+        let results: Vec<_> = thread::scope(|scope| {
+            let handles: Vec<_> = paths.iter().map(|path| {
+                // Stat before reading, the same as parse().
+                scope.spawn(move || (cache::file_stamp(path), read_file(path)))
+            }).collect();
+            handles.into_iter().map(|handle| handle.join()).collect()
+        });
+
+        for (path, result) in paths.into_iter().zip(results) {
+            // If a thread failed for some reason, import() falls back to
+            // reading the file itself.
+            if let Ok(data) = result {
+                self.prefetched.insert(path, data);
+            }
+        }
     }
 }
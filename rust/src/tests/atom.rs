@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+use crate::atom::Atom;
+
+#[test]
+fn intern() {
+    let first = Atom::new("background-color");
+    let second = Atom::from(String::from("background-color"));
+    assert_eq!(first, second);
+    assert_eq!(first.id(), second.id());
+    assert_eq!(first.as_str(), "background-color");
+    assert_eq!(first, "background-color");
+
+    let other = Atom::new("border-color");
+    assert_ne!(first, other);
+    assert_eq!(Atom::from_id(other.id()), Some(other));
+}
+
+#[test]
+fn empty() {
+    assert!(Atom::default().is_empty());
+    assert_eq!(Atom::new(""), Atom::default());
+    assert_eq!(Atom::default().as_str(), "");
+}
+
+#[test]
+fn lookup() {
+    assert_eq!(Atom::lookup("atom-lookup-never-interned"), None);
+
+    let atom = Atom::new("atom-lookup-interned");
+    assert_eq!(Atom::lookup("atom-lookup-interned"), Some(atom));
+}
+
+#[test]
+fn many_threads() {
+    // Enough atoms to fill more than one chunk of the table, created and read
+    // from several threads at once.
+    let threads: Vec<_> = (0..4).map(|thread| std::thread::spawn(move || {
+        let atoms: Vec<_> = (0..1000).map(|index| (index, Atom::new(&format!("atom-thread-{}", (index + thread * 250) % 1000)))).collect();
+        for (index, atom) in atoms {
+            assert_eq!(atom.as_str(), format!("atom-thread-{}", (index + thread * 250) % 1000));
+            assert_eq!(Atom::from_id(atom.id()), Some(atom));
+        }
+    })).collect();
+
+    for thread in threads {
+        thread.join().unwrap();
+    }
+
+    assert_eq!(Atom::from_id(u32::MAX), None);
+}
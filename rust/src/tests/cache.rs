@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+use std::path::PathBuf;
+use std::sync::Arc;
+
+use crate::details::cache::{load, store};
+use crate::property::{PropertyDefinition, PropertyRegistry};
+use crate::stylesheet::{ParseOptions, StyleSheet};
+
+#[test]
+fn rejected_cache() {
+    let path = PathBuf::from(concat!(env!("CARGO_MANIFEST_DIR"), "/tests/data/import.css"));
+    let cache_path = std::env::temp_dir().join(format!("cxx-rust-cssparser-rejected-{}.csscache", std::process::id()));
+
+    let mut sheet = StyleSheet::new_with_registry(path.clone(), &PropertyRegistry::new());
+    assert!(sheet.parse().is_ok());
+    store(&cache_path, &sheet).unwrap();
+
+    // A cache that is rejected after decoding it does not add anything to
+    // the registry.
+    let registry = PropertyRegistry::new();
+    assert!(load(&cache_path, &path.with_file_name("other.css"), &registry, &ParseOptions::default()).is_none());
+    assert!(registry.get("width").is_none());
+
+    // Options that change the result of parsing are part of the cache.
+    let options = ParseOptions { max_nesting_depth: Some(1), ..Default::default() };
+    assert!(load(&cache_path, &path, &registry, &options).is_none());
+    let options = ParseOptions { collect_statistics: true, ..Default::default() };
+    assert!(load(&cache_path, &path, &registry, &options).is_some());
+    assert!(registry.get("width").is_some());
+
+    std::fs::remove_file(&cache_path).unwrap();
+}
+
+#[test]
+fn cache_key() {
+    let path = PathBuf::from(concat!(env!("CARGO_MANIFEST_DIR"), "/tests/data/import.css"));
+    let cache_path = std::env::temp_dir().join(format!("cxx-rust-cssparser-key-{}.csscache", std::process::id()));
+
+    // A StyleSheet that was not read from a file is not stored.
+    let mut sheet = StyleSheet::new_with_registry(path.clone(), &PropertyRegistry::new());
+    assert!(sheet.parse_string("a { width: 1px; }").is_ok());
+    assert!(store(&cache_path, &sheet).is_err());
+    assert!(!cache_path.exists());
+
+    // The stamps taken when reading are stored, not those of the files when
+    // the cache is written.
+    let mut sheet = StyleSheet::new_with_registry(path.clone(), &PropertyRegistry::new());
+    assert!(sheet.parse().is_ok());
+    let stamp = sheet.file_stamp;
+    sheet.file_stamp = Some((0, 0));
+    store(&cache_path, &sheet).unwrap();
+    assert!(load(&cache_path, &path, &PropertyRegistry::new(), &ParseOptions::default()).is_none());
+
+    sheet.file_stamp = stamp;
+    store(&cache_path, &sheet).unwrap();
+    let loaded = load(&cache_path, &path, &PropertyRegistry::new(), &ParseOptions::default()).unwrap();
+    assert_eq!(loaded.file_stamp, stamp);
+
+    // Definitions in the registry that were not added by the StyleSheet are
+    // part of the cache.
+    let registry = PropertyRegistry::new();
+    let definition = PropertyDefinition::from_name_syntax("--extra", "<length>", "", 0, 0).unwrap();
+    registry.add(&Arc::new(definition));
+    assert!(load(&cache_path, &path, &registry, &ParseOptions::default()).is_none());
+
+    // Loading the cache again into the same registry still matches.
+    let registry = PropertyRegistry::new();
+    assert!(load(&cache_path, &path, &registry, &ParseOptions::default()).is_some());
+    assert!(load(&cache_path, &path, &registry, &ParseOptions::default()).is_some());
+
+    std::fs::remove_file(&cache_path).unwrap();
+}
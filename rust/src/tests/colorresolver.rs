@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+use crate::value::{Color, ColorOperation, ColorResolver};
+
+fn check_resolve(input: Color, expected: Color) {
+    assert_eq!(input.resolve(), expected);
+}
+
+fn black() -> Color {
+    Color::rgba(0, 0, 0, 255)
+}
+
+fn white() -> Color {
+    Color::rgba(255, 255, 255, 255)
+}
+
+fn custom() -> Color {
+    Color::custom("palette".to_string(), vec!["window".to_string()])
+}
+
+test_cases! {
+    rgba: check_resolve Color::rgba(1, 2, 3, 4), Color::rgba(1, 2, 3, 4);
+    custom_source: check_resolve custom(), custom();
+    add: check_resolve Color::modified(&Color::rgba(100, 200, 0, 127), ColorOperation::add(&Color::rgba(100, 100, 100, 255))), Color::rgba(200, 255, 100, 127);
+    subtract: check_resolve Color::modified(&Color::rgba(100, 200, 0, 127), ColorOperation::subtract(&Color::rgba(50, 250, 10, 255))), Color::rgba(50, 0, 0, 127);
+    multiply: check_resolve Color::modified(&Color::rgba(255, 128, 0, 255), ColorOperation::multiply(&Color::rgba(128, 255, 255, 128))), Color::rgba(128, 128, 0, 128);
+    set: check_resolve Color::modified(&black(), ColorOperation::set(None, Some(10), None, Some(127))), Color::rgba(0, 10, 0, 127);
+    mix: check_resolve Color::modified(&black(), ColorOperation::mix(&white(), 0.5)), Color::rgba(128, 128, 128, 255);
+    mix_clamped: check_resolve Color::modified(&black(), ColorOperation::mix(&white(), 2.0)), white();
+    mix_negative: check_resolve Color::modified(&white(), ColorOperation::mix(&black(), -1.0)), white();
+    mix_alpha: check_resolve Color::modified(&Color::rgba(0, 0, 0, 0), ColorOperation::mix(&Color::rgba(0, 0, 0, 255), 0.5)), Color::rgba(0, 0, 0, 128);
+    add_keeps_alpha: check_resolve Color::modified(&Color::rgba(0, 0, 0, 0), ColorOperation::add(&white())), Color::rgba(255, 255, 255, 0);
+    add_saturates: check_resolve Color::modified(&Color::rgba(200, 255, 1, 255), ColorOperation::add(&Color::rgba(100, 1, 254, 0))), Color::rgba(255, 255, 255, 255);
+    subtract_keeps_alpha: check_resolve Color::modified(&Color::rgba(255, 255, 255, 10), ColorOperation::subtract(&Color::rgba(0, 0, 0, 255))), Color::rgba(255, 255, 255, 10);
+    subtract_saturates: check_resolve Color::modified(&Color::rgba(10, 0, 255, 255), ColorOperation::subtract(&white())), Color::rgba(0, 0, 0, 255);
+    multiply_transparent: check_resolve Color::modified(&white(), ColorOperation::multiply(&Color::rgba(255, 255, 255, 0))), Color::rgba(255, 255, 255, 0);
+    multiply_rounds: check_resolve Color::modified(&Color::rgba(1, 254, 255, 128), ColorOperation::multiply(&Color::rgba(128, 128, 0, 255))), Color::rgba(1, 127, 0, 128);
+    chain: check_resolve
+        Color::modified(&Color::modified(&black(), ColorOperation::add(&Color::rgba(10, 20, 30, 255))), ColorOperation::set(None, None, None, Some(0))),
+        Color::rgba(10, 20, 30, 0);
+    nested_operand: check_resolve
+        Color::modified(&black(), ColorOperation::mix(&Color::modified(&black(), ColorOperation::add(&white())), 0.25)),
+        Color::rgba(64, 64, 64, 255);
+    custom_base: check_resolve
+        Color::modified(&custom(), ColorOperation::add(&Color::modified(&black(), ColorOperation::set(Some(1), None, None, None)))),
+        Color::modified(&custom(), ColorOperation::add(&Color::rgba(1, 0, 0, 255)));
+    custom_operand: check_resolve
+        Color::modified(&Color::modified(&black(), ColorOperation::set(Some(1), None, None, None)), ColorOperation::mix(&custom(), 0.5)),
+        Color::modified(&Color::rgba(1, 0, 0, 255), ColorOperation::mix(&custom(), 0.5));
+}
+
+#[test]
+fn memoized() {
+    let derived = Color::modified(&black(), ColorOperation::mix(&white(), 0.5));
+    let mut resolver = ColorResolver::new();
+
+    assert_eq!(resolver.resolve(&derived), Color::rgba(128, 128, 128, 255));
+    assert_eq!(resolver.len(), 1);
+    assert_eq!(resolver.resolve(&derived.clone()), Color::rgba(128, 128, 128, 255));
+    assert_eq!(resolver.len(), 1);
+
+    let other = Color::modified(&derived, ColorOperation::set(None, None, None, Some(0)));
+    assert_eq!(resolver.resolve(&other), Color::rgba(128, 128, 128, 0));
+    assert_eq!(resolver.len(), 2);
+}
+
+#[test]
+fn visit_custom_colors() {
+    let color = Color::modified(&custom(), ColorOperation::mix(&Color::custom("palette".to_string(), vec!["text".to_string()]), 0.5));
+
+    let mut visited = Vec::new();
+    color.visit_custom_colors(&mut |source, arguments| visited.push((source.to_string(), arguments.to_vec())));
+    assert_eq!(visited, vec![
+        ("palette".to_string(), vec!["window".to_string()]),
+        ("palette".to_string(), vec!["text".to_string()]),
+    ]);
+}
+
+#[test]
+fn deep_chain() {
+    // Every color of the chain is memoized, the same as when its parts are
+    // resolved one by one.
+    let mut color = black();
+    for _ in 0..200 {
+        color = Color::modified(&color, ColorOperation::add(&Color::modified(&black(), ColorOperation::set(Some(1), None, None, None))));
+    }
+
+    let mut resolver = ColorResolver::new();
+    assert_eq!(resolver.resolve(&color), Color::rgba(200, 0, 0, 255));
+    assert_eq!(resolver.len(), 201);
+    assert_eq!(resolver.resolve(&color), Color::rgba(200, 0, 0, 255));
+    assert_eq!(resolver.len(), 201);
+}
@@ -19,3 +19,9 @@ mod propertyvalue;
 mod selectorparser;
 mod selector;
 mod propertyfunction;
+mod stylematcher;
+mod atom;
+mod colorresolver;
+mod prescan;
+mod cache;
+mod syntaxmatcher;
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+use std::path::Path;
+
+use crate::details::parallel::parse_chunk;
+use crate::details::parsecontext::enter_parse_context;
+use crate::details::prescan::{scan_imports, scan_top_level, split_chunks, Chunk, ItemKind};
+use crate::parseerror::ParseErrorKind;
+use crate::property::PropertyRegistry;
+use crate::stylesheet::ParseOptions;
+
+fn test_scan(input: &str, expected: &[(ItemKind, &str)]) {
+    let items: Vec<(ItemKind, &str)> = scan_top_level(input).into_iter().map(|item| (item.kind, &input[item.range])).collect();
+    assert_eq!(items, expected);
+}
+
+test_cases! {
+    empty: test_scan "", &[];
+    only_comments: test_scan " /* comment */ \n/* { */", &[];
+    single_rule: test_scan "a { color: red; }", &[(ItemKind::Rule, "a { color: red; }")];
+    multiple_rules: test_scan "a { color: red; }\n\nb{}/* x */c { }", &[
+        (ItemKind::Rule, "a { color: red; }"),
+        (ItemKind::Rule, "b{}"),
+        (ItemKind::Rule, "c { }"),
+    ];
+    nested: test_scan "a { b { c { color: red; } } }d {}", &[
+        (ItemKind::Rule, "a { b { c { color: red; } } }"),
+        (ItemKind::Rule, "d {}"),
+    ];
+    at_rules: test_scan "@import \"a.css\";\n@IMPORT url(b.css) ;@property --x { syntax: '*'; }@media screen { a {} }@charset \"utf-8\";", &[
+        (ItemKind::Import, "@import \"a.css\";"),
+        (ItemKind::Import, "@IMPORT url(b.css) ;"),
+        (ItemKind::Property, "@property --x { syntax: '*'; }"),
+        (ItemKind::AtRule, "@media screen { a {} }"),
+        (ItemKind::AtRule, "@charset \"utf-8\";"),
+    ];
+    escaped_at_rules: test_scan "@\\69mport 'a.css';@pro\\70 erty --x {}@\\00006d edia x {}", &[
+        (ItemKind::Import, "@\\69mport 'a.css';"),
+        (ItemKind::Property, "@pro\\70 erty --x {}"),
+        (ItemKind::AtRule, "@\\00006d edia x {}"),
+    ];
+    import_prefix: test_scan "@imports x;", &[(ItemKind::AtRule, "@imports x;")];
+    semicolon_in_rule: test_scan "a; b { } c {}", &[(ItemKind::Rule, "a; b { }"), (ItemKind::Rule, "c {}")];
+    strings: test_scan "a { content: \"}\\\"{\"; } b { content: '}' }", &[
+        (ItemKind::Rule, "a { content: \"}\\\"{\"; }"),
+        (ItemKind::Rule, "b { content: '}' }"),
+    ];
+    comments: test_scan "a { /* } */ } b { /**/ }", &[(ItemKind::Rule, "a { /* } */ }"), (ItemKind::Rule, "b { /**/ }")];
+    escapes: test_scan "a\\{ { content: \\} } b {}", &[(ItemKind::Rule, "a\\{ { content: \\} }"), (ItemKind::Rule, "b {}")];
+    unquoted_url: test_scan "a { background: url(x{y).png); } b {}", &[
+        (ItemKind::Rule, "a { background: url(x{y).png); }"),
+        (ItemKind::Rule, "b {}"),
+    ];
+    quoted_url: test_scan "a { background: url( \"x)\" ); } b {}", &[
+        (ItemKind::Rule, "a { background: url( \"x)\" ); }"),
+        (ItemKind::Rule, "b {}"),
+    ];
+    brackets: test_scan "a[x=\"]\"] { width: calc((1px + 2px) * 3); } b {}", &[
+        (ItemKind::Rule, "a[x=\"]\"] { width: calc((1px + 2px) * 3); }"),
+        (ItemKind::Rule, "b {}"),
+    ];
+    mismatched_closer: test_scan "a { ) ] color: red; } b {}", &[(ItemKind::Rule, "a { ) ] color: red; }"), (ItemKind::Rule, "b {}")];
+    block_in_parenthesis: test_scan "a { x: ( } ); } b {}", &[(ItemKind::Rule, "a { x: ( } ); }"), (ItemKind::Rule, "b {}")];
+    unterminated: test_scan "a {} b { color: red", &[(ItemKind::Rule, "a {}"), (ItemKind::Rule, "b { color: red")];
+    unterminated_string: test_scan "a { content: \"x\n; } b {}", &[(ItemKind::Rule, "a { content: \"x\n; }"), (ItemKind::Rule, "b {}")];
+    non_ascii: test_scan "a { content: \"\u{e9}\u{1f600}}\"; } \u{e9} {}", &[
+        (ItemKind::Rule, "a { content: \"\u{e9}\u{1f600}}\"; }"),
+        (ItemKind::Rule, "\u{e9} {}"),
+    ];
+    cdo_cdc: test_scan "<!--\n@import \"a.css\";\n--> a {} <!-- --> b --> c {}", &[
+        (ItemKind::Import, "@import \"a.css\";"),
+        (ItemKind::Rule, "a {}"),
+        (ItemKind::Rule, "b --> c {}"),
+    ];
+}
+
+#[test]
+fn long_input() {
+    // Long enough that most of it is scanned in whole vector chunks.
+    let rule = "widget .class > child:hover { background-color: rgba(10, 20, 30, 0.5); border: 1px solid red; }\n";
+    let input = rule.repeat(100);
+    let items = scan_top_level(&input);
+    assert_eq!(items.len(), 100);
+    for (index, item) in items.iter().enumerate() {
+        assert_eq!(item.kind, ItemKind::Rule);
+        assert_eq!(item.range.start, index * rule.len());
+        assert_eq!(&input[item.range.clone()], rule.trim_end());
+    }
+}
+
+#[test]
+fn chunks() {
+    let header = "@import \"a.css\";\n@property --x { syntax: '*'; inherits: false; }\n";
+    let input = format!("{}a {{}}\n{}d {{}} e {{}}", header, "b { color: red; } /* \n */ c {}\n".repeat(100));
+
+    let chunks = split_chunks(&input, 4, 100);
+    assert_eq!(&input[chunks[0].range.clone()], header);
+    assert_eq!(chunks[0].line, 0);
+    assert_eq!(chunks.len(), 5);
+    assert_eq!(chunks.last().unwrap().range.end, input.len());
+
+    for (index, chunk) in chunks.iter().enumerate().skip(1) {
+        assert_eq!(chunks[index - 1].range.end, chunk.range.start);
+        assert!(chunk.range.len() >= 100);
+        // Chunks only start in front of a rule at the start of a line.
+        assert_eq!(&input[chunk.range.start - 1..chunk.range.start], "\n");
+        assert!(input[chunk.range.clone()].starts_with(if index == 1 { "a {}" } else { "b {" }));
+        assert_eq!(chunk.line as usize, input[..chunk.range.start].matches('\n').count());
+    }
+}
+
+#[test]
+fn chunks_without_line_breaks() {
+    let input = "a {} b {} c {}";
+    assert_eq!(split_chunks(input, 4, 1), vec![Chunk { range: 0..0, line: 0 }, Chunk { range: 0..input.len(), line: 0 }]);
+}
+
+#[test]
+fn imports() {
+    let input = "@import \"a.css\";\n@\\69mport url(b.css);\na { }\n@import url(\"c.css\") screen;\n@import;\nb { content: \"@import 'd.css';\" }\n@media screen { @import \"e.css\"; }";
+    assert_eq!(scan_imports(input), vec!["a.css", "b.css", "c.css"]);
+}
+
+#[test]
+fn chunks_after_cdo() {
+    let input = format!("<!--\n@import \"a.css\";\na {{}}\n{}", "b { }\n".repeat(100));
+
+    let chunks = split_chunks(&input, 4, 100);
+    assert_eq!(&input[chunks[0].range.clone()], "<!--\n@import \"a.css\";\n");
+    assert!(chunks[1..].iter().all(|chunk| !input[chunk.range.clone()].contains("@import")));
+}
+
+#[test]
+fn import_in_chunk() {
+    // Should the pre-scan ever put an @import in a chunk, it is reported
+    // instead of parsed.
+    let input = "a {}\n@import \"a.css\";\nb {}\n";
+    let registry = PropertyRegistry::new();
+    let _context = enter_parse_context(&registry, "chunk.css", &ParseOptions::default());
+
+    let result = parse_chunk(input, &Chunk { range: 0..input.len(), line: 4 }, Path::new("chunk.css"));
+    assert_eq!(result.rules.len(), 2);
+    assert_eq!(result.errors.len(), 1);
+    assert_eq!(result.errors[0].kind, ParseErrorKind::UnsupportedAtRule);
+    assert_eq!(result.errors[0].location.line, 6);
+}
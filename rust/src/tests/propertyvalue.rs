@@ -1,9 +1,12 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 // SPDX-FileCopyrightText: 2025 Arjen Hiemstra <ahiemstra@heimr.nl>
 
+use crate::details::parsecontext::enter_parse_context;
 use crate::details::property::syntax::parse_syntax;
 use crate::details::property::value::parse_values;
 use crate::parseerror::{ParseErrorKind, SourceLocation};
+use crate::property::PropertyRegistry;
+use crate::stylesheet::ParseOptions;
 use crate::value::{Color, Dimension, Value, Unit};
 
 fn check_value(input: (&str, &str), expected: Vec<Value>) {
@@ -87,6 +90,68 @@ test_cases! {
             Value::from(Dimension{value: 180.0, unit: Unit::Degrees}),
             Value::from(Dimension{value: 270.0, unit: Unit::Degrees}),
         ];
+    alternative_keywords_later:
+        check_value ("one | two | <length> | three", "three"), vec![
+            Value::from("three"),
+        ];
+    alternative_keyword_sequence:
+        check_value ("(add <color>) | (set-alpha <number>)", "set-alpha 0.5"), vec![
+            Value::from("set-alpha"),
+            Value::from(0.5),
+        ];
+}
+
+fn check_canonical_value(input: (&str, &str), expected: Vec<Value>) {
+    let registry = PropertyRegistry::new();
+    let _context = enter_parse_context(&registry, "Test Input", &ParseOptions { canonicalize_units: true, ..Default::default() });
+
+    let mut parser_input = cssparser::ParserInput::new(input.1);
+    let mut parser = cssparser::Parser::new(&mut parser_input);
+
+    let parsed_syntax = parse_syntax(input.0, SourceLocation::from_file("Test Input")).unwrap();
+
+    let values: Vec<Value> = parse_values(&parsed_syntax, &mut parser).unwrap_or_else(|error| panic!("{}", error));
+    assert_eq!(values.len(), expected.len());
+    for (value, expected) in values.iter().zip(expected.iter()) {
+        let value = Dimension::from(value.clone());
+        let expected = Dimension::from(expected.clone());
+        assert_eq!(value.unit, expected.unit);
+        assert!((value.value - expected.value).abs() < 1e-4, "Expected {}, got {}", expected, value);
+    }
+}
+
+test_cases! {
+    canonical_px:
+        check_canonical_value ("<length>", "24px"), vec![
+            Value::from(Dimension::px(24.0))
+        ];
+    canonical_absolute_lengths:
+        check_canonical_value ("<length>+", "12pt 1pc 1in 2.54cm 25.4mm 4Q"), vec![
+            Value::from(Dimension::px(16.0)),
+            Value::from(Dimension::px(16.0)),
+            Value::from(Dimension::px(96.0)),
+            Value::from(Dimension::px(96.0)),
+            Value::from(Dimension::px(96.0)),
+            Value::from(Dimension::px(3.779528)),
+        ];
+    canonical_relative_lengths:
+        check_canonical_value ("<length-percentage>+", "2em 3rem 50%"), vec![
+            Value::from(Dimension{value: 2.0, unit: Unit::Em}),
+            Value::from(Dimension{value: 3.0, unit: Unit::Rem}),
+            Value::from(Dimension{value: 50.0, unit: Unit::Percent}),
+        ];
+    canonical_angles:
+        check_canonical_value ("<angle>+", "180deg 200grad 0.5turn 1rad"), vec![
+            Value::from(Dimension{value: std::f32::consts::PI, unit: Unit::Radians}),
+            Value::from(Dimension{value: std::f32::consts::PI, unit: Unit::Radians}),
+            Value::from(Dimension{value: std::f32::consts::PI, unit: Unit::Radians}),
+            Value::from(Dimension{value: 1.0, unit: Unit::Radians}),
+        ];
+    canonical_times:
+        check_canonical_value ("*", "1.5s 20ms"), vec![
+            Value::from(Dimension{value: 1500.0, unit: Unit::Milliseconds}),
+            Value::from(Dimension{value: 20.0, unit: Unit::Milliseconds}),
+        ];
 }
 
 fn check_error(syntax: &str, input: &str) {
@@ -115,5 +180,9 @@ test_cases! {
         check_error "<length> <length>", "24px";
     too_many_values:
         check_error "<percentage>", "100% 100%";
+    no_matching_alternative:
+        check_error "auto | <length>", "none";
+    no_matching_keyword_sequence:
+        check_error "(add <color>) | (set-alpha <number>)", "add 0.5";
 
 }
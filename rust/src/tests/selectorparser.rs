@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 // SPDX-FileCopyrightText: 2025 Arjen Hiemstra <ahiemstra@heimr.nl>
 
+use crate::atom::Atom;
 use crate::selector::*;
 use crate::value::Value;
 use crate::details::selectorparser::{SelectorParser, ParseRelative};
@@ -121,14 +122,7 @@ test_cases! {
         check_selector_toplevel "type[test]", vec![
             Selector::from_parts(&[
                 SelectorPart::new_with_value(SelectorKind::Type, Value::from("type")),
-                SelectorPart {
-                    kind: SelectorKind::Attribute,
-                    value: SelectorValue::Attribute {
-                        name: String::from("test"),
-                        operator: AttributeOperator::Exists,
-                        value: Value::empty(),
-                    }
-                },
+                SelectorPart::new_with_attribute(String::from("test"), AttributeOperator::Exists, Value::empty()),
             ]),
         ];
 
@@ -136,14 +130,7 @@ test_cases! {
         check_selector_toplevel ".class[test=\"test\"]", vec![
             Selector::from_parts(&[
                 SelectorPart::new_with_value(SelectorKind::Class, Value::from("class")),
-                SelectorPart {
-                    kind: SelectorKind::Attribute,
-                    value: SelectorValue::Attribute {
-                        name: String::from("test"),
-                        operator: AttributeOperator::Equals,
-                        value: Value::from("test"),
-                    }
-                },
+                SelectorPart::new_with_attribute(String::from("test"), AttributeOperator::Equals, Value::from("test")),
             ])
         ];
 
@@ -151,14 +138,7 @@ test_cases! {
         check_selector_nested "&[test*=\"test\"]", vec![
             Selector::from_parts(&[
                 SelectorPart::new_with_empty(SelectorKind::RelativeParent),
-                SelectorPart {
-                    kind: SelectorKind::Attribute,
-                    value: SelectorValue::Attribute {
-                        name: String::from("test"),
-                        operator: AttributeOperator::Substring,
-                        value: Value::from("test"),
-                    }
-                },
+                SelectorPart::new_with_attribute(String::from("test"), AttributeOperator::Substring, Value::from("test")),
             ])
         ];
 
@@ -175,3 +155,25 @@ test_cases! {
             ])
         ]
 }
+
+#[test]
+fn attribute_values_are_not_interned() {
+    check_selector_toplevel("[selector-attribute-name=\"selector-attribute-value\"]", vec![
+        Selector::from_parts(&[
+            SelectorPart::new_with_attribute(String::from("selector-attribute-name"), AttributeOperator::Equals, Value::from("selector-attribute-value")),
+        ])
+    ]);
+
+    assert!(Atom::lookup("selector-attribute-name").is_some());
+    assert!(Atom::lookup("selector-attribute-value").is_none());
+}
+
+#[test]
+fn parts_store_their_atom() {
+    let part = SelectorPart::new_with_value(SelectorKind::Class, Value::from("selector-part-class"));
+    assert_eq!(part.atom(), Atom::lookup("selector-part-class").unwrap());
+
+    let part = SelectorPart::new_with_attribute(String::from("selector-part-attribute"), AttributeOperator::Exists, Value::empty());
+    assert!(part.atom().is_empty());
+    assert!(SelectorPart::new_with_empty(SelectorKind::DocumentRoot).atom().is_empty());
+}
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+use std::path::PathBuf;
+
+use crate::stylematcher::{AncestorFilter, ElementData, StyleMatcher};
+use crate::stylesheet::StyleSheet;
+
+const STYLESHEET: &str = r#"
+* {}
+button {}
+.flat {}
+#ok {}
+button:hovered {}
+window button {}
+dialog > button {}
+[checked] {}
+button.flat {}
+button[kind|="tool"] {}
+"#;
+
+fn element(type_name: &str) -> ElementData {
+    ElementData {
+        type_name: type_name.to_string(),
+        ..Default::default()
+    }
+}
+
+fn check_matches(elements: Vec<ElementData>, expected: Vec<usize>) {
+    let mut sheet = StyleSheet::new(PathBuf::from("stylematcher.css"));
+    sheet.parse_string(STYLESHEET).unwrap();
+
+    let matcher = StyleMatcher::new(&sheet);
+    assert_eq!(matcher.rule_count(), 10);
+    assert_eq!(matcher.matching_rules(&elements), expected);
+}
+
+test_cases! {
+    type_name:
+        check_matches vec![element("button")], vec![0, 1];
+
+    class:
+        check_matches vec![
+            ElementData { classes: vec![String::from("flat")], ..element("button") },
+        ], vec![0, 1, 2, 8];
+
+    specificity:
+        check_matches vec![
+            ElementData { id: String::from("ok"), pseudo_classes: vec![String::from("hovered")], ..element("button") },
+            element("window"),
+        ], vec![0, 1, 5, 4, 3];
+
+    ancestors:
+        check_matches vec![element("button"), element("dialog"), element("window")], vec![0, 1, 5, 6];
+
+    distant_ancestor:
+        check_matches vec![element("button"), element("frame"), element("frame"), element("frame"), element("window")], vec![0, 1, 5];
+
+    ancestor_classes_are_not_the_element:
+        check_matches vec![
+            ElementData { classes: vec![String::from("flat")], ..element("dialog") },
+            element("button"),
+        ], vec![0, 2];
+
+    child_combinator:
+        check_matches vec![element("button"), element("frame"), element("dialog")], vec![0, 1];
+
+    attribute_exists:
+        check_matches vec![
+            ElementData { attributes: vec![(String::from("checked"), String::new())], ..element("label") },
+        ], vec![0, 7];
+
+    attribute_dash_match:
+        check_matches vec![
+            ElementData { attributes: vec![(String::from("kind"), String::from("tool-button"))], ..element("button") },
+        ], vec![0, 1, 9];
+}
+
+#[test]
+fn ancestor_filter() {
+    let mut sheet = StyleSheet::new(PathBuf::from("stylematcher.css"));
+    sheet.parse_string(STYLESHEET).unwrap();
+    let matcher = StyleMatcher::new(&sheet);
+
+    let window = element("window");
+    let dialog = element("dialog");
+    let elements = vec![element("button"), dialog.clone(), window.clone()];
+
+    // Walk down from the root, like a tree traversal would.
+    let mut filter = AncestorFilter::new();
+    filter.push(&window);
+    filter.push(&dialog);
+    assert_eq!(filter.len(), 2);
+    assert_eq!(matcher.matching_rules_with_filter(&elements, &filter), matcher.matching_rules(&elements));
+
+    // Without dialog only the descendant rule for window can match.
+    filter.pop();
+    assert_eq!(matcher.matching_rules_with_filter(&[element("button"), window.clone()], &filter), vec![0, 1, 5]);
+
+    // An empty filter rejects every rule that needs an ancestor.
+    filter.pop();
+    assert!(filter.is_empty());
+    assert_eq!(matcher.matching_rules_with_filter(&elements, &filter), vec![0, 1]);
+}
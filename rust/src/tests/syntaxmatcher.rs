@@ -0,0 +1,324 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+use crate::details::property::syntax::*;
+use crate::details::property::value::ParseValuesResult;
+use crate::parseerror::SourceLocation;
+use crate::value::{Color, Dimension, Unit, Value, ValueData};
+
+// Validates values by walking the syntax tree and trying every alternative
+// in turn. This is how values were validated before SyntaxMatcher, which
+// needs to accept the same values and report the same errors.
+mod reference {
+    use super::*;
+
+    #[derive(PartialEq)]
+    pub enum ListType {
+        NotAList,
+        SpaceSeparated,
+        CommaSeparated,
+    }
+
+    type Result<'a> = std::result::Result<&'a [Value], String>;
+
+    fn datatype<'a>(datatype: &DataType, values: &'a [Value]) -> Result<'a> {
+        let Some((value, remain)) = values.split_first() else {
+            return Err(String::from("Expected a datatype"));
+        };
+
+        let dimension = match &value.data {
+            ValueData::Dimension(dimension) => Some(dimension),
+            _ => None,
+        };
+        let (matches, name) = match datatype {
+            DataType::Length => (dimension.is_some_and(|dimension| dimension.is_length()), "Length"),
+            DataType::Number => (dimension.is_some_and(|dimension| dimension.is_number()), "Number"),
+            DataType::Percentage => (dimension.is_some_and(|dimension| dimension.is_percent()), "Percentage"),
+            DataType::LengthPercentage => (dimension.is_some_and(|dimension| dimension.is_length() || dimension.is_percent()), "Length or Percentage"),
+            DataType::String => (matches!(value.data, ValueData::String(_)), "String"),
+            DataType::Color => (matches!(value.data, ValueData::Color(_)), "Color"),
+            DataType::Angle => (dimension.is_some_and(|dimension| dimension.is_angle()), "Angle"),
+            DataType::Integer => (matches!(value.data, ValueData::Integer(_)), "Integer"),
+            DataType::Url => (matches!(value.data, ValueData::Url(_)), "URL"),
+            _ => return Err(format!("Unhandled data type {:?}", datatype)),
+        };
+
+        if matches {
+            Ok(remain)
+        } else {
+            Err(format!("Expected {}, got {}", name, value))
+        }
+    }
+
+    fn keyword<'a>(keyword: &String, values: &'a [Value]) -> Result<'a> {
+        match values.split_first() {
+            Some((value, remain)) => match &value.data {
+                ValueData::String(data) if data == keyword => Ok(remain),
+                ValueData::String(data) => Err(format!("Unexpected keyword {}", data)),
+                _ => Err(format!("{:?} is not a keyword", value)),
+            },
+            None => Err(String::from("Expected a keyword")),
+        }
+    }
+
+    fn list<'a>(data_type: &DataType, values: &'a [Value], minimum: usize, maximum: usize) -> Result<'a> {
+        let mut count = 0;
+        let mut remain = values;
+        while !remain.is_empty() {
+            remain = datatype(data_type, remain)?;
+            count += 1;
+            if count == maximum {
+                break;
+            }
+        }
+
+        if count < minimum {
+            Err(format!("Expected at least {} values of type {:?}", minimum, data_type))
+        } else if count > maximum {
+            Err(format!("Expected at most {} values of type {:?}", maximum, data_type))
+        } else {
+            Ok(remain)
+        }
+    }
+
+    fn component<'a>(component: &SyntaxComponent, values: &'a [Value], list_type: &ListType) -> Result<'a> {
+        match component {
+            SyntaxComponent::DataType(data_type) => datatype(data_type, values),
+            SyntaxComponent::Keyword(name) => keyword(name, values),
+            SyntaxComponent::Comma => Ok(values),
+            SyntaxComponent::SpaceSeparatedList(data_type) => {
+                if list_type == &ListType::CommaSeparated {
+                    return Err(String::from("Expected space separated list, got comma separated"));
+                }
+                list(data_type, values, 0, usize::MAX)
+            },
+            SyntaxComponent::CommaSeparatedList(data_type) => {
+                if list_type == &ListType::SpaceSeparated {
+                    return Err(String::from("Expected comma separated list, got space separated"));
+                }
+                list(data_type, values, 0, usize::MAX)
+            },
+            SyntaxComponent::Repeat { data_type, minimum, maximum } => {
+                if list_type == &ListType::CommaSeparated {
+                    return Err(String::from("Expected space separated list, got comma separated"));
+                }
+                list(data_type, values, *minimum, *maximum)
+            },
+        }
+    }
+
+    fn group<'a>(group: &SyntaxGroup, values: &'a [Value], list_type: &ListType) -> Result<'a> {
+        match group {
+            SyntaxGroup::Component(inner) => component(inner, values, list_type),
+            SyntaxGroup::Expression(inner) => expression(inner, values, list_type),
+        }
+    }
+
+    fn alternatives<'a>(alternatives: &SyntaxAlternatives, values: &'a [Value], list_type: &ListType) -> Result<'a> {
+        match alternatives {
+            SyntaxAlternatives::Component(inner) => component(inner, values, list_type),
+            SyntaxAlternatives::Group(inner) => group(inner, values, list_type),
+            SyntaxAlternatives::Alternatives(groups) => groups.iter()
+                .find_map(|inner| group(inner, values, list_type).ok())
+                .ok_or_else(|| String::from("None of the alternatives matched")),
+        }
+    }
+
+    pub fn expression<'a>(expression: &[SyntaxAlternatives], values: &'a [Value], list_type: &ListType) -> Result<'a> {
+        let mut remain = values;
+        let mut index = 0;
+        while !remain.is_empty() && index < expression.len() {
+            remain = alternatives(&expression[index], remain, list_type)?;
+            index += 1;
+        }
+
+        if index == expression.len() {
+            Ok(remain)
+        } else {
+            let expected: Vec<_> = expression[index..].iter().map(|item| item.to_string()).collect();
+            Err(format!("Unexpected end of input, expected: {}", expected.join(" ")))
+        }
+    }
+}
+
+fn validate_reference(syntax: &ParsedPropertySyntax, values: &ParseValuesResult) -> Result<(), String> {
+    let ParsedPropertySyntax::Expression(expression) = syntax else {
+        return Ok(());
+    };
+
+    let (values, list_type) = match values {
+        ParseValuesResult::Single(values) => (values, reference::ListType::NotAList),
+        ParseValuesResult::SpaceSeparated(values) => (values, reference::ListType::SpaceSeparated),
+        ParseValuesResult::CommaSeparated(values) => (values, reference::ListType::CommaSeparated),
+    };
+
+    let remain = reference::expression(expression, values, &list_type)?;
+    if remain.is_empty() {
+        Ok(())
+    } else {
+        Err(format!("Received too many values, remaining: {:?}", remain))
+    }
+}
+
+fn validate(syntax: &ParsedPropertySyntax, values: &ParseValuesResult) -> Result<(), String> {
+    validate_syntax(&SyntaxMatcher::new(syntax), values, SourceLocation::from_file("Test Input")).map_err(|error| error.message.to_string())
+}
+
+fn values_result(values: Vec<Value>, comma_separated: bool) -> ParseValuesResult {
+    if values.len() == 1 {
+        ParseValuesResult::Single(values)
+    } else if comma_separated {
+        ParseValuesResult::CommaSeparated(values)
+    } else {
+        ParseValuesResult::SpaceSeparated(values)
+    }
+}
+
+fn check_same(syntax: &str, values: Vec<Value>, comma_separated: bool, accepted: bool) {
+    let parsed = parse_syntax(syntax, SourceLocation::from_file("Test Input")).unwrap();
+    let values = values_result(values, comma_separated);
+
+    let result = validate(&parsed, &values);
+    assert_eq!(result, validate_reference(&parsed, &values), "Syntax {} with values {:?}", syntax, values);
+    assert_eq!(result.is_ok(), accepted, "Syntax {} with values {:?}: {:?}", syntax, values, result);
+}
+
+fn length() -> Value {
+    Value::from(Dimension::px(1.0))
+}
+
+fn keyword(name: &str) -> Value {
+    Value::from(name)
+}
+
+fn color() -> Value {
+    Value::from(Color::rgba(0, 0, 0, 255))
+}
+
+// Options of a choice are skipped if they cannot start with the first value,
+// these cover each way of determining what an option can start with.
+#[test]
+fn first_values() {
+    // A comma does not consume anything, so an option that starts with one
+    // can start with whatever comes after it.
+    check_same(", <length> | <color>", vec![length()], false, true);
+    check_same("(, <length>) | <color>", vec![length()], false, true);
+    check_same("(, <length>) | <color>", vec![color()], false, true);
+    check_same("(, <length>) | <color>", vec![keyword("auto")], false, false);
+    check_same("(,) | <color>", vec![color()], false, false);
+
+    // An option that starts with a keyword can only start with that keyword,
+    // unless the keyword comes after something that may not consume a value.
+    check_same("(auto <length>) | (none <length>) | <length>", vec![keyword("none"), length()], false, true);
+    check_same("(auto <length>) | (none <length>) | <length>", vec![keyword("auto"), keyword("none")], false, false);
+    check_same("(auto <length>) | <string>", vec![keyword("other")], false, true);
+    check_same("(auto <length>) | <string>", vec![keyword("auto")], false, true);
+    check_same("(, auto <length>) | <color>", vec![keyword("auto"), length()], false, true);
+    check_same("(, auto <length>) | <color>", vec![keyword("none"), length()], false, false);
+    check_same("((<color> | ,) auto) | <string>", vec![color(), keyword("auto")], false, true);
+
+    // A choice with an option that does not consume anything is skipped
+    // over, so what comes after it can be the first value. That option is
+    // also used when the value matches a later option, as the first option
+    // that matches is used.
+    check_same("((, | <color>) <length>) | <string>", vec![length()], false, true);
+    check_same("((, | <color>) <length>) | <string>", vec![color(), length()], false, false);
+    check_same("((<color> | ,) <length>) | <string>", vec![color(), length()], false, true);
+    check_same("((, | <color>) <length>) | <string>", vec![keyword("auto")], false, true);
+    check_same("((auto | <color>) <length>) | <integer>", vec![length()], false, false);
+
+    // Lists only accept the kind of list they are written as.
+    check_same("<length># | <length>+", vec![length(), length()], true, true);
+    check_same("<length># | <length>+", vec![length(), length()], false, true);
+    check_same("<length>{1,2} | auto", vec![length(), length()], true, false);
+    check_same("<integer># | auto", vec![Value::from(1), Value::from(2)], false, false);
+}
+
+// A small deterministic generator, so failures can be reproduced.
+struct Random(u64);
+
+impl Random {
+    fn next(&mut self, bound: usize) -> usize {
+        self.0 ^= self.0 << 13;
+        self.0 ^= self.0 >> 7;
+        self.0 ^= self.0 << 17;
+        (self.0 % bound as u64) as usize
+    }
+}
+
+const DATA_TYPES: [DataType; 10] = [
+    DataType::Length,
+    DataType::Number,
+    DataType::Percentage,
+    DataType::LengthPercentage,
+    DataType::String,
+    DataType::Color,
+    DataType::Url,
+    DataType::Integer,
+    DataType::Angle,
+    DataType::Time,
+];
+
+const KEYWORDS: [&str; 3] = ["auto", "none", "inherit"];
+
+fn random_component(random: &mut Random) -> SyntaxComponent {
+    let data_type = DATA_TYPES[random.next(DATA_TYPES.len())].clone();
+    match random.next(6) {
+        0 => SyntaxComponent::DataType(data_type),
+        1 => SyntaxComponent::Keyword(KEYWORDS[random.next(KEYWORDS.len())].to_string()),
+        2 => SyntaxComponent::SpaceSeparatedList(data_type),
+        3 => SyntaxComponent::CommaSeparatedList(data_type),
+        4 => {
+            let minimum = random.next(3);
+            SyntaxComponent::Repeat { data_type, minimum, maximum: minimum + random.next(3) }
+        },
+        _ => SyntaxComponent::Comma,
+    }
+}
+
+fn random_group(random: &mut Random, depth: usize) -> SyntaxGroup {
+    if depth == 0 || random.next(3) != 0 {
+        SyntaxGroup::Component(random_component(random))
+    } else {
+        SyntaxGroup::Expression(random_expression(random, depth - 1))
+    }
+}
+
+fn random_expression(random: &mut Random, depth: usize) -> Vec<SyntaxAlternatives> {
+    (0..1 + random.next(3)).map(|_| match random.next(3) {
+        0 => SyntaxAlternatives::Component(random_component(random)),
+        1 => SyntaxAlternatives::Group(random_group(random, depth)),
+        _ => SyntaxAlternatives::Alternatives((0..2 + random.next(3)).map(|_| random_group(random, depth)).collect()),
+    }).collect()
+}
+
+fn random_value(random: &mut Random) -> Value {
+    match random.next(9) {
+        0 => Value::from(Dimension::px(1.0)),
+        1 => Value::from(Dimension { value: 2.0, unit: Unit::Em }),
+        2 => Value::from(Dimension { value: 50.0, unit: Unit::Percent }),
+        3 => Value::from(Dimension { value: 90.0, unit: Unit::Degrees }),
+        4 => Value::from(1.5),
+        5 => Value::from(3),
+        6 => Value::from(Color::rgba(255, 0, 0, 255)),
+        7 => Value::new_url("image.png"),
+        _ => Value::from(["auto", "none", "inherit", "other"][random.next(4)]),
+    }
+}
+
+// Compare SyntaxMatcher with the reference for random syntaxes and values.
+#[test]
+fn same_as_reference() {
+    let mut random = Random(0x2545f4914f6cdd1d);
+    for _ in 0..5000 {
+        let syntax = ParsedPropertySyntax::Expression(random_expression(&mut random, 2));
+
+        for _ in 0..20 {
+            let values: Vec<_> = (0..random.next(6)).map(|_| random_value(&mut random)).collect();
+            let values = values_result(values, random.next(2) == 0);
+
+            let result = validate(&syntax, &values);
+            assert_eq!(result, validate_reference(&syntax, &values), "Syntax {:?} with values {:?}", syntax, values);
+        }
+    }
+}
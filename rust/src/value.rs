@@ -1,14 +1,30 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 // SPDX-FileCopyrightText: 2025 Arjen Hiemstra <ahiemstra@heimr.nl>
 
+use std::collections::HashMap;
+use std::collections::hash_map::DefaultHasher;
+use std::hash::{Hash, Hasher};
+
 use crate::details::identifier::Identifier;
 
+// An operation that derives a color from another one, see apply_operation()
+// for how it is evaluated.
 #[derive(Debug, Clone, PartialEq)]
 pub enum ColorOperation {
+    // Replace the channels that are Some, keep the others.
     Set { r: Option<u8>, g: Option<u8>, b: Option<u8>, a: Option<u8> },
+    // Add the red, green and blue of `other`, saturating at 255. The alpha
+    // of the modified color is kept, the alpha of `other` is ignored.
     Add { other: Box<Color> },
+    // Subtract the red, green and blue of `other`, saturating at 0. Alpha is
+    // handled like for Add.
     Subtract { other: Box<Color> },
+    // Multiply every channel, including alpha, with the one of `other`, as
+    // if both were in the range 0 to 1. The result is rounded.
     Multiply { other: Box<Color> },
+    // Interpolate every channel, including alpha, towards `other`. `amount`
+    // is clamped to the range 0 to 1, 0 gives the modified color and 1 gives
+    // `other`. The result is rounded.
     Mix { other: Box<Color>, amount: f32 },
 }
 
@@ -55,7 +71,23 @@ impl ColorOperation {
     }
 }
 
-#[derive(Debug, Default, Clone, PartialEq)]
+// Implemented manually because of the f32 amount of Mix. Both zeroes compare
+// equal, so they need to hash the same.
+impl Hash for ColorOperation {
+    fn hash<H: Hasher>(&self, state: &mut H) {
+        std::mem::discriminant(self).hash(state);
+        match self {
+            Self::Set { r, g, b, a } => (r, g, b, a).hash(state),
+            Self::Add { other } | Self::Subtract { other } | Self::Multiply { other } => other.hash(state),
+            Self::Mix { other, amount } => {
+                other.hash(state);
+                (if *amount == 0.0 { 0 } else { amount.to_bits() }).hash(state);
+            },
+        }
+    }
+}
+
+#[derive(Debug, Default, Clone, PartialEq, Hash)]
 pub(crate) enum ColorData {
     #[default] Empty,
     Rgba { r: u8, g: u8, b: u8, a: u8 },
@@ -63,7 +95,7 @@ pub(crate) enum ColorData {
     Modified { color: Box<Color>, operation: ColorOperation },
 }
 
-#[derive(Debug, Default, Clone, PartialEq)]
+#[derive(Debug, Default, Clone, PartialEq, Hash)]
 pub struct Color {
     pub(crate) data: ColorData,
 }
@@ -89,6 +121,197 @@ impl Color {
             }
         }
     }
+
+    // Returns this color with all operations on constant colors evaluated,
+    // see ColorResolver.
+    pub fn resolve(&self) -> Color {
+        ColorResolver::new().resolve(self)
+    }
+
+    pub fn as_rgba(&self) -> Option<(u8, u8, u8, u8)> {
+        match self.data {
+            ColorData::Rgba { r, g, b, a } => Some((r, g, b, a)),
+            _ => None,
+        }
+    }
+
+    // Calls `function` with the source and arguments of every custom color
+    // this color is made of, including the inputs of modified colors.
+    pub fn visit_custom_colors<'a>(&'a self, function: &mut impl FnMut(&'a str, &'a [String])) {
+        match &self.data {
+            ColorData::Custom { source, arguments } => function(source, arguments),
+            ColorData::Modified { color, operation } => {
+                color.visit_custom_colors(function);
+                match operation {
+                    ColorOperation::Set { .. } => (),
+                    ColorOperation::Add { other }
+                    | ColorOperation::Subtract { other }
+                    | ColorOperation::Multiply { other }
+                    | ColorOperation::Mix { other, amount: _ } => other.visit_custom_colors(function),
+                }
+            },
+            _ => (),
+        }
+    }
+}
+
+// Evaluates the operations of modified colors.
+//
+// An operation of which all inputs are RGBA colors is replaced by its
+// resulting RGBA color. Custom colors are only known to whatever provides
+// them, so operations that involve one are kept, though any constant inputs
+// of them are still evaluated.
+//
+// Operations are evaluated as described for ColorOperation. Add and Subtract
+// keep the alpha of the color they modify while Multiply and Mix also apply
+// to alpha. No result can leave the range of a channel.
+//
+// Results are memoized by the structure of the color that was resolved, so
+// resolving many colors that are derived from the same colors with one
+// resolver only evaluates every distinct operation once.
+#[derive(Debug, Default)]
+pub struct ColorResolver {
+    cache: HashMap<u64, (Color, Color)>,
+}
+
+fn multiply_channel(first: u8, second: u8) -> u8 {
+    ((first as u32 * second as u32 + 127) / 255) as u8
+}
+
+fn mix_channel(first: u8, second: u8, amount: f32) -> u8 {
+    (first as f32 + (second as f32 - first as f32) * amount).round().clamp(0.0, 255.0) as u8
+}
+
+// Evaluate `operation` on the RGBA `color`. Returns None if the operand of
+// the operation is not an RGBA color.
+pub(crate) fn apply_operation(color: (u8, u8, u8, u8), operation: &ColorOperation) -> Option<Color> {
+    let (r, g, b, a) = color;
+    let result = match operation {
+        ColorOperation::Set { r: new_r, g: new_g, b: new_b, a: new_a } => {
+            Color::rgba(new_r.unwrap_or(r), new_g.unwrap_or(g), new_b.unwrap_or(b), new_a.unwrap_or(a))
+        },
+        ColorOperation::Add { other } => {
+            let (other_r, other_g, other_b, _) = other.as_rgba()?;
+            Color::rgba(r.saturating_add(other_r), g.saturating_add(other_g), b.saturating_add(other_b), a)
+        },
+        ColorOperation::Subtract { other } => {
+            let (other_r, other_g, other_b, _) = other.as_rgba()?;
+            Color::rgba(r.saturating_sub(other_r), g.saturating_sub(other_g), b.saturating_sub(other_b), a)
+        },
+        ColorOperation::Multiply { other } => {
+            let (other_r, other_g, other_b, other_a) = other.as_rgba()?;
+            Color::rgba(multiply_channel(r, other_r), multiply_channel(g, other_g), multiply_channel(b, other_b), multiply_channel(a, other_a))
+        },
+        ColorOperation::Mix { other, amount } => {
+            let (other_r, other_g, other_b, other_a) = other.as_rgba()?;
+            let amount = amount.clamp(0.0, 1.0);
+            Color::rgba(mix_channel(r, other_r, amount), mix_channel(g, other_g, amount), mix_channel(b, other_b, amount), mix_channel(a, other_a, amount))
+        },
+    };
+    Some(result)
+}
+
+impl ColorResolver {
+    pub fn new() -> ColorResolver {
+        ColorResolver::default()
+    }
+
+    // The number of distinct modified colors that were resolved.
+    pub fn len(&self) -> usize {
+        self.cache.len()
+    }
+
+    pub fn clear(&mut self) {
+        self.cache.clear();
+    }
+
+    pub fn resolve(&mut self, color: &Color) -> Color {
+        let mut nodes = Vec::new();
+        hash_nodes(color, &mut nodes);
+        self.resolve_node(color, &nodes)
+    }
+
+    // Resolve `color`, where `nodes` are the entries of hash_nodes() for
+    // `color`, so looking up the colors it is made of does not need to hash
+    // them again.
+    fn resolve_node(&mut self, color: &Color, nodes: &[(u64, usize)]) -> Color {
+        let ColorData::Modified { color: base, operation } = &color.data else {
+            return color.clone();
+        };
+
+        let (key, _) = nodes[nodes.len() - 1];
+
+        // A different color with the same hash is simply not memoized.
+        let cached = self.cache.get(&key);
+        if let Some((input, output)) = cached {
+            if input == color {
+                return output.clone();
+            }
+        }
+        let store = cached.is_none();
+
+        // The entries of the base come first, followed by those of the
+        // operand, if there is one.
+        let children = &nodes[..nodes.len() - 1];
+        let other_size = match operation {
+            ColorOperation::Set { .. } => 0,
+            _ => children[children.len() - 1].1,
+        };
+        let (base_nodes, other_nodes) = children.split_at(children.len() - other_size);
+
+        let base = self.resolve_node(base, base_nodes);
+        let operation = match operation {
+            ColorOperation::Set { .. } => operation.clone(),
+            ColorOperation::Add { other } => ColorOperation::Add { other: Box::new(self.resolve_node(other, other_nodes)) },
+            ColorOperation::Subtract { other } => ColorOperation::Subtract { other: Box::new(self.resolve_node(other, other_nodes)) },
+            ColorOperation::Multiply { other } => ColorOperation::Multiply { other: Box::new(self.resolve_node(other, other_nodes)) },
+            ColorOperation::Mix { other, amount } => ColorOperation::Mix { other: Box::new(self.resolve_node(other, other_nodes)), amount: *amount },
+        };
+
+        let result = base.as_rgba()
+            .and_then(|rgba| apply_operation(rgba, &operation))
+            .unwrap_or_else(|| Color { data: ColorData::Modified { color: Box::new(base), operation } });
+
+        if store {
+            self.cache.insert(key, (color.clone(), result.clone()));
+        }
+        result
+    }
+}
+
+// Append the hash and the number of entries of `color` and every color it is
+// made of to `nodes`, in post-order: the entries of the base, then those of
+// the operand, then the one of `color`. The hash of a modified color is built
+// from the hashes of its inputs, so every color is only hashed once.
+fn hash_nodes(color: &Color, nodes: &mut Vec<(u64, usize)>) {
+    let start = nodes.len();
+    let mut hasher = DefaultHasher::new();
+    std::mem::discriminant(&color.data).hash(&mut hasher);
+
+    match &color.data {
+        ColorData::Modified { color: base, operation } => {
+            hash_nodes(base, nodes);
+            nodes[nodes.len() - 1].0.hash(&mut hasher);
+
+            std::mem::discriminant(operation).hash(&mut hasher);
+            match operation {
+                ColorOperation::Set { r, g, b, a } => (r, g, b, a).hash(&mut hasher),
+                ColorOperation::Add { other } | ColorOperation::Subtract { other } | ColorOperation::Multiply { other } => {
+                    hash_nodes(other, nodes);
+                    nodes[nodes.len() - 1].0.hash(&mut hasher);
+                },
+                ColorOperation::Mix { other, amount } => {
+                    hash_nodes(other, nodes);
+                    nodes[nodes.len() - 1].0.hash(&mut hasher);
+                    // Both zeroes compare equal, so they need to hash the same.
+                    (if *amount == 0.0 { 0 } else { amount.to_bits() }).hash(&mut hasher);
+                },
+            }
+        },
+        data => data.hash(&mut hasher),
+    }
+
+    nodes.push((hasher.finish(), nodes.len() + 1 - start));
 }
 
 impl From<(u8, u8, u8)> for Color {
@@ -151,7 +374,7 @@ impl std::fmt::Display for Color {
     }
 }
 
-#[derive(Debug, Default, Clone, PartialEq)]
+#[derive(Debug, Default, Clone, PartialEq, Hash)]
 pub enum Unit {
     #[default] Unknown,
     Unsupported,
@@ -246,6 +469,44 @@ impl Dimension {
             _ => false
         }
     }
+
+    // Convert `value` in the unit named `unit` to a canonical unit: absolute
+    // lengths to px, angles to radians and times to milliseconds. Returns None
+    // for any other unit, relative units like em and % depend on where they
+    // are used so they can't be converted.
+    //
+    // This also converts units that Unit::parse() considers unsupported,
+    // since they can be represented once converted.
+    pub fn canonical(value: f32, unit: &str) -> Option<Dimension> {
+        use std::f32::consts::PI;
+
+        let (unit, factor) = match unit {
+            "px" => (Unit::Px, 1.0),
+            "pt" => (Unit::Px, 96.0 / 72.0),
+            "pc" => (Unit::Px, 16.0),
+            "in" => (Unit::Px, 96.0),
+            "cm" => (Unit::Px, 96.0 / 2.54),
+            "mm" => (Unit::Px, 96.0 / 25.4),
+            "Q" => (Unit::Px, 96.0 / 101.6),
+            "rad" => (Unit::Radians, 1.0),
+            "deg" => (Unit::Radians, PI / 180.0),
+            "grad" => (Unit::Radians, PI / 200.0),
+            "turn" => (Unit::Radians, 2.0 * PI),
+            "ms" => (Unit::Milliseconds, 1.0),
+            "s" => (Unit::Milliseconds, 1000.0),
+            _ => return None,
+        };
+
+        Some(Dimension { value: value * factor, unit })
+    }
+}
+
+// Implemented manually because of the f32 value, see ColorOperation.
+impl Hash for Dimension {
+    fn hash<H: Hasher>(&self, state: &mut H) {
+        (if self.value == 0.0 { 0 } else { self.value.to_bits() }).hash(state);
+        self.unit.hash(state);
+    }
 }
 
 impl From<Value> for Dimension {
@@ -264,7 +525,7 @@ impl std::fmt::Display for Dimension {
     }
 }
 
-#[derive(Debug, Default, Clone, PartialEq)]
+#[derive(Debug, Default, Clone, PartialEq, Hash)]
 pub enum ValueData {
     #[default] Empty,
     Dimension(Dimension),
@@ -275,7 +536,7 @@ pub enum ValueData {
     Integer(i32),
 }
 
-#[derive(Debug, Default, Clone, PartialEq)]
+#[derive(Debug, Default, Clone, PartialEq, Hash)]
 pub struct Value {
     pub(crate) data: ValueData
 }
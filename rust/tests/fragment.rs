@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+// SPDX-FileCopyrightText: 2026 Arjen Hiemstra <ahiemstra@heimr.nl>
+
+use std::path::PathBuf;
+use std::sync::Arc;
+
+use cxx_rust_cssparser_impl::fragment::{FragmentKind, FragmentParser};
+use cxx_rust_cssparser_impl::parseerror::ParseErrorKind;
+use cxx_rust_cssparser_impl::property::{PropertyDefinition, PropertyRegistry};
+use cxx_rust_cssparser_impl::stylesheet::StyleSheet;
+use cxx_rust_cssparser_impl::value::{Dimension, Unit, Value};
+
+fn registry() -> PropertyRegistry {
+    let registry = PropertyRegistry::new();
+    registry.add(&Arc::new(PropertyDefinition::from_name_syntax("width", "<length>", "", 0, 0).unwrap()));
+    registry.add(&Arc::new(PropertyDefinition::from_name_syntax("color", "<color>", "", 0, 0).unwrap()));
+    registry
+}
+
+#[test]
+fn rules() {
+    let registry = registry();
+    let parser = FragmentParser::new_with_registry(FragmentKind::Rules, &registry);
+
+    let fragments = ["a { width: 1px; } b { width: 2px; }", "", "c { unknown: 1px; }", "d, e { width: 3px; }"];
+    let batch = parser.parse(&fragments);
+
+    assert_eq!(batch.fragments.len(), 4);
+    assert_eq!(batch.rules(0).len(), 2);
+    assert!(batch.rules(1).is_empty());
+    assert!(batch.rules(2).is_empty());
+    assert_eq!(batch.errors(2).len(), 1);
+    assert_eq!(batch.errors(2)[0].kind, ParseErrorKind::UnknownProperty);
+    assert_eq!(batch.rules(3).iter().map(|rule| rule.source_order).collect::<Vec<_>>(), vec![0, 1]);
+
+    // The results are the same as parsing each fragment as a StyleSheet.
+    for (index, fragment) in fragments.iter().enumerate() {
+        let mut stylesheet = StyleSheet::new_with_registry(PathBuf::new(), &registry);
+        stylesheet.parse_string(fragment).unwrap();
+        assert_eq!(batch.rules(index), stylesheet.all_rules().as_slice());
+        assert_eq!(batch.errors(index), stylesheet.all_errors().as_slice());
+    }
+}
+
+#[test]
+fn declarations() {
+    let registry = registry();
+    let parser = FragmentParser::new_with_registry(FragmentKind::Declarations, &registry);
+
+    let batch = parser.parse(&["width: 1px; color: red", "width: 2px; a { width: 3px; }", "--custom: 1px", "unknown: 1px; width: 4px"]);
+
+    assert_eq!(batch.fragments.len(), 4);
+    assert!(batch.rules.is_empty());
+
+    assert_eq!(batch.properties(0).len(), 2);
+    assert_eq!(batch.properties(0)[0].values, vec![Value::from(Dimension { value: 1.0, unit: Unit::Px })]);
+    assert!(batch.errors(0).is_empty());
+
+    assert_eq!(batch.properties(1).len(), 1);
+    assert_eq!(batch.errors(1).len(), 1);
+
+    // Custom properties define themselves instead of resulting in a property.
+    assert!(batch.properties(2).is_empty());
+    assert!(registry.get("--custom").is_some());
+
+    assert_eq!(batch.properties(3).len(), 1);
+    assert_eq!(batch.errors(3)[0].kind, ParseErrorKind::UnknownProperty);
+}
+
+#[test]
+fn invalid_utf8() {
+    let registry = registry();
+    let parser = FragmentParser::new_with_registry(FragmentKind::Declarations, &registry);
+
+    let fragments: [&[u8]; 3] = [b"width: 1px", b"width: \xff1px", b"width: 2px"];
+    let batch = parser.parse_bytes(&fragments);
+
+    // Only the invalid fragment fails, the others are parsed as usual.
+    assert_eq!(batch.fragments.len(), 3);
+    assert_eq!(batch.properties(0).len(), 1);
+    assert!(batch.errors(0).is_empty());
+    assert!(batch.properties(1).is_empty());
+    assert_eq!(batch.errors(1).len(), 1);
+    assert_eq!(batch.properties(2).len(), 1);
+    assert!(batch.errors(2).is_empty());
+}
@@ -3,10 +3,11 @@
 
 use std::{path::PathBuf, sync::Arc};
 
+use cxx_rust_cssparser_impl::atom::Atom;
 use cxx_rust_cssparser_impl::parseerror::{ParseError, ParseErrorKind, SourceLocation};
 use cxx_rust_cssparser_impl::stylesheet;
 use cxx_rust_cssparser_impl::{
-    property::{add_property_definition, property_definition, Property, PropertyDefinition},
+    property::{add_property_definition, property_definition, Property, PropertyDefinition, PropertyRegistry},
     selector::*,
     stylerule::StyleRule,
     stylesheet::StyleSheet,
@@ -33,7 +34,9 @@ fn minimal() {
             selector: Selector::from_parts(&[
                 SelectorPart::new_with_value(SelectorKind::Type, Value::from("test")),
             ]),
-            properties: Vec::new(),
+            specificity: Specificity { ids: 0, classes: 0, types: 1 },
+            source_order: 0,
+            properties: Vec::new().into(),
         }
     ]));
 }
@@ -55,15 +58,17 @@ fn property_registration() {
                 selector: Selector::from_parts(&[
                     SelectorPart::new_with_value(SelectorKind::Type, Value::from("example"))
                 ]),
+                specificity: Specificity { ids: 0, classes: 0, types: 1 },
+                source_order: 0,
                 properties: vec![
                     Property {
-                        name: String::from("test"),
+                        name: Atom::from("test"),
                         definition: property_definition.clone(),
                         values: Vec::from([
                             Value::from(Color::rgba(255, 0, 0, 255))
                         ])
                     }
-                ],
+                ].into(),
             }
         ]
     );
@@ -99,21 +104,25 @@ fn custom_properties() {
                 selector: Selector::from_parts(&[
                     SelectorPart::new_with_empty(SelectorKind::DocumentRoot),
                 ]),
-                properties: Vec::new(),
+                specificity: Specificity { ids: 0, classes: 1, types: 0 },
+                source_order: 0,
+                properties: Vec::new().into(),
             },
             StyleRule {
                 selector: Selector::from_parts(&[
                     SelectorPart::new_with_value(SelectorKind::Type, Value::from("example")),
                 ]),
+                specificity: Specificity { ids: 0, classes: 0, types: 1 },
+                source_order: 1,
                 properties: vec![
                     Property {
-                        name: String::from("test"),
+                        name: Atom::from("test"),
                         definition: property_definition("test").unwrap().clone(),
                         values: vec![
                             Value::from(Color::rgba(255, 0, 0, 255))
                         ]
                     }
-                ]
+                ].into()
             }
         ]
     );
@@ -141,15 +150,17 @@ fn nested_block() {
             selector: Selector::from_parts(&[
                 SelectorPart::new_with_value(SelectorKind::Type, Value::from("example"))
             ]),
+            specificity: Specificity { ids: 0, classes: 0, types: 1 },
+            source_order: 0,
             properties: Vec::from([
                 Property {
-                    name: String::from("test"),
+                    name: Atom::from("test"),
                     definition: property_definition.clone(),
                     values: Vec::from([
                         Value::from(Color::rgba(255, 0, 0, 255))
                     ]),
                 }
-            ]),
+            ]).into(),
         },
         StyleRule {
             selector: Selector::from_parts(&[
@@ -157,15 +168,17 @@ fn nested_block() {
                 SelectorPart::new_with_empty(SelectorKind::DescendantCombinator),
                 SelectorPart::new_with_value(SelectorKind::Type, Value::from("nested")),
             ]),
+            specificity: Specificity { ids: 0, classes: 0, types: 2 },
+            source_order: 1,
             properties: Vec::from([
                 Property {
-                    name: String::from("test"),
+                    name: Atom::from("test"),
                     definition: property_definition.clone(),
                     values: Vec::from([
                         Value::from(Color::rgba(0, 0, 255, 255))
                     ]),
                 }
-            ]),
+            ]).into(),
         },
     ]);
 
@@ -189,6 +202,59 @@ fn nested_block() {
     assert_eq!(rules, &expected);
 }
 
+#[test]
+fn nested_selector_list() {
+    setup();
+
+    let mut stylesheet = StyleSheet::new(PathBuf::new());
+    let result = stylesheet.parse_string(
+        "a, b {
+            test: red;
+
+            & c, & d {
+                test: blue;
+
+                & e {
+                    test: green;
+                }
+            }
+        }");
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+
+    let selector = |names: &[&str]| {
+        let mut parts = Vec::new();
+        for (index, name) in names.iter().enumerate() {
+            if index > 0 {
+                parts.push(SelectorPart::new_with_empty(SelectorKind::DescendantCombinator));
+            }
+            parts.push(SelectorPart::new_with_value(SelectorKind::Type, Value::from(*name)));
+        }
+        Selector::from_parts(&parts)
+    };
+
+    let expected = [
+        (selector(&["a"]), Color::rgba(255, 0, 0, 255)),
+        (selector(&["a", "c"]), Color::rgba(0, 0, 255, 255)),
+        (selector(&["a", "c", "e"]), Color::rgba(0, 128, 0, 255)),
+        (selector(&["a", "d"]), Color::rgba(0, 0, 255, 255)),
+        (selector(&["a", "d", "e"]), Color::rgba(0, 128, 0, 255)),
+        (selector(&["b"]), Color::rgba(255, 0, 0, 255)),
+        (selector(&["b", "c"]), Color::rgba(0, 0, 255, 255)),
+        (selector(&["b", "c", "e"]), Color::rgba(0, 128, 0, 255)),
+        (selector(&["b", "d"]), Color::rgba(0, 0, 255, 255)),
+        (selector(&["b", "d", "e"]), Color::rgba(0, 128, 0, 255)),
+    ];
+
+    let rules = &stylesheet.rules;
+    assert_eq!(rules.len(), expected.len());
+    for (index, (rule, (selector, color))) in rules.iter().zip(expected.iter()).enumerate() {
+        assert_eq!(&rule.selector, selector);
+        assert_eq!(rule.specificity, selector.specificity());
+        assert_eq!(rule.source_order, index);
+        assert_eq!(rule.properties[0].values, vec![Value::from(color.clone())]);
+    }
+}
+
 #[test]
 fn complex() {
     let path = PathBuf::from(concat!(env!("CARGO_MANIFEST_DIR"), "/tests/data/complex.css"));
@@ -210,14 +276,7 @@ fn complex() {
         ]),
         Selector::from_parts(&[
             SelectorPart::new_with_value(SelectorKind::Type, Value::from("button")),
-            SelectorPart {
-                kind: SelectorKind::Attribute,
-                value: SelectorValue::Attribute {
-                    name: String::from("display"),
-                             operator: AttributeOperator::Equals,
-                             value: Value::from("something"),
-                }
-            },
+            SelectorPart::new_with_attribute(String::from("display"), AttributeOperator::Equals, Value::from("something")),
         ]),
         Selector::from_parts(&[
             SelectorPart::new_with_value(SelectorKind::Type, Value::from("toolbutton")),
@@ -228,14 +287,7 @@ fn complex() {
         ]),
         Selector::from_parts(&[
             SelectorPart::new_with_value(SelectorKind::Type, Value::from("toolbutton")),
-            SelectorPart {
-                kind: SelectorKind::Attribute,
-                value: SelectorValue::Attribute {
-                    name: String::from("display"),
-                    operator: AttributeOperator::Equals,
-                    value: Value::from("something"),
-                }
-            },
+            SelectorPart::new_with_attribute(String::from("display"), AttributeOperator::Equals, Value::from("something")),
         ]),
         Selector::from_parts(&[
             SelectorPart::new_with_value(SelectorKind::Type, Value::from("button")),
@@ -261,22 +313,22 @@ fn complex() {
 
     let expected_properties = vec![
         Property {
-            name: String::from("width"),
+            name: Atom::from("width"),
             definition: property_definition("width").unwrap(),
             values: vec![Value::from(Dimension{value: 32.0, unit: Unit::Px})],
         },
         Property {
-            name: String::from("height"),
+            name: Atom::from("height"),
             definition: property_definition("height").unwrap(),
             values: vec![Value::from(Dimension{value: 32.0, unit: Unit::Px})],
         },
         Property {
-            name: String::from("color"),
+            name: Atom::from("color"),
             definition: property_definition("color").unwrap(),
             values: vec![Value::from(Color::rgba(255, 0, 0, 255))]
         },
         Property {
-            name: String::from("padding"),
+            name: Atom::from("padding"),
             definition: property_definition("padding").unwrap(),
             values: vec![
                 Value::from(Dimension{value: 4.0, unit: Unit::Px}),
@@ -286,21 +338,21 @@ fn complex() {
             ]
         },
         Property {
-            name: String::from("padding-top"),
+            name: Atom::from("padding-top"),
             definition: property_definition("padding-top").unwrap(),
             values: vec![
                 Value::from(Dimension{value: 2.0, unit: Unit::Rem}),
             ]
         },
         Property {
-            name: String::from("background-image"),
+            name: Atom::from("background-image"),
             definition: property_definition("background-image").unwrap(),
             values: vec![
                 Value::new_url(path.parent().unwrap().join("background.svg").to_string_lossy().as_ref()),
             ]
         }
     ];
-    let properties: Vec<Property> = rules.first().unwrap().properties.clone();
+    let properties: Vec<Property> = rules.first().unwrap().properties.to_vec();
     assert_eq!(properties, expected_properties);
 }
 
@@ -315,6 +367,96 @@ fn import() {
 
     let rules = stylesheet.all_rules();
     assert_eq!(rules.len(), 4);
+
+    assert_eq!(stylesheet.rule_count(), rules.len());
+    for (index, rule) in rules.iter().enumerate() {
+        assert_eq!(stylesheet.rule(index), Some(rule));
+    }
+    assert_eq!(stylesheet.rule(rules.len()), None);
+}
+
+#[test]
+fn cascade_order() {
+    setup();
+
+    let mut stylesheet = StyleSheet::new(PathBuf::from(concat!(env!("CARGO_MANIFEST_DIR"), "/tests/data/import.css")));
+    assert!(stylesheet.parse().is_ok());
+
+    let result = stylesheet.parse_string("
+        #id { test: red; }
+        example.class { test: red; }
+        example { test: red; nested:hovered { test: blue; } }
+    ");
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+
+    let rules = stylesheet.all_rules();
+    assert_eq!(rules.len(), 8);
+    for (index, rule) in rules.iter().enumerate() {
+        assert_eq!(rule.source_order, index);
+        assert_eq!(rule.specificity, rule.selector.specificity());
+    }
+
+    assert_eq!(rules[7].specificity, Specificity { ids: 0, classes: 1, types: 2 });
+
+    let order = stylesheet.cascade_order();
+    assert_eq!(order.len(), rules.len());
+    assert_eq!(&order[order.len() - 3..], &[5, 7, 4]);
+    for pair in order.windows(2) {
+        let (first, second) = (&rules[pair[0]], &rules[pair[1]]);
+        assert!((first.specificity, first.source_order) < (second.specificity, second.source_order));
+    }
+}
+
+#[test]
+fn parallel_imports() {
+    let path = PathBuf::from(concat!(env!("CARGO_MANIFEST_DIR"), "/tests/data/import.css"));
+
+    let mut serial = StyleSheet::new(path.clone());
+    assert!(serial.parse().is_ok());
+
+    let mut parallel = StyleSheet::new(path.clone());
+    parallel.set_parallel_imports(true);
+
+    let result = parallel.parse();
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+
+    assert_eq!(parallel.imported_sheets.len(), 2);
+    assert_eq!(parallel.all_rules(), serial.all_rules());
+    assert_eq!(parallel.all_errors(), serial.all_errors());
+    assert_eq!(parallel.all_paths(), serial.all_paths());
+}
+
+#[test]
+fn checkpoints() {
+    setup();
+
+    let mut stylesheet = StyleSheet::new(PathBuf::from(concat!(env!("CARGO_MANIFEST_DIR"), "/tests/data/import.css")));
+    let start = stylesheet.checkpoint();
+
+    let result = stylesheet.parse();
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+
+    let imported = stylesheet.checkpoint();
+    assert_eq!(stylesheet.rules_since(start).len(), 4);
+    assert_eq!(stylesheet.rules_since(imported), vec![]);
+
+    let result = stylesheet.parse_string("example { test: red; }");
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+
+    let rules = stylesheet.rules_since(imported);
+    assert_eq!(rules.len(), 1);
+    assert_eq!(rules[0].selector, Selector::from_parts(&[
+        SelectorPart::new_with_value(SelectorKind::Type, Value::from("example")),
+    ]));
+    assert_eq!(stylesheet.all_rules().len(), 5);
+    assert_eq!(stylesheet.all_rules().last(), rules.last());
+
+    let parsed = stylesheet.checkpoint();
+    let result = stylesheet.parse_string("example { unknown-property: somevalue; }");
+    assert!(result.is_ok());
+    assert_eq!(stylesheet.rules_since(parsed), vec![]);
+    assert_eq!(stylesheet.errors_since(parsed).len(), 1);
+    assert_eq!(stylesheet.errors_since(start).len(), 1);
 }
 
 #[test]
@@ -327,7 +469,7 @@ fn errors() {
     assert_eq!(stylesheet.errors, vec![
         ParseError {
             kind: ParseErrorKind::UnexpectedEndOfInput,
-            message: String::new(),
+            message: "".into(),
             location: SourceLocation {
                 file: String::new(),
                 line: 1,
@@ -342,7 +484,7 @@ fn errors() {
     assert_eq!(stylesheet.errors, vec![
         ParseError {
             kind: ParseErrorKind::UnknownProperty,
-            message: String::from("No definition for property unknown-property"),
+            message: "No definition for property unknown-property".into(),
             location: SourceLocation {
                 file: String::new(),
                 line: 1,
@@ -357,7 +499,7 @@ fn errors() {
     assert_eq!(stylesheet.errors, vec![
         ParseError {
             kind: ParseErrorKind::InvalidPropertyValue,
-            message: String::from("Parsing values for property test failed: Expected Color, got Url(somevalue)"),
+            message: "Parsing values for property test failed: Expected Color, got Url(somevalue)".into(),
             location: SourceLocation {
                 file: String::new(),
                 line: 1,
@@ -372,7 +514,7 @@ fn errors() {
     assert_eq!(stylesheet.errors, vec![
         ParseError {
             kind: ParseErrorKind::InvalidSelectors,
-            message: String::from("Invalid Selectors: Dangling Combinator"),
+            message: "Invalid Selectors: Dangling Combinator".into(),
             location: SourceLocation {
                 file: String::new(),
                 line: 1,
@@ -385,7 +527,7 @@ fn errors() {
     let file_errors = vec![
         ParseError {
             kind: ParseErrorKind::UnknownProperty,
-            message: String::from("No definition for property unknown-property"),
+            message: "No definition for property unknown-property".into(),
             location: SourceLocation {
                 file: path.to_string_lossy().to_string(),
                 line: 38,
@@ -394,7 +536,7 @@ fn errors() {
         },
         ParseError {
             kind: ParseErrorKind::InvalidSelectors,
-            message: String::from("Invalid Selectors: Dangling Combinator"),
+            message: "Invalid Selectors: Dangling Combinator".into(),
             location: SourceLocation {
                 file: path.to_string_lossy().to_string(),
                 line: 41,
@@ -403,7 +545,7 @@ fn errors() {
         },
         ParseError {
             kind: ParseErrorKind::InvalidPropertyValue,
-            message: String::from("Parsing values for property padding-top failed: Expected Length, got String(value)"),
+            message: "Parsing values for property padding-top failed: Expected Length, got String(value)".into(),
             location: SourceLocation {
                 file: path.to_string_lossy().to_string(),
                 line: 46,
@@ -426,3 +568,524 @@ fn errors() {
     assert_eq!(stylesheet.errors, vec![]);
     assert_eq!(stylesheet.all_errors(), file_errors);
 }
+
+#[test]
+fn duplicate_definition() {
+    let first = Arc::new(PropertyDefinition::from_name_syntax("duplicate-test", "<color>", "Test Input", 0, 0).unwrap());
+    let second = Arc::new(PropertyDefinition::from_name_syntax("duplicate-test", "<length>", "Test Input", 0, 0).unwrap());
+
+    assert!(add_property_definition(&first));
+    assert!(!add_property_definition(&second));
+    assert_eq!(property_definition("duplicate-test"), Some(first));
+}
+
+#[test]
+fn scoped_registry() {
+    let base = PropertyRegistry::new();
+    assert!(base.add(&Arc::new(PropertyDefinition::from_name_syntax("scoped-base", "<color>", "Test Input", 0, 0).unwrap())));
+
+    let registry = PropertyRegistry::new_with_parent(&base);
+    let mut stylesheet = StyleSheet::new_with_registry(PathBuf::new(), &registry);
+
+    let result = stylesheet.parse_string("
+        @property scoped-test {
+            syntax: \"<length>\";
+            inherits: false;
+        }
+
+        test {
+            scoped-base: red;
+            scoped-test: 5px;
+        }
+    ");
+    assert!(result.is_ok());
+    assert_eq!(stylesheet.errors, vec![]);
+    assert_eq!(stylesheet.rules.len(), 1);
+    assert_eq!(stylesheet.rules[0].properties.len(), 2);
+
+    assert!(registry.get("scoped-test").is_some());
+    assert!(registry.get("scoped-base").is_some());
+    assert!(base.get("scoped-test").is_none());
+    assert!(property_definition("scoped-test").is_none());
+    assert!(property_definition("scoped-base").is_none());
+
+    // Definitions in a parent registry cannot be replaced.
+    assert!(!registry.add(&Arc::new(PropertyDefinition::from_name_syntax("scoped-base", "<length>", "Test Input", 0, 0).unwrap())));
+}
+
+#[test]
+fn cache() {
+    let path = PathBuf::from(concat!(env!("CARGO_MANIFEST_DIR"), "/tests/data/import.css"));
+    let cache_dir = std::env::temp_dir().join(format!("cxx-rust-cssparser-cache-{}", std::process::id()));
+
+    let mut parsed = StyleSheet::new_with_registry(path.clone(), &PropertyRegistry::new());
+    let result = parsed.parse_cached(&cache_dir);
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+    assert_eq!(std::fs::read_dir(&cache_dir).unwrap().count(), 1);
+
+    let registry = PropertyRegistry::new();
+    let mut cached = StyleSheet::new_with_registry(path.clone(), &registry);
+    assert!(cached.parse_cached(&cache_dir).is_ok());
+
+    assert_eq!(cached.all_rules(), parsed.all_rules());
+    assert_eq!(cached.all_errors(), parsed.all_errors());
+    assert_eq!(cached.all_paths(), parsed.all_paths());
+    assert_eq!(cached.imported_sheets[0].defined_properties(), parsed.imported_sheets[0].defined_properties());
+
+    // Definitions from the cached sheets are available to later parses.
+    assert!(registry.get("width").is_some());
+
+    std::fs::remove_dir_all(&cache_dir).unwrap();
+}
+
+#[test]
+fn resolve_colors() {
+    setup();
+
+    let mut stylesheet = StyleSheet::new(PathBuf::new());
+    let result = stylesheet.parse_string("
+        a { test: mix(black, white, 0.5); }
+        b { test: modify-color(black add rgb(10, 20, 30)); }
+        c { test: custom-color('palette', 'window'); }
+    ");
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+
+    let original = stylesheet.all_rules();
+    stylesheet.resolve_colors();
+    let rules = stylesheet.all_rules();
+
+    assert_eq!(rules[0].properties[0].values, vec![Value::from(Color::rgba(128, 128, 128, 255))]);
+    assert_eq!(rules[1].properties[0].values, vec![Value::from(Color::rgba(10, 20, 30, 255))]);
+    assert_eq!(rules[2].properties[0].values, original[2].properties[0].values);
+}
+
+#[test]
+fn custom_colors() {
+    setup();
+
+    let mut stylesheet = StyleSheet::new(PathBuf::new());
+    let result = stylesheet.parse_string("
+        a { test: custom-color('palette', 'window'); }
+        b { test: custom-color('palette', 'text'); }
+        c { test: modify-color(custom-color('palette', 'window') add black); }
+        d { test: custom-color('accent', 'primary'); }
+    ");
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+
+    assert_eq!(stylesheet.custom_colors(), vec![
+        (String::from("palette"), vec![String::from("window")]),
+        (String::from("palette"), vec![String::from("text")]),
+        (String::from("accent"), vec![String::from("primary")]),
+    ]);
+}
+
+#[test]
+fn parse_with_visitor() {
+    let path = PathBuf::from(concat!(env!("CARGO_MANIFEST_DIR"), "/tests/data/import.css"));
+
+    let mut expected = StyleSheet::new(path.clone());
+    assert!(expected.parse().is_ok());
+
+    let mut stylesheet = StyleSheet::new(path);
+    let mut visited = Vec::new();
+    let result = stylesheet.parse_with_visitor(&mut |rule| visited.push(rule.clone()));
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+
+    // Visited rules are the same as the stored rules of a normal parse, but
+    // are not stored themselves.
+    assert_eq!(visited, expected.all_rules());
+    assert_eq!(stylesheet.rule_count(), 0);
+    assert_eq!(stylesheet.all_paths(), expected.all_paths());
+
+    let mut visited = Vec::new();
+    let result = stylesheet.parse_string_with_visitor("test { } test2 { }", &mut |rule| visited.push(rule.source_order));
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+    assert_eq!(visited, vec![4, 5]);
+    assert_eq!(stylesheet.rule_count(), 0);
+}
+
+#[test]
+fn reload() {
+    setup();
+
+    let directory = std::env::temp_dir().join(format!("cxx-rust-cssparser-reload-{}", std::process::id()));
+    std::fs::create_dir_all(&directory).unwrap();
+    std::fs::write(directory.join("main.css"), "@import \"a.css\"; @import \"b.css\"; main { test: red; }").unwrap();
+    std::fs::write(directory.join("a.css"), "a1 { test: red; } a2 { test: red; }").unwrap();
+    std::fs::write(directory.join("b.css"), "b { test: red; }").unwrap();
+
+    let mut stylesheet = StyleSheet::new(directory.join("main.css"));
+    let result = stylesheet.parse();
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+    assert_eq!(stylesheet.rule_count(), 4);
+    assert!(stylesheet.all_modified_paths().is_empty());
+
+    std::fs::write(directory.join("a.css"), "a { test: blue; }").unwrap();
+    assert_eq!(stylesheet.all_modified_paths(), vec![directory.join("a.css")]);
+
+    let reloaded = stylesheet.reload_modified().unwrap();
+    assert_eq!(reloaded, vec![stylesheet::ReloadedRules { start: 0, removed: 2, added: 1 }]);
+    assert!(stylesheet.all_modified_paths().is_empty());
+
+    // The result is the same as parsing everything again.
+    let mut expected = StyleSheet::new(directory.join("main.css"));
+    assert!(expected.parse().is_ok());
+    assert_eq!(stylesheet.all_rules(), expected.all_rules());
+    assert_eq!(stylesheet.all_paths(), expected.all_paths());
+
+    assert_eq!(stylesheet.reload(&directory.join("b.css")).unwrap(), vec![stylesheet::ReloadedRules { start: 1, removed: 1, added: 1 }]);
+    assert!(stylesheet.reload(&directory.join("unknown.css")).unwrap().is_empty());
+
+    std::fs::remove_dir_all(&directory).unwrap();
+}
+
+#[test]
+fn parse_options() {
+    setup();
+
+    let parse = |options: stylesheet::ParseOptions, input: &str| {
+        let mut stylesheet = StyleSheet::new(PathBuf::new());
+        stylesheet.set_parse_options(options);
+        let result = stylesheet.parse_string(input);
+        (stylesheet, result)
+    };
+
+    let input = "a { unknown: red; } b { test: red; } c { unknown: red; } d { unknown: red; } e { test: red; }";
+
+    let (stylesheet, result) = parse(stylesheet::ParseOptions::default(), input);
+    assert!(result.is_ok());
+    assert_eq!(stylesheet.rule_count(), 2);
+    assert_eq!(stylesheet.all_errors().len(), 3);
+
+    let (stylesheet, result) = parse(stylesheet::ParseOptions { max_errors: Some(2), ..Default::default() }, input);
+    assert_eq!(result.unwrap_err().kind, ParseErrorKind::LimitExceeded);
+    assert_eq!(stylesheet.rule_count(), 1);
+    assert_eq!(stylesheet.all_errors().len(), 2);
+
+    let (stylesheet, result) = parse(stylesheet::ParseOptions { stop_at_first_error: true, ..Default::default() }, input);
+    assert_eq!(result.unwrap_err().kind, ParseErrorKind::UnknownProperty);
+    assert_eq!(stylesheet.rule_count(), 0);
+    assert!(stylesheet.all_errors().is_empty());
+
+    let (stylesheet, result) = parse(stylesheet::ParseOptions { max_rules: Some(1), ..Default::default() }, "a { test: red; } b { test: red; } c { test: red; }");
+    assert_eq!(result.unwrap_err().kind, ParseErrorKind::LimitExceeded);
+    assert_eq!(stylesheet.rule_count(), 1);
+
+    let (stylesheet, result) = parse(stylesheet::ParseOptions { max_input_size: Some(8), ..Default::default() }, input);
+    assert_eq!(result.unwrap_err().kind, ParseErrorKind::LimitExceeded);
+    assert_eq!(stylesheet.rule_count(), 0);
+
+    // Rules that are nested too deep are discarded, but parsing continues.
+    let (stylesheet, result) = parse(stylesheet::ParseOptions { max_nesting_depth: Some(2), ..Default::default() },
+                                     "a { test: red; & b { test: red; } } c { & d { & e { test: red; } } } f { test: red; }");
+    assert!(result.is_ok());
+    assert_eq!(stylesheet.rule_count(), 3);
+    assert_eq!(stylesheet.all_errors().len(), 1);
+    assert_eq!(stylesheet.all_errors()[0].kind, ParseErrorKind::LimitExceeded);
+}
+
+#[test]
+fn parse_options_imports() {
+    setup();
+
+    let directory = std::env::temp_dir().join(format!("cxx-rust-cssparser-limits-{}", std::process::id()));
+    std::fs::create_dir_all(&directory).unwrap();
+    std::fs::write(directory.join("main.css"), "@import \"a.css\"; @import \"b.css\"; main { test: red; }").unwrap();
+    std::fs::write(directory.join("a.css"), "a1 { test: red; } a2 { test: red; }").unwrap();
+    std::fs::write(directory.join("b.css"), "b1 { test: red; } b2 { test: red; }").unwrap();
+
+    // The limits apply to all files together, what was parsed before the
+    // limit was exceeded is kept.
+    let mut stylesheet = StyleSheet::new(directory.join("main.css"));
+    stylesheet.set_parse_options(stylesheet::ParseOptions { max_rules: Some(3), ..Default::default() });
+    let result = stylesheet.parse();
+    assert_eq!(result.unwrap_err().kind, ParseErrorKind::LimitExceeded);
+    assert_eq!(stylesheet.rule_count(), 3);
+    assert_eq!(stylesheet.all_paths().len(), 3);
+
+    std::fs::remove_dir_all(&directory).unwrap();
+}
+
+#[test]
+fn cancellation() {
+    setup();
+
+    let cancellation = stylesheet::Cancellation::new();
+    let mut stylesheet = StyleSheet::new(PathBuf::new());
+    stylesheet.set_parse_options(stylesheet::ParseOptions { cancellation: Some(cancellation.clone()), ..Default::default() });
+
+    assert!(stylesheet.parse_string("a { test: red; }").is_ok());
+    assert_eq!(stylesheet.rule_count(), 1);
+
+    cancellation.cancel();
+    let result = stylesheet.parse_string("b { test: red; } c { test: red; }");
+    assert_eq!(result.unwrap_err().kind, ParseErrorKind::Cancelled);
+    assert_eq!(stylesheet.rule_count(), 1);
+}
+
+#[test]
+fn statistics() {
+    setup();
+
+    let input = "a, b > c { test: red; unknown: red; } d { test: blue; & e { test: red; } }";
+
+    let mut stylesheet = StyleSheet::new(PathBuf::new());
+    assert!(stylesheet.parse_string(input).is_ok());
+    assert!(stylesheet.statistics().is_empty());
+
+    let mut stylesheet = StyleSheet::new(PathBuf::new());
+    stylesheet.set_parse_options(stylesheet::ParseOptions { collect_statistics: true, ..Default::default() });
+    assert!(stylesheet.parse_string(input).is_ok());
+
+    let statistics = stylesheet.statistics();
+    assert_eq!(statistics.len(), 1);
+    assert_eq!(statistics[0].bytes, input.len());
+    // The first rule fails because of the unknown property.
+    assert_eq!(statistics[0].rules, 2);
+    assert_eq!(statistics[0].declarations, 3);
+    assert_eq!(statistics[0].registry_lookups, 4);
+    assert_eq!(statistics[0].registry_hits, 3);
+    assert!(statistics[0].parse >= statistics[0].values);
+}
+
+#[test]
+fn parse_threads() {
+    let mut input = String::from("@property chunk-width {\n    syntax: \"<length>\";\n    inherits: false;\n}\n\n");
+    for index in 0..3000 {
+        match index {
+            // The first use of an unknown custom property defines it, which
+            // changes how the same property is parsed further on.
+            100 => input.push_str("first { --chunk-color: red; }\n"),
+            2500 => input.push_str("second { --chunk-color: blue; }\n"),
+            _ if index % 500 == 7 => input.push_str(&format!(".invalid-{} {{ unknown: {}px; }}\n", index, index)),
+            _ => input.push_str(&format!(".rule-{} > child {{ chunk-width: {}px; }}\n", index, index)),
+        }
+    }
+    // Rules are only split at line breaks.
+    input.push_str("last { chunk-width: 1px; } last { chunk-width: 2px; }\n");
+
+    let parse = |threads| {
+        let mut stylesheet = StyleSheet::new_with_registry(PathBuf::new(), &PropertyRegistry::new());
+        stylesheet.set_parse_threads(threads);
+        let result = stylesheet.parse_string(&input);
+        assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+        stylesheet
+    };
+
+    let serial = parse(1);
+    let parallel = parse(4);
+
+    assert!(serial.rules.len() > 2900);
+    assert_eq!(serial.errors.len(), 6);
+    assert_eq!(parallel.rules, serial.rules);
+    assert_eq!(parallel.errors, serial.errors);
+    assert_eq!(parallel.defined_properties(), serial.defined_properties());
+    assert_eq!(parallel.registry().get("--chunk-color"), serial.registry().get("--chunk-color"));
+}
+
+#[test]
+fn parse_threads_after_cdo() {
+    let mut input = String::from("<!--\n@import \"import_values.css\";\n-->\n");
+    for index in 0..3000 {
+        input.push_str(&format!(".rule-{} > child {{ width: {}px; }}\n", index, index));
+    }
+
+    let parse = |threads| {
+        let mut stylesheet = StyleSheet::new_with_registry(PathBuf::from(concat!(env!("CARGO_MANIFEST_DIR"), "/tests/data/cdo.css")), &PropertyRegistry::new());
+        stylesheet.set_parse_threads(threads);
+        let result = stylesheet.parse_string(&input);
+        assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+        stylesheet
+    };
+
+    let serial = parse(1);
+    let parallel = parse(4);
+
+    assert_eq!(serial.imported_sheets.len(), 1);
+    assert_eq!(parallel.imported_sheets.len(), 1);
+    assert_eq!(parallel.all_rules(), serial.all_rules());
+    assert_eq!(parallel.errors, serial.errors);
+}
+
+#[test]
+fn property_blocks() {
+    setup();
+
+    let mut stylesheet = StyleSheet::new(PathBuf::new());
+    let result = stylesheet.parse_string("a, b { test: red; } c { test: red; } d { test: blue; } e { }");
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+
+    let rules = &stylesheet.rules;
+    assert_eq!(rules.len(), 5);
+    // Rules with the same properties share a block.
+    assert!(rules[0].properties.ptr_eq(&rules[1].properties));
+    assert!(rules[0].properties.ptr_eq(&rules[2].properties));
+    assert!(!rules[0].properties.ptr_eq(&rules[3].properties));
+    assert_eq!(rules[0].properties.id(), rules[2].properties.id());
+    assert_ne!(rules[0].properties.id(), rules[3].properties.id());
+    assert_ne!(rules[3].properties.id(), rules[4].properties.id());
+
+    // Equal blocks from another parse are not shared, so their ids differ.
+    let mut other = StyleSheet::new(PathBuf::new());
+    assert!(other.parse_string("other { test: blue; }").is_ok());
+    assert!(!other.rules[0].properties.ptr_eq(&rules[3].properties));
+    assert_ne!(other.rules[0].properties.id(), rules[3].properties.id());
+    assert_eq!(other.rules[0].properties, rules[3].properties);
+}
+
+#[test]
+fn canonicalize_units() {
+    let input = "@property canonical-length { syntax: \"<length>+\"; inherits: false; } a { canonical-length: 12pt 96px 2em; }";
+
+    let mut stylesheet = StyleSheet::new(PathBuf::new());
+    assert!(stylesheet.parse_string(input).is_ok());
+    assert_eq!(stylesheet.rules[0].properties[0].values, vec![
+        Value::from(Dimension{value: 12.0, unit: Unit::Pt}),
+        Value::from(Dimension::px(96.0)),
+        Value::from(Dimension{value: 2.0, unit: Unit::Em}),
+    ]);
+
+    let mut stylesheet = StyleSheet::new(PathBuf::new());
+    stylesheet.set_parse_options(stylesheet::ParseOptions { canonicalize_units: true, ..Default::default() });
+    assert!(stylesheet.parse_string(input).is_ok());
+    assert!(stylesheet.errors.is_empty());
+    assert_eq!(stylesheet.rules[0].properties[0].values, vec![
+        Value::from(Dimension::px(16.0)),
+        Value::from(Dimension::px(96.0)),
+        Value::from(Dimension{value: 2.0, unit: Unit::Em}),
+    ]);
+}
+
+#[test]
+fn failed_parallel_import() {
+    setup();
+
+    let directory = std::env::temp_dir().join(format!("cxx-rust-cssparser-failed-import-{}", std::process::id()));
+    std::fs::create_dir_all(&directory).unwrap();
+    std::fs::write(directory.join("b.css"), "b { test: red; }").unwrap();
+
+    let mut stylesheet = StyleSheet::new(directory.join("main.css"));
+    stylesheet.set_parallel_imports(true);
+    assert!(stylesheet.parse_string("@import \"missing.css\"; @import \"b.css\";").is_err());
+    assert_eq!(stylesheet.rule_count(), 0);
+
+    // The contents of b.css that were read before the failure are not reused.
+    std::fs::write(directory.join("b.css"), "b1 { test: red; } b2 { test: red; }").unwrap();
+    let result = stylesheet.parse_string("@import \"b.css\";");
+    assert!(result.is_ok(), "Parsing stylesheet failed with error: {}", result.err().unwrap().to_string());
+    assert_eq!(stylesheet.rule_count(), 2);
+
+    std::fs::remove_dir_all(&directory).unwrap();
+}
+
+#[test]
+fn reload_definitions() {
+    setup();
+
+    let directory = std::env::temp_dir().join(format!("cxx-rust-cssparser-reload-definitions-{}", std::process::id()));
+    std::fs::create_dir_all(&directory).unwrap();
+    std::fs::write(directory.join("main.css"), "@import \"a.css\"; @import \"a.css\"; main { test: red; }").unwrap();
+    std::fs::write(directory.join("a.css"), "@property reload-value { syntax: \"<length>\"; inherits: false; } a { reload-value: red; }").unwrap();
+
+    let registry = PropertyRegistry::new();
+    let mut stylesheet = StyleSheet::new_with_registry(directory.join("main.css"), &registry);
+    assert!(stylesheet.parse().is_ok());
+    assert_eq!(stylesheet.rule_count(), 3);
+    assert!(stylesheet.all_rules()[0].properties.is_empty());
+
+    // A changed definition replaces the one that was read before.
+    std::fs::write(directory.join("a.css"), "@property reload-value { syntax: \"<color>\"; inherits: false; } a { reload-value: red; }").unwrap();
+    assert_eq!(stylesheet.reload(&directory.join("a.css")).unwrap().len(), 2);
+    assert_eq!(stylesheet.all_rules()[0].properties.len(), 1);
+    assert!(registry.get("reload-value").is_some());
+
+    // A removed definition is removed from the registry.
+    std::fs::write(directory.join("a.css"), "@property reload-other { syntax: \"<color>\"; inherits: false; } a { reload-other: red; }").unwrap();
+    assert_eq!(stylesheet.reload(&directory.join("a.css")).unwrap().len(), 2);
+    assert!(registry.get("reload-value").is_none());
+    assert!(registry.get("reload-other").is_some());
+
+    let mut expected = StyleSheet::new_with_registry(directory.join("main.css"), &PropertyRegistry::new());
+    assert!(expected.parse().is_ok());
+    assert_eq!(stylesheet.all_rules(), expected.all_rules());
+
+    // A failed reload leaves everything as it was.
+    std::fs::write(directory.join("a.css"), "@import \"missing.css\"; @property reload-failed { syntax: \"<color>\"; inherits: false; }").unwrap();
+    assert!(stylesheet.reload(&directory.join("a.css")).is_err());
+    assert_eq!(stylesheet.all_rules(), expected.all_rules());
+    assert!(registry.get("reload-other").is_some());
+    assert!(registry.get("reload-failed").is_none());
+
+    std::fs::remove_dir_all(&directory).unwrap();
+}
+
+#[test]
+fn rules_from() {
+    setup();
+
+    let path = PathBuf::from(concat!(env!("CARGO_MANIFEST_DIR"), "/tests/data/import.css"));
+    let mut stylesheet = StyleSheet::new(path);
+    assert!(stylesheet.parse().is_ok());
+    assert!(stylesheet.parse_string("extra1 { test: red; } extra2 { test: red; }").is_ok());
+
+    let all_rules = stylesheet.all_rules();
+    for start in 0..=all_rules.len() + 1 {
+        let rules: Vec<_> = stylesheet.rules_from(start).cloned().collect();
+        assert_eq!(rules, all_rules[start.min(all_rules.len())..]);
+        assert_eq!(stylesheet.rule(start), all_rules.get(start));
+    }
+}
+
+#[test]
+fn source_order_with_late_import() {
+    setup();
+
+    let directory = std::env::temp_dir().join(format!("cxx-rust-cssparser-late-import-{}", std::process::id()));
+    std::fs::create_dir_all(&directory).unwrap();
+    std::fs::write(directory.join("main.css"), "a { test: red; } @import \"b.css\"; c { test: red; }").unwrap();
+    std::fs::write(directory.join("b.css"), "b1 { test: red; } b2 { test: red; }").unwrap();
+
+    let mut stylesheet = StyleSheet::new(directory.join("main.css"));
+    assert!(stylesheet.parse().is_ok());
+
+    let mut visiting = StyleSheet::new(directory.join("main.css"));
+    let mut visited = Vec::new();
+    assert!(visiting.parse_with_visitor(&mut |rule| visited.push(rule.clone())).is_ok());
+
+    // Both number rules in the order they appear in, which is also the order
+    // of all_rules().
+    let rules = stylesheet.all_rules();
+    assert_eq!(rules, visited);
+    assert_eq!(rules.iter().map(|rule| rule.source_order).collect::<Vec<_>>(), vec![0, 1, 2, 3]);
+
+    let mut imported = StyleSheet::new(directory.join("b.css"));
+    assert!(imported.parse().is_ok());
+    assert_eq!(rules[1].selector, imported.all_rules()[0].selector);
+
+    std::fs::remove_dir_all(&directory).unwrap();
+}
+
+#[test]
+fn append() {
+    setup();
+
+    let path = PathBuf::from(concat!(env!("CARGO_MANIFEST_DIR"), "/tests/data/import.css"));
+
+    let mut expected = StyleSheet::new(path.clone());
+    assert!(expected.parse_string("first { test: red; }").is_ok());
+    assert!(expected.parse().is_ok());
+
+    let mut stylesheet = StyleSheet::new(path);
+    assert!(stylesheet.parse_string("first { test: red; }").is_ok());
+    let checkpoint = stylesheet.checkpoint();
+
+    let mut copy = stylesheet.empty_copy();
+    assert!(copy.parse().is_ok());
+    stylesheet.append(copy);
+
+    assert_eq!(stylesheet.all_rules(), expected.all_rules());
+    assert_eq!(stylesheet.all_errors(), expected.all_errors());
+    assert_eq!(stylesheet.all_paths(), expected.all_paths());
+    assert_eq!(stylesheet.rules_since(checkpoint).len(), 4);
+    assert!(stylesheet.all_modified_paths().is_empty());
+}